@@ -2,7 +2,8 @@
 	Think-Like-A-Vertex Framework, Vertex,cpp
 	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
 
-	Implementation of some of the generic Vertex functions
+	Implementation of some of the generic Vertex functions,
+	instantiated for the value types of the programs
 
 	This software is distributed under 
 	the modified Berkeley Software Distribution (BSD) License.
@@ -10,25 +11,42 @@
 
 #include "gpregellib.h"
 
-Vertex::Vertex() { }
+template<typename V>
+VertexBase<V>::VertexBase() { }
 
 /*
 	implementation of get and set methods
 */
-int Vertex::get_id() { return id; }
-void Vertex::set_id(int i) { id = i; }
-
-int Vertex::get_value() {	return value; }
-void Vertex::set_value(int i) { value = i; }
-
-int* Vertex::get_neighborstart() { return neighbor_start; }
-void Vertex::set_neighborstart(int* ns) { neighbor_start = ns; }
-
-int* Vertex::get_weightstart() { return weight_start; }
-void Vertex::set_weightstart(int* ws) { weight_start = ws; }
-
-int Vertex::get_degree() { return degree; }
-void Vertex::set_degree(int i) { degree = i; }
-
-bool Vertex::get_active() { return active; }
-void Vertex::set_active(bool act) {	active = act; }
+template<typename V>
+int VertexBase<V>::get_id() { return id; }
+template<typename V>
+void VertexBase<V>::set_id(int i) { id = i; }
+
+template<typename V>
+V VertexBase<V>::get_value() {	return value; }
+template<typename V>
+void VertexBase<V>::set_value(V i) { value = i; }
+
+template<typename V>
+int* VertexBase<V>::get_neighborstart() { return neighbor_start; }
+template<typename V>
+void VertexBase<V>::set_neighborstart(int* ns) { neighbor_start = ns; }
+
+template<typename V>
+int* VertexBase<V>::get_weightstart() { return weight_start; }
+template<typename V>
+void VertexBase<V>::set_weightstart(int* ws) { weight_start = ws; }
+
+template<typename V>
+int VertexBase<V>::get_degree() { return degree; }
+template<typename V>
+void VertexBase<V>::set_degree(int i) { degree = i; }
+
+template<typename V>
+bool VertexBase<V>::get_active() { return active; }
+template<typename V>
+void VertexBase<V>::set_active(bool act) {	active = act; }
+
+// the value types of the programs
+template class VertexBase<int>;
+template class VertexBase<float>;
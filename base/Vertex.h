@@ -5,6 +5,10 @@
 	Header class for a vertex and its function,
 	each Vertex must implement 2 virtual functions	
 
+	The base is templated on the type of the vertex values
+	and messages.  Vertex is the base of the int programs,
+	the others derive from VertexBase of their own type
+
 	This software is distributed under 
 	the modified Berkeley Software Distribution (BSD) License.
 */
@@ -13,10 +17,32 @@
 
 #include "gpregellib.h"
 
-class Vertex {
+/*
+	how a program combines the messages to a vertex, for the
+	pull supersteps.  A program that keeps the least value received,
+	and sends its own value plus nothing, one, or the edge weight,
+	declares so by hiding pull_semantics, and the Worker may then
+	gather neighbor values instead of sending messages
+*/
+enum PullSemantics { PULL_NONE, PULL_MIN, PULL_MIN_PLUS_ONE, PULL_MIN_PLUS_WEIGHT };
+
+/*
+	how the Worker combines the messages to a vertex before it
+	processes them.  With sum, a vertex processes one message per
+	superstep, the sum of every message sent to it
+*/
+enum Combiner { COMBINE_NONE, COMBINE_SUM };
+
+template<typename V>
+class VertexBase {
 
 	public:
-		Vertex();
+		VertexBase();
+
+		typedef V value_type;
+
+		static const PullSemantics pull_semantics = PULL_NONE;
+		static const Combiner combiner = COMBINE_NONE;
 
 		/*
 			A vertex type must implement these
@@ -24,14 +50,21 @@ class Vertex {
 				- how to process a message, and
 				- how to send a message
 		*/
-		virtual void process_message( Message<int>* ) = 0;
-		virtual void send_message( Message<int>*, int, int, int ) = 0;
+		virtual void process_message( Message<V>* ) = 0;
+		virtual void send_message( Message<V>*, int, int, int ) = 0;
+
+		/*
+			what an active vertex adds to the superstep's aggregate,
+			summed over the vertices that send.  A program may hide
+			it, and its Worker may halt once the sum falls low enough
+		*/
+		double get_aggregate() { return 0; }
 
 		int get_id();
 		void set_id(int);
 
-		int get_value();
-		void set_value(int);
+		V get_value();
+		void set_value(V);
 
 		int* get_neighborstart();
 		void set_neighborstart(int*);
@@ -47,7 +80,7 @@ class Vertex {
 
 	private:
 		int id;
-		int value;
+		V value;
 		int* neighbor_start;
 		int* weight_start;
 		int degree;
@@ -55,4 +88,6 @@ class Vertex {
 
 };
 
+typedef VertexBase<int> Vertex;
+
 #endif
@@ -17,33 +17,110 @@
 
 using namespace std;
 
+/*
+	levels of superstep logging, each includes the one before
+		off		nothing is logged
+		summary	the number of messages of each superstep
+		delta	the vertices whose value changed
+		full	every vertex and every outgoing message
+*/
+enum LogLevel { LOG_OFF, LOG_SUMMARY, LOG_DELTA, LOG_FULL };
+
+/*
+	how the values of a superstep reach their vertices
+		push	the frontier sends messages along its edges
+		pull	every vertex gathers the values of its frontier
+				neighbors, for programs that combine with min
+		auto	pull while the frontier is dense, else push,
+				as the Planner judges each superstep
+*/
+enum Direction { DIR_PUSH, DIR_PULL, DIR_AUTO };
+
+// columns per block of the semiring engine's SpMV, 1MB of the input vector
+#define SPMV_BLOCK_COLS (1<<18)
+
+/* the semiring a program runs over in the semiring engine */
+template<PullSemantics P> struct SemiringOf { typedef MinSelectSemiring type; };
+template<> struct SemiringOf<PULL_MIN_PLUS_ONE> { typedef BooleanSemiring type; };
+template<> struct SemiringOf<PULL_MIN_PLUS_WEIGHT> { typedef MinPlusSemiring type; };
+
 // templated Worker class
 template<typename T>
 class Worker{
 
+	// the microbenchmarks drive the superstep phases directly
+	friend class MicroBench;
+
+	// the type of the vertex values and messages
+	typedef typename T::value_type V;
+
 	// constructor and public member functions
 	public:
 		Worker(string);
-		void run();
+		Worker(string, Options);
+		virtual ~Worker();
+		// a program may extend the run, e.g. to finish its values
+		virtual void run();
 		// Two virtual functions
 		virtual void init_args(int, ...) = 0;
 		virtual void write_output(string) = 0;
 		void load_graph();
+		Metrics& get_metrics();
+		void get_values(V*);
+		Graph& get_graph();
 
 	// private member functions
 	private:
-		void write_messages();
-		void process_inbox();
-		void deliver_messages();
-
-		void init_verts();
-		void init_msg_queues();
-
+		void write_messages(int);
+		void process_inbox(int);
+		void combine_inbox(int);
+		void deliver_messages(int);
+		void end_superstep(int, bool);
+		void write_frontier(int);
+		void choose_direction(long long);
+		void snapshot_frontier(int);
+		void pull_inbox(int);
+
+		void run_spmv_partition(int);
+		void spmv_write(int);
+		void spmv_dense(int);
+		void spmv_sparse(int);
+		void run_atomic_partition(int);
+		void atomic_write(int);
+		void atomic_push(int);
+		void atomic_pull(int);
+		void record_counters(int, int, long long*, long long*);
+		void run_partition(int);
+
+		void init_partitions();
+		void init_partition(int);
+		void init_verts(int);
+		void init_msg_queues(int);
+		void rehome_csr(int);
+		void count_part_edges(int);
+		int get_partition(int);
+		void run_partitions( void (Worker<T>::*)(int) );
+		void partition_main( void (Worker<T>::*)(int), int );
+
+		bool restore_cached();
+		void store_cached();
+
+		void init_logging();
 		void log_superstep(int);
+		void log_vertices_text(bool);
+		void log_messages_text();
+		void log_superstep_binary(int);
+		void put_value(int);
+		void put_value(float);
+		void put_value32(int);
+		void put_value32(float);
 		string set_logfilename(string);
 
 	// protected member functions
 	protected:
+		void write_values(string, string, const char*);
+		void set_cache_key(string);
+
 		int* get_csr1();
 		void set_csr1(int*);
 
@@ -65,14 +142,17 @@ class Worker{
 		T* get_vert_cont();
 		void set_vert_cont(T*);
 
-		Message<int>* get_out_msgs();
-		void set_out_msgs(Message<int>*);
+		Message<V>* get_out_msgs();
+		void set_out_msgs(Message<V>*);
+
+		Message<V>* get_in_msgs();
+		void set_in_msgs(Message<V>*);
 
-		Message<int>* get_in_msgs();
-		void set_in_msgs(Message<int>*);
+		long long get_num_msgs();
+		void set_num_msgs(long long);
 
-		int get_num_msgs();
-		void set_num_msgs(int);
+		double get_aggregate();
+		void set_halt_aggregate(double);
 
 		bool get_fixed_supersteps();
 		void set_fixed_supersteps(bool);
@@ -89,6 +169,10 @@ class Worker{
 
 		// logging and writing i/o
 		bool logging;
+		int log_level;
+		bool log_binary;
+		BufferedWriter logwriter;
+		V* log_prev;
 		string logfilename;
 		string graphfile;
 		string outfile;
@@ -97,71 +181,577 @@ class Worker{
 		T* vert_cont;
 		
 		// in and output message queues
-		Message<int>* out_msgs_q;
-		Message<int>* in_msgs_q;
-		int num_messages;
+		Message<V>* out_msgs_q;
+		Message<V>* in_msgs_q;
+		long long num_messages;
+
+		/*
+			with a sum combiner, each partition adds up the messages
+			to a vertex in combined, listing the vertices it reached
+			in combine_touched.  The aggregate is the sum over the
+			vertices that sent in the last superstep, and the run
+			halts once it falls below halt_aggregate, if that is set
+		*/
+		V* combined;
+		bool* combine_seen;
+		vector<int>* combine_touched;
+		double* part_aggregate;
+		double aggregate;
+		double halt_aggregate;
+		bool halted;
+
+		/*
+			with -cache dir, the results of the runs whose program
+			set a cache key are kept in a ResultCache, keyed by the
+			content hash of the CSR, hashed at the first use
+		*/
+		bool cacheable;
+		string cache_key;
+		bool hashed;
+		uint64_t graph_hash;
 
 		int src;
 		bool fixed_supersteps;
 		int max_supersteps;
+		int superstep;
+
+		/*
+			parallel execution over vertex partitions.
+			Partition p owns vertices [part_bounds[p], part_bounds[p+1]).
+			Its messages to partition q are written into the region
+			out_msgs_q[ out_off[p*num_parts+q] ... ], and partition q
+			gathers every region addressed to it into its own inbox
+			region in_msgs_q[ in_off[q] ... ].
+			With numa, each partition is pinned to a cpu of its node
+			and first-touches its own vertices, CSR slice and queues
+		*/
+		Options opts;
+		Metrics metrics;
+		bool quiet;
+		bool numa;
+		int num_parts;
+		int* part_bounds;
+		int* part_cpu;
+		int* out_off;
+		long long* out_counts;
+		int* part_edges;
+		int* in_off;
+		long long* in_counts;
+		int* new_csr1;
+		int* new_csr2;
+		int* new_weights;
+		Barrier sync;
+
+		// the vertices and message queues, and the re-homed CSR arrays
+		Arena arena;
+		Arena csr_arena;
+
+		// per partition phase times (write, deliver, process) and work
+		double* phase_times;
+		long long* part_active;
+		long long* part_traversed;
+		double superstep_start;
+
+		// with perf, hardware counters per partition, phase and event
+		bool use_perf;
+		long long* phase_counters;
+
+		/*
+			pull supersteps.  The frontier holds the values of the
+			vertices that were active, PULL_INF for the rest, and each
+			vertex takes the least its neighbors offer into pull_best.
+			pulling is the direction of this superstep's process phase,
+			pull_next that of the next, chosen once writing
+		*/
+		int direction;
+		Planner planner;
+		bool planning;
+		bool pulling;
+		bool pull_next;
+		int* frontier;
+		int* pull_best;
+		long long* part_frontier_edges;
+		PullKernels kernels;
+
+		/*
+			the semiring engine, which runs the program as y = A x over
+			its semiring: dense steps (pull) multiply the blocked matrix
+			by the dense vector spmv_x, sparse steps (push) multiply by the
+			frontier, combining the products in spmv_y.  spmv_vals holds
+			the values of the vertices, and each partition's frontier
+			lists its vertices whose value changed.  Bfs levels count
+			up from spmv_level, the value of the first frontier
+		*/
+		bool use_spmv;
+		BlockedCsr spmv_csr;
+		int* spmv_vals;
+		int* spmv_x;
+		int* spmv_y;
+		int spmv_level;
+		vector<int>* spmv_front;
+		vector<int>* spmv_touched;
+
+		/*
+			the atomic engine, which fuses the write and process phases
+			of programs that combine with min, with no messages and no
+			message queues: each frontier vertex lowers the values of its
+			neighbors in atom_vals in place by compare-and-swap.  A vertex
+			joins the next frontier of the partition that first swaps its
+			atom_stamp to the superstep, and every superstep splits the
+			frontiers of all partitions evenly, at atom_off
+		*/
+		bool use_atomic;
+		int* atom_vals;
+		int* atom_stamp;
+		vector<int>* atom_front;
+		vector<int>* atom_next;
+		long long* atom_off;
 
 };
 
 /*
 	Worker constructor function with graph file
-	set logging default to true, and create
-	log filename with graph file.
+	logging is off by default.
 	Load the graph and initialize the message queues
 	and the opening states of vertices
 */
 template<typename T>
-Worker<T>::Worker(string infile) {
+Worker<T>::Worker(string infile) : Worker(infile, Options()) {}
+
+/*
+	Worker constructor with optional arguments:
+		-threads n	number of partitions, each run by a thread
+		-numa		pin partitions to the cpus of each numa node
+					and place their data on the local node
+		-log level	off, summary, delta or full (default off)
+		-logformat	text or binary (default text)
+		-logdir dir	directory of the log file (default log)
+		-metrics f	write per-superstep and run metrics to file f
+		-metricsformat	jsonl or csv (default jsonl)
+		-quiet		do not report each superstep
+		-perf		sample hardware counters around each phase
+		-outformat f	text (default) or binary program output
+		-direction d	push, pull or auto (default auto): programs that
+					combine with min may gather from the frontier
+					instead of sending messages; full logging pushes
+		-simd isa	scalar, avx2 or avx512 pull kernels
+					(default the widest the cpu runs)
+		-engine e	vertex, or spmv to run programs that combine
+					with min as products over their semiring;
+					-direction then picks sparse (push) or dense (pull).
+					atomic runs them without messages, each vertex
+					lowering its neighbors' values by compare-and-swap.
+					By default the Planner picks, as it picks the
+					threads when -threads and -numa are not given
+		-spmvblock n	columns per cache block of the dense product
+		-cache dir	keep results in dir, and return a stored
+					result on a rerun with the same graph and arguments
+		-cachebudget n	MB the cache directory may hold (default 1024)
+		-reader r	auto, uring or pread: how the graph file is read,
+					by io_uring or a pool of pread threads.  auto
+					(the default) uses io_uring where the kernel allows
+*/
+template<typename T>
+Worker<T>::Worker(string infile, Options _opts) {
+	opts = _opts;
 	graphfile = infile;
-	//set_logging(false);
-	set_logging(true);
-	logfilename = set_logfilename(infile);
+	log_prev = NULL;
+	quiet = opts.has("quiet");
+	use_perf = opts.has("perf");
+	cacheable = false;
+	hashed = false;
+	graph_hash = 0;
+	metrics.set_program( opts.get_string("program", "") );
+
+	double start = Metrics::now();
 	load_graph();
+	metrics.set_load_time( Metrics::now() - start );
+	metrics.set_graph( num_verts, num_edges );
+
+	// survey the graph if any choice is left to the planner
+	start = Metrics::now();
+	planning = !opts.has("engine") || ( !opts.has("threads") && !opts.has("numa") );
+	if( planning ) {
+		planner.survey( num_verts, csr1, csr2 );
+		metrics.add_field( "diameter_est", planner.get_diameter() );
+		metrics.add_field( "max_degree", planner.get_max_degree() );
+		metrics.add_field( "hub_share", planner.get_hub_share() );
+	}
+
 	//init();
-	init_msg_queues();
-	init_verts();
+	init_partitions();
+	if( planning && !quiet ) {
+		vector<string>& reasons = planner.get_reasons();
+		for(size_t i=0; i<reasons.size(); i++)
+			printf("plan: %s\n", reasons[i].c_str() );
+	}
+	run_partitions( &Worker<T>::init_partition );
+	if( use_spmv )
+		spmv_csr.build( num_verts, csr1, csr2, weights, opts.get_int("spmvblock", SPMV_BLOCK_COLS) );
+	metrics.set_init_time( Metrics::now() - start );
+	metrics.set_threads( num_parts );
+	init_logging();
 }
 
 /*
-	initialize the input and output message queues
+	Destructor, release the vertices, message queues
+	(all at once, with the arena) and partition data.
+	The graph releases the CSR arrays
+*/
+template<typename T>
+Worker<T>::~Worker() {
+
+	for(int i=0; i<num_verts; i++)
+		vert_cont[i].~T();
+	arena.release();
+
+	delete [] part_bounds;
+	delete [] part_cpu;
+	delete [] out_off;
+	delete [] out_counts;
+	delete [] part_edges;
+	delete [] in_off;
+	delete [] in_counts;
+	delete [] log_prev;
+	delete [] phase_times;
+	delete [] part_active;
+	delete [] part_traversed;
+	delete [] phase_counters;
+	delete [] part_frontier_edges;
+	delete [] spmv_front;
+	delete [] spmv_touched;
+	delete [] atom_front;
+	delete [] atom_next;
+	delete [] atom_off;
+	delete [] combine_touched;
+	delete [] part_aggregate;
+}
+
+/*
+	Divide the vertices into contiguous partitions of
+	roughly equal vertices plus edges, assign each partition a cpu,
+	and allocate (but do not touch) the message queues and vertices,
+	so each partition's thread can first-touch its own share
 */
 template<typename T>
-void Worker<T>::init_msg_queues() {
+void Worker<T>::init_partitions() {
+
+	NumaTopology topo;
+	numa = opts.has("numa");
+	int default_threads = numa ? topo.get_num_cpus() : 1;
+
+	// only the programs that combine with min give the same
+	// values on any number of threads, so only they are spread
+	if( planning && !numa && !opts.has("threads") && T::pull_semantics != PULL_NONE )
+		default_threads = planner.choose_threads( topo.get_num_cpus() );
+	num_parts = opts.get_int("threads", default_threads);
+	if( num_parts < 1 ) num_parts = 1;
+	if( num_verts > 0 && num_parts > num_verts ) num_parts = num_verts;
+
+	// boundaries by binary search on the cost prefix csr1[v] + v
+	part_bounds = new int[num_parts+1];
+	long long total = (long long)num_edges + num_verts;
+	part_bounds[0] = 0;
+	for(int p=1; p<num_parts; p++) {
+		long long target = total * p / num_parts;
+		int lo = part_bounds[p-1], hi = num_verts;
+		while( lo < hi ) {
+			int mid = lo + (hi-lo)/2;
+			if( (long long)csr1[mid] + mid < target ) lo = mid+1;
+			else hi = mid;
+		}
+		part_bounds[p] = lo;
+	}
+	part_bounds[num_parts] = num_verts;
+
+	// consecutive partitions share a node, one cpu each
+	part_cpu = new int[num_parts];
+	int num_nodes = topo.get_num_nodes();
+	for(int p=0; p<num_parts; p++) {
+		part_cpu[p] = -1;
+		if( numa ) {
+			int node = (long long)p * num_nodes / num_parts;
+			int first = ( (long long)node * num_parts + num_nodes - 1 ) / num_nodes;
+			part_cpu[p] = topo.get_cpu( node, (p - first) % topo.get_num_cpus(node) );
+		}
+	}
 
-	// allocate message queues
-	out_msgs_q = new Message<int>[ num_edges ];
-	in_msgs_q = new Message<int>[ num_edges ];
+	out_off = new int[num_parts * num_parts];
+	out_counts = new long long[num_parts * num_parts];
+	part_edges = new int[num_parts * num_parts];
+	in_off = new int[num_parts+1];
+	in_counts = new long long[num_parts];
+	for(int i=0; i<num_parts*num_parts; i++)
+		out_counts[i] = 0;
+
+	phase_times = new double[3*num_parts];
+	part_active = new long long[num_parts];
+	part_traversed = new long long[num_parts];
+	for(int i=0; i<3*num_parts; i++)
+		phase_times[i] = 0;
+
+	phase_counters = new long long[3*NUM_PERF_EVENTS*num_parts];
+	for(int i=0; i<3*NUM_PERF_EVENTS*num_parts; i++)
+		phase_counters[i] = -1;
+	if( use_perf ) {
+		vector<string> names;
+		for(int e=0; e<NUM_PERF_EVENTS; e++)
+			names.push_back( PerfCounters::event_name(e) );
+		metrics.set_counter_names(names);
+	}
+
+	// the atomic engine sends no messages, so has no queues
+	string engine = opts.get_string("engine", "vertex");
+	if( !opts.has("engine") && planner.choose_engine( T::pull_semantics != PULL_NONE, opts.get_string("log", "off") != "off" ) )
+		engine = "spmv";
+	use_spmv = ( engine == "spmv" );
+	use_atomic = ( engine == "atomic" );
+	if( !use_spmv && !use_atomic && engine != "vertex" ) {
+		printf("error: unknown engine %s, use vertex, spmv or atomic\n", engine.c_str() );
+		exit(-1);
+	}
+	if( ( use_spmv || use_atomic ) && T::pull_semantics == PULL_NONE ) {
+		printf("error: the program does not combine with min, use the vertex engine\n");
+		exit(-1);
+	}
+	if( ( use_spmv || use_atomic ) && opts.get_string("log", "off") != "off" ) {
+		printf("error: logging needs the vertex engine\n");
+		exit(-1);
+	}
+
+	// pulling needs min semantics and an undirected graph, where
+	// the edges a vertex pulls along are those its neighbors push on
+	string dir = opts.get_string("direction", "auto");
+	if( dir == "push" ) direction = DIR_PUSH;
+	else if( dir == "pull" ) direction = DIR_PULL;
+	else if( dir == "auto" ) direction = DIR_AUTO;
+	else {
+		printf("error: unknown direction %s, use push, pull or auto\n", dir.c_str() );
+		exit(-1);
+	}
+	if( T::pull_semantics == PULL_NONE || opts.get_string("log", "off") == "full" )
+		direction = DIR_PUSH;
+	if( opts.has("simd") && !kernels.select( opts.get_string("simd", "auto") ) ) {
+		printf("error: the cpu cannot run %s pull kernels\n", opts.get_string("simd", "auto").c_str() );
+		exit(-1);
+	}
+	// raw allocations from the arena, constructed and touched per partition.
+	// Every array below shares one block: the vertices, the message
+	// queues, and the arrays of the combiner, the pull and the engine
+	size_t bytes = sizeof(T) * (size_t)num_verts;
+	int arrays = 1;
+	if( !use_atomic ) {
+		bytes += 2 * sizeof(Message<V>) * (size_t)num_edges;
+		arrays += 2;
+	}
+	if( T::combiner == COMBINE_SUM ) {
+		bytes += ( sizeof(V) + sizeof(bool) ) * (size_t)num_verts;
+		arrays += 2;
+	}
+	if( use_spmv ) {
+		bytes += 3 * sizeof(int) * (size_t)num_verts;
+		arrays += 3;
+	} else if( direction != DIR_PUSH ) {
+		bytes += 2 * sizeof(int) * (size_t)num_verts;
+		arrays += 2;
+	}
+	if( use_atomic ) {
+		bytes += 2 * sizeof(int) * (size_t)num_verts;
+		arrays += 2;
+	}
+	arena.reserve( bytes + arrays * 64 );
+	vert_cont = arena.alloc_array<T>(num_verts);
+	out_msgs_q = in_msgs_q = NULL;
+	if( !use_atomic ) {
+		out_msgs_q = arena.alloc_array< Message<V> >(num_edges);
+		in_msgs_q = arena.alloc_array< Message<V> >(num_edges);
+	}
+	num_messages = 0;
+
+	combined = NULL;
+	combine_seen = NULL;
+	combine_touched = NULL;
+	if( T::combiner == COMBINE_SUM ) {
+		combined = arena.alloc_array<V>(num_verts);
+		combine_seen = arena.alloc_array<bool>(num_verts);
+		combine_touched = new vector<int>[num_parts];
+	}
+	part_aggregate = new double[num_parts];
+	for(int q=0; q<num_parts; q++)
+		part_aggregate[q] = 0;
+	aggregate = 0;
+	halt_aggregate = -1;
+	halted = false;
+
+	pulling = false;
+	pull_next = ( direction == DIR_PULL );
+	frontier = pull_best = NULL;
+	part_frontier_edges = new long long[num_parts];
+
+	spmv_vals = spmv_x = spmv_y = NULL;
+	spmv_front = spmv_touched = NULL;
+	if( use_spmv ) {
+		spmv_vals = arena.alloc_array<int>(num_verts);
+		spmv_x = arena.alloc_array<int>(num_verts);
+		spmv_y = arena.alloc_array<int>(num_verts);
+		spmv_front = new vector<int>[num_parts];
+		spmv_touched = new vector<int>[num_parts];
+	} else if( direction != DIR_PUSH ) {
+		frontier = arena.alloc_array<int>(num_verts);
+		pull_best = arena.alloc_array<int>(num_verts);
+	}
+
+	atom_vals = atom_stamp = NULL;
+	atom_front = atom_next = NULL;
+	atom_off = NULL;
+	if( use_atomic ) {
+		atom_vals = arena.alloc_array<int>(num_verts);
+		atom_stamp = arena.alloc_array<int>(num_verts);
+		atom_front = new vector<int>[num_parts];
+		atom_next = new vector<int>[num_parts];
+		atom_off = new long long[num_parts+1];
+	}
+
+	// the re-homed copies, handed to the graph with their arena
+	if( numa ) {
+		csr_arena.reserve( sizeof(int) * ( (size_t)num_verts + 1 + 2 * (size_t)num_edges ) + 3 * 64 );
+		new_csr1 = csr_arena.alloc_array<int>( (size_t)num_verts + 1 );
+		new_csr2 = csr_arena.alloc_array<int>(num_edges);
+		new_weights = csr_arena.alloc_array<int>(num_edges);
+	}
+
+	sync.init(num_parts);
+	if( num_parts > 1 || numa )
+		printf("running %d partitions over %d numa nodes%s\n", num_parts,
+			num_nodes, numa ? ", pinned" : "");
+
+	return;
+}
+
+/*
+	Initialize one partition from its own thread:
+	re-home its CSR slice, construct its vertices,
+	count its edges to every other partition,
+	then lay out and touch its message queue regions
+*/
+template<typename T>
+void Worker<T>::init_partition(int p) {
+
+	if( numa ) {
+		rehome_csr(p);
+		if( sync.wait() ) {
+			g.replace_csr(new_csr1, new_csr2, new_weights, csr_arena);
+			csr1 = new_csr1;
+			csr2 = new_csr2;
+			weights = new_weights;
+		}
+		sync.wait();
+	}
+
+	init_verts(p);
+	count_part_edges(p);
+
+	// offsets of every outbox and inbox region
+	if( sync.wait() ) {
+		in_off[0] = 0;
+		for(int q=0; q<num_parts; q++) {
+			int in_size = 0;
+			for(int r=0; r<num_parts; r++)
+				in_size += part_edges[r*num_parts+q];
+			in_off[q+1] = in_off[q] + in_size;
+		}
+		for(int r=0; r<num_parts; r++) {
+			int off = csr1[ part_bounds[r] ];
+			for(int q=0; q<num_parts; q++) {
+				out_off[r*num_parts+q] = off;
+				off += part_edges[r*num_parts+q];
+			}
+		}
+	}
+	sync.wait();
+
+	init_msg_queues(p);
+
+	return;
+}
+
+/*
+	copy this partition's slice of the CSR arrays
+	into the new arrays, placing the pages on its node
+*/
+template<typename T>
+void Worker<T>::rehome_csr(int p) {
+
+	int v_lo = part_bounds[p], v_hi = part_bounds[p+1];
+	int e_lo = csr1[v_lo], e_hi = csr1[v_hi];
+
+	memcpy( &new_csr1[v_lo], &csr1[v_lo], sizeof(int) * (v_hi - v_lo) );
+	if( p == num_parts-1 )
+		new_csr1[num_verts] = csr1[num_verts];
+	memcpy( &new_csr2[e_lo], &csr2[e_lo], sizeof(int) * (e_hi - e_lo) );
+	memcpy( &new_weights[e_lo], &weights[e_lo], sizeof(int) * (e_hi - e_lo) );
+
+	return;
+}
+
+/*
+	count the edges from this partition into every partition,
+	which bounds the messages it can send to each per superstep
+*/
+template<typename T>
+void Worker<T>::count_part_edges(int p) {
+
+	int* counts = &part_edges[p*num_parts];
+	for(int q=0; q<num_parts; q++)
+		counts[q] = 0;
+
+	int e_lo = csr1[ part_bounds[p] ], e_hi = csr1[ part_bounds[p+1] ];
+	for(int e=e_lo; e<e_hi; e++)
+		counts[ get_partition( csr2[e] ) ]++;
+
+	return;
+}
+
+/*
+	initialize the input and output message queues
+	of a partition: its outbox regions and its inbox region
+*/
+template<typename T>
+void Worker<T>::init_msg_queues(int p) {
 
 	// set every message index to a null message
-	Message<int> null_msg;
+	Message<V> null_msg;
 	null_msg.set_dest_id(-1);
 	null_msg.set_value(0);
 
-	for(int i=0; i<num_edges; i++) {
-		in_msgs_q[i] = null_msg;
+	int out_lo = csr1[ part_bounds[p] ], out_hi = csr1[ part_bounds[p+1] ];
+	for(int i=out_lo; i<out_hi && out_msgs_q; i++)
 		out_msgs_q[i] = null_msg;
+	for(int i=in_off[p]; i<in_off[p+1] && in_msgs_q; i++)
+		in_msgs_q[i] = null_msg;
+
+	if( T::combiner == COMBINE_SUM ) {
+		for(int i=part_bounds[p]; i<part_bounds[p+1]; i++) {
+			combined[i] = 0;
+			combine_seen[i] = false;
+		}
 	}
-	num_messages = 0;
+
 	return;
 }
 
 /*
-	Initialize the states of each vertex
+	Initialize the states of each vertex in a partition
 */
 template<typename T>
-void Worker<T>::init_verts() {
-
-	vert_cont = new T[num_verts];
+void Worker<T>::init_verts(int p) {
 
 	// Init vertices data with id, neighbors, weights, degree, and
 	// the init() function specified by templating (where active verts specified)
 	T* vert;
 	int degree, offset;
-	for(int i=0; i<num_verts; i++) {
+	for(int i=part_bounds[p]; i<part_bounds[p+1]; i++) {
+		new (&vert_cont[i]) T();
 		offset = csr1[i];
 		degree = csr1[i+1] - offset;
 
@@ -187,6 +777,7 @@ void Worker<T>::init_verts() {
 template<typename T>
 void Worker<T>::load_graph() {
 	
+	g.set_reader( opts.get_string("reader", "auto") );
 	g.init_from_edgelist(graphfile);
 	csr1 = g.get_csr1();
 	csr2 = g.get_csr2();
@@ -202,90 +793,289 @@ void Worker<T>::load_graph() {
 	run the system by:
 		- writing messages for the initially activated verts, log, then
 		- deliver messages, process inbox/run the vertex program, then write messages
+	every partition runs the supersteps in its own thread
 */
 template<typename T>
 void Worker<T>::run() {
 
-	printf("executing\n");
+	if( !quiet ) printf("executing\n");
+
+	superstep=0;
+	halted = false;
+	metrics.clear_supersteps();
+	double start = Metrics::now();
+	if( restore_cached() ) {
+		metrics.set_run_time( Metrics::now() - start );
+		if( !quiet ) printf("restored the result from the cache in %.3f s\n", metrics.get_run_time() );
+	} else {
+		superstep_start = start;
+		if( use_atomic ) run_partitions( &Worker<T>::run_atomic_partition );
+		else run_partitions( use_spmv ? &Worker<T>::run_spmv_partition : &Worker<T>::run_partition );
+		metrics.set_run_time( Metrics::now() - start );
+		store_cached();
+		if( !quiet ) {
+			cout << "execution complete" << endl;
+			metrics.print_summary();
+		}
+	}
+	if( opts.has("metrics") )
+		metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
 
-	int superstep=0;
-	
-	write_messages();
-	superstep++;
-	if( logging ) log_superstep(superstep);
+	return;
+}
+
+/*
+	the superstep loop of one partition.
+	a barrier separates delivery from processing, since
+	delivery reads other partitions' outboxes
+*/
+template<typename T>
+void Worker<T>::run_partition(int p) {
+
+	double* times = &phase_times[3*p];
+	double t0, t1, t2, t3;
+
+	// counters are per thread, so each partition opens its own
+	PerfCounters perf;
+	long long c[5][NUM_PERF_EVENTS];
+	bool counting = use_perf && perf.open();
+	if( use_perf && !counting && p == 0 )
+		printf("hardware counters unavailable, running without them\n");
+
+	perf.read(c[0]);
+	t0 = Metrics::now();
+	write_frontier(p);
+	times[0] = Metrics::now() - t0;
+	perf.read(c[1]);
+	if( counting ) record_counters(p, 0, c[0], c[1]);
+	end_superstep(p, false);
 
 	//while( num_messages > 0 && !(fixed_supersteps && superstep < max_supersteps) ) {
-	while(num_messages > 0 ) {
-		deliver_messages();
-		process_inbox();
-		write_messages();
-		cout << "completing superstep " << superstep << endl;
+	while(num_messages > 0 && !halted ) {
+		if( counting ) perf.read(c[0]);
+		t0 = Metrics::now();
+		if( !pulling ) deliver_messages(p);
+		t1 = Metrics::now();
+		if( counting ) perf.read(c[1]);
+		if( !pulling ) sync.wait();
+		if( counting ) perf.read(c[2]);
+		t2 = Metrics::now();
+		if( pulling ) pull_inbox(p);
+		else if( T::combiner == COMBINE_SUM ) combine_inbox(p);
+		else process_inbox(p);
+		t3 = Metrics::now();
+		if( counting ) perf.read(c[3]);
+		write_frontier(p);
+		times[0] = Metrics::now() - t3;
+		times[1] = t1 - t0;
+		times[2] = t3 - t2;
+		if( counting ) {
+			perf.read(c[4]);
+			record_counters(p, 0, c[3], c[4]);
+			record_counters(p, 1, c[0], c[1]);
+			record_counters(p, 2, c[2], c[3]);
+		}
+		end_superstep(p, true);
+	}
+
+	if( logging && p == 0 ) logwriter.flush();
+
+	return;
+}
+
+/*
+	store the counter deltas of a partition's phase
+*/
+template<typename T>
+void Worker<T>::record_counters(int p, int phase, long long* before, long long* after) {
+	long long* out = &phase_counters[ (3*p + phase) * NUM_PERF_EVENTS ];
+	for(int e=0; e<NUM_PERF_EVENTS; e++)
+		out[e] = ( before[e] < 0 || after[e] < 0 ) ? -1 : after[e] - before[e];
+}
+
+/*
+	wait for every partition to finish writing,
+	then one thread totals the messages, advances the superstep and logs
+*/
+template<typename T>
+void Worker<T>::end_superstep(int, bool report) {
+
+	if( sync.wait() ) {
+		num_messages = 0;
+		for(int i=0; i<num_parts*num_parts; i++)
+			num_messages += out_counts[i];
+		if( report && !quiet ) cout << "completing superstep " << superstep << endl;
 		superstep++;
+
+		// slowest partition of each phase, and total work
+		SuperstepStats stats;
+		stats.superstep = superstep;
+		stats.write_s = stats.deliver_s = stats.process_s = 0;
+		stats.active_verts = stats.edges = 0;
+		for(int q=0; q<num_parts; q++) {
+			stats.write_s = max( stats.write_s, phase_times[3*q] );
+			stats.deliver_s = max( stats.deliver_s, phase_times[3*q+1] );
+			stats.process_s = max( stats.process_s, phase_times[3*q+2] );
+			stats.active_verts += part_active[q];
+			stats.edges += part_traversed[q];
+		}
+		for(int ph=0; ph<3 && use_perf; ph++) {
+			for(int e=0; e<NUM_PERF_EVENTS; e++) {
+				long long total = 0;
+				for(int q=0; q<num_parts && total >= 0; q++) {
+					long long v = phase_counters[ (3*q + ph) * NUM_PERF_EVENTS + e ];
+					total = ( v < 0 ) ? -1 : total + v;
+				}
+				stats.counters[ph][e] = total;
+			}
+		}
+		stats.messages = num_messages;
+		stats.pull = pulling;
+		pulling = pull_next;
+
+		aggregate = 0;
+		for(int q=0; q<num_parts; q++)
+			aggregate += part_aggregate[q];
+		stats.aggregate = aggregate;
+		halted = ( halt_aggregate >= 0 && aggregate < halt_aggregate );
+
+		double t = Metrics::now();
 		if( logging ) log_superstep(superstep);
+		double end = Metrics::now();
+		stats.log_s = end - t;
+		stats.total_s = end - superstep_start;
+		stats.heap_bytes = Metrics::heap_bytes();
+		superstep_start = end;
+		metrics.add_superstep(stats);
+	}
+	sync.wait();
+
+	return;
+}
+
+/*
+	run a function on every partition, each in its own thread
+	(pinned to its cpu with numa), or inline for a single partition
+*/
+template<typename T>
+void Worker<T>::run_partitions( void (Worker<T>::*fn)(int) ) {
+
+	if( num_parts == 1 && !numa ) {
+		(this->*fn)(0);
+		return;
 	}
-	cout << "execution complete" << endl;
+
+	thread* threads = new thread[num_parts];
+	for(int p=0; p<num_parts; p++)
+		threads[p] = thread( &Worker<T>::partition_main, this, fn, p );
+	for(int p=0; p<num_parts; p++)
+		threads[p].join();
+	delete [] threads;
 
 	return;
 }
 
+/* thread entry for a partition */
+template<typename T>
+void Worker<T>::partition_main( void (Worker<T>::*fn)(int), int p ) {
+	if( part_cpu[p] >= 0 )
+		NumaTopology::pin_to_cpu( part_cpu[p] );
+	(this->*fn)(p);
+}
+
 /*
-	iterate through all vertices
+	the partition that owns a vertex,
+	binary search over the partition boundaries
+*/
+template<typename T>
+inline int Worker<T>::get_partition(int v) {
+	int lo=0, hi=num_parts-1;
+	while( lo < hi ) {
+		int mid = (lo+hi+1)/2;
+		if( part_bounds[mid] <= v ) lo = mid;
+		else hi = mid-1;
+	}
+	return lo;
+}
+
+/*
+	iterate through the partition's vertices
 	if vert is active, then for each neighbor,
-	write a message to the outbox.
-	outbox is a stack, new messages written to front	
+	write a message to the outbox of the neighbor's partition.
+	each outbox is a stack, new messages written to front	
 */
 template<typename T>
-void Worker<T>::write_messages() {
+void Worker<T>::write_messages(int p) {
+
+	long long* counts = &out_counts[p*num_parts];
+	int* offsets = &out_off[p*num_parts];
+	for(int q=0; q<num_parts; q++)
+		counts[q] = 0;
 
 	T* vert;
-	Message<int> msg;
-	int neighbor, degree, weight;
-	for(int i=0; i<num_verts; i++) {
+	int neighbor, degree, weight, q;
+	long long active = 0, traversed = 0;
+	double agg = 0;
+	for(int i=part_bounds[p]; i<part_bounds[p+1]; i++) {
 		vert = &vert_cont[i];
 		if( (*vert).get_active() ) {
 			degree = (*vert).get_degree();
+			active++;
+			traversed += degree;
+			agg += (*vert).get_aggregate();
 			//cout << "vert " << (*vert).get_id() << " has degree " << degree << endl;
 			for(int j=0; j<degree; j++) {
 				neighbor = (*vert).get_neighborstart()[j];
 				weight = (*vert).get_weightstart()[j];
-				(*vert).send_message( out_msgs_q, num_messages, neighbor, weight );
-				num_messages++;
+				q = ( num_parts == 1 ) ? 0 : get_partition(neighbor);
+				(*vert).send_message( &out_msgs_q[ offsets[q] ], counts[q], neighbor, weight );
+				counts[q]++;
 			}
 			(*vert).set_active(false);
 		}
 	}
+	part_active[p] = active;
+	part_traversed[p] = traversed;
+	part_aggregate[p] = agg;
 	//cout << "wrote " << num_messages << " messages" << endl;
 
 	return;
 }
 
 /*
-	move messages from outqueue to inqueue.
+	move messages addressed to this partition
+	from every partition's outqueue to its inqueue.
 */
 template<typename T>
-void Worker<T>::deliver_messages() {
-
-	for(int i=0; i<num_messages; i++) {
-		in_msgs_q[i] = out_msgs_q[i];
+void Worker<T>::deliver_messages(int q) {
+
+	long long count = 0;
+	Message<V>* inbox = &in_msgs_q[ in_off[q] ];
+	for(int p=0; p<num_parts; p++) {
+		long long n = out_counts[p*num_parts+q];
+		memcpy( &inbox[count], &out_msgs_q[ out_off[p*num_parts+q] ], sizeof(Message<V>) * n );
+		count += n;
 	}
+	in_counts[q] = count;
 
 	return;
 }
 
 /*
 	vertices read messages from the inbox.
-	iterate through inbox, get vert id,
+	iterate through the partition's inbox, get vert id,
 	execute vert, set active as necessary
 */
 template<typename T>
-void Worker<T>::process_inbox() {
+void Worker<T>::process_inbox(int q) {
 
 	T* vert;
-	Message<int>* msg;
+	Message<V>* msg;
+	Message<V>* inbox = &in_msgs_q[ in_off[q] ];
 
-	int value;
-	for(int i=0; i<num_messages; i++) {
-		msg = &in_msgs_q[i];
+	V value;
+	for(long long i=0; i<in_counts[q]; i++) {
+		msg = &inbox[i];
 		vert = &vert_cont[ (*msg).get_dest_id() ];
 		value = vert->get_value();
 		//printf("before processing msg, vert: %d, msg dest: %d, msg val: %d\n", (*vert).get_id(), (*msg).get_dest_id(), (*msg).get_value() );
@@ -296,53 +1086,766 @@ void Worker<T>::process_inbox() {
 			//cout << "setting active" << endl;
 		}		
 	}
-	num_messages=0;
 
 	return;
 }
 
+/*
+	process_inbox for programs with a sum combiner: add up the
+	messages to each vertex first, then each vertex reached
+	processes their sum as a single message, in the order
+	of its first message
+*/
+template<typename T>
+void Worker<T>::combine_inbox(int q) {
+
+	vector<int>& touched = combine_touched[q];
+	touched.clear();
+	Message<V>* inbox = &in_msgs_q[ in_off[q] ];
+	for(long long i=0; i<in_counts[q]; i++) {
+		int v = inbox[i].get_dest_id();
+		if( !combine_seen[v] ) {
+			combine_seen[v] = true;
+			touched.push_back(v);
+		}
+		combined[v] += inbox[i].get_value();
+	}
+
+	T* vert;
+	Message<V> msg;
+	V value;
+	for(size_t i=0; i<touched.size(); i++) {
+		int v = touched[i];
+		vert = &vert_cont[v];
+		value = vert->get_value();
+		msg.set_dest_id(v);
+		msg.set_value( combined[v] );
+		vert->process_message(&msg);
+		if( value != vert->get_value() && vert->get_active() == false )
+			vert->set_active(true);
+		combined[v] = 0;
+		combine_seen[v] = false;
+	}
+
+	return;
+}
+
+/*
+	pick the direction of the next superstep by the edges of the
+	frontier, reporting why whenever it changes
+*/
+template<typename T>
+void Worker<T>::choose_direction(long long frontier_edges) {
+	bool was = pull_next;
+	pull_next = planner.frontier_pull( frontier_edges, num_edges, was );
+	if( pull_next != was && !quiet )
+		printf("superstep %d: %s\n", superstep, planner.get_switch_reason().c_str() );
+}
+
+/*
+	send the values of the active vertices on to the next superstep,
+	as messages or as a frontier to pull from.  With auto direction,
+	the partitions first total the edges of the frontier, and
+	one thread picks the direction for them all.  Either way no
+	partition rewrites the frontier while another still pulls from it
+*/
+template<typename T>
+void Worker<T>::write_frontier(int p) {
+
+	if( direction == DIR_AUTO ) {
+		long long edges = 0;
+		for(int i=part_bounds[p]; i<part_bounds[p+1]; i++)
+			if( vert_cont[i].get_active() ) edges += vert_cont[i].get_degree();
+		part_frontier_edges[p] = edges;
+		if( sync.wait() ) {
+			edges = 0;
+			for(int q=0; q<num_parts; q++)
+				edges += part_frontier_edges[q];
+			choose_direction(edges);
+		}
+		sync.wait();
+	} else if( pulling ) {
+		// every partition must be done pulling from the frontier
+		sync.wait();
+	}
+
+	if( pull_next ) snapshot_frontier(p);
+	else write_messages(p);
+
+	return;
+}
+
+/*
+	the pull counterpart of write_messages: record the values of
+	the partition's active vertices in the frontier, and deactivate
+	them.  Each of their edges counts as the message it stands in for
+*/
+template<typename T>
+void Worker<T>::snapshot_frontier(int p) {
+
+	long long* counts = &out_counts[p*num_parts];
+	for(int q=0; q<num_parts; q++)
+		counts[q] = 0;
+
+	T* vert;
+	long long active = 0, traversed = 0;
+	double agg = 0;
+	for(int i=part_bounds[p]; i<part_bounds[p+1]; i++) {
+		vert = &vert_cont[i];
+		if( vert->get_active() ) {
+			frontier[i] = vert->get_value();
+			agg += vert->get_aggregate();
+			active++;
+			traversed += vert->get_degree();
+			vert->set_active(false);
+		} else {
+			frontier[i] = PULL_INF;
+		}
+	}
+	counts[p] = traversed;
+	part_active[p] = active;
+	part_traversed[p] = traversed;
+	part_aggregate[p] = agg;
+
+	return;
+}
+
+/*
+	the pull counterpart of delivering and processing messages:
+	each vertex of the partition gathers the least value its
+	frontier neighbors offer, and is activated if that improves it
+*/
+template<typename T>
+void Worker<T>::pull_inbox(int p) {
+
+	int lo = part_bounds[p], hi = part_bounds[p+1];
+	int add = ( T::pull_semantics == PULL_MIN_PLUS_ONE ) ? 1 : 0;
+	const int* w = ( T::pull_semantics == PULL_MIN_PLUS_WEIGHT ) ? weights : NULL;
+	kernels.gather_min( csr1, csr2, w, add, frontier, lo, hi, pull_best );
+
+	T* vert;
+	for(int i=lo; i<hi; i++) {
+		vert = &vert_cont[i];
+		if( pull_best[i] < vert->get_value() ) {
+			vert->set_value( pull_best[i] );
+			vert->set_active(true);
+		}
+	}
+
+	return;
+}
+
+
+
+/** Semiring engine functions **/
+
+/*
+	the step loop of one partition in the semiring engine, with
+	the supersteps, messages and metrics of the vertex engine.
+	The values move from the vertices into spmv_vals, and back
+	once the frontier is empty
+*/
+template<typename T>
+void Worker<T>::run_spmv_partition(int p) {
+
+	typedef typename SemiringOf<T::pull_semantics>::type S;
+	double* times = &phase_times[3*p];
+	double t0, t1;
+
+	vector<int>& front = spmv_front[p];
+	front.clear();
+	for(int i=part_bounds[p]; i<part_bounds[p+1]; i++) {
+		spmv_vals[i] = vert_cont[i].get_value();
+		spmv_y[i] = S::zero();
+		if( vert_cont[i].get_active() ) {
+			front.push_back(i);
+			vert_cont[i].set_active(false);
+		}
+	}
+	if( sync.wait() ) {
+		spmv_level = INT_MAX;
+		for(int q=0; q<num_parts; q++)
+			if( !spmv_front[q].empty() )
+				spmv_level = min( spmv_level, spmv_vals[ spmv_front[q][0] ] );
+	}
+
+	// counters as in run_partition, with nothing to deliver
+	PerfCounters perf;
+	long long c[3][NUM_PERF_EVENTS];
+	bool counting = use_perf && perf.open();
+	if( use_perf && !counting && p == 0 )
+		printf("hardware counters unavailable, running without them\n");
+
+	perf.read(c[0]);
+	t0 = Metrics::now();
+	spmv_write(p);
+	times[0] = Metrics::now() - t0;
+	perf.read(c[1]);
+	if( counting ) record_counters(p, 0, c[0], c[1]);
+	end_superstep(p, false);
+
+	while( num_messages > 0 && !halted ) {
+		if( counting ) perf.read(c[0]);
+		t0 = Metrics::now();
+		if( pulling ) spmv_dense(p);
+		else spmv_sparse(p);
+		t1 = Metrics::now();
+		if( counting ) perf.read(c[1]);
+		spmv_write(p);
+		times[0] = Metrics::now() - t1;
+		times[1] = 0;
+		times[2] = t1 - t0;
+		if( counting ) {
+			perf.read(c[2]);
+			record_counters(p, 0, c[1], c[2]);
+			record_counters(p, 1, c[1], c[1]);
+			record_counters(p, 2, c[0], c[1]);
+		}
+		end_superstep(p, true);
+	}
+
+	for(int i=part_bounds[p]; i<part_bounds[p+1]; i++)
+		vert_cont[i].set_value( spmv_vals[i] );
+
+	return;
+}
+
+/*
+	the write phase of the semiring engine: pick the direction
+	as write_frontier does, then lay the frontier out as the dense
+	vector x, or multiply it by its rows of the matrix (a sparse
+	product) into the outboxes of the partitions owning the columns
+*/
+template<typename T>
+void Worker<T>::spmv_write(int p) {
+
+	typedef typename SemiringOf<T::pull_semantics>::type S;
+	bool boolean = ( T::pull_semantics == PULL_MIN_PLUS_ONE );
+	vector<int>& front = spmv_front[p];
+
+	long long traversed = 0;
+	for(size_t i=0; i<front.size(); i++)
+		traversed += csr1[ front[i]+1 ] - csr1[ front[i] ];
+
+	// no partition rewrites x or its outboxes while another reads them
+	part_frontier_edges[p] = traversed;
+	if( sync.wait() && direction == DIR_AUTO ) {
+		long long edges = 0;
+		for(int q=0; q<num_parts; q++)
+			edges += part_frontier_edges[q];
+		choose_direction(edges);
+	}
+	sync.wait();
+
+	long long* counts = &out_counts[p*num_parts];
+	int* offsets = &out_off[p*num_parts];
+	for(int q=0; q<num_parts; q++)
+		counts[q] = 0;
+
+	if( pull_next ) {
+		for(int i=part_bounds[p]; i<part_bounds[p+1]; i++)
+			spmv_x[i] = S::zero();
+		for(size_t i=0; i<front.size(); i++)
+			spmv_x[ front[i] ] = boolean ? 1 : spmv_vals[ front[i] ];
+		counts[p] = traversed;
+	} else {
+		Message<V> msg;
+		for(size_t i=0; i<front.size(); i++) {
+			int u = front[i];
+			int xu = boolean ? 1 : spmv_vals[u];
+			for(int j=csr1[u]; j<csr1[u+1]; j++) {
+				int v = csr2[j];
+				int q = ( num_parts == 1 ) ? 0 : get_partition(v);
+				msg.set_dest_id(v);
+				msg.set_value( S::multiply( xu, S::weighted ? weights[j] : 1 ) );
+				out_msgs_q[ offsets[q] + counts[q]++ ] = msg;
+			}
+		}
+	}
+	part_active[p] = front.size();
+	part_traversed[p] = traversed;
+
+	return;
+}
+
+/*
+	a dense step: y = A x over the partition's rows, masked to
+	the unreached vertices for bfs, and the vertices whose
+	value improves become the next frontier.  An unblocked
+	min product runs on the pull kernels
+*/
+template<typename T>
+void Worker<T>::spmv_dense(int p) {
+
+	typedef typename SemiringOf<T::pull_semantics>::type S;
+	bool boolean = ( T::pull_semantics == PULL_MIN_PLUS_ONE );
+	int lo = part_bounds[p], hi = part_bounds[p+1];
+
+	// a min product over one block is the vectorized gather-and-min
+	if( !boolean && spmv_csr.get_num_blocks() == 1 ) {
+		const CsrBlock& blk = spmv_csr.get_block(0);
+		kernels.gather_min( blk.ptr, blk.cols, S::weighted ? blk.weights : NULL, 0, spmv_x, lo, hi, spmv_y );
+	} else {
+		spmv_rows<S>( spmv_csr, spmv_x, spmv_y, boolean ? spmv_vals : NULL, lo, hi );
+	}
+
+	vector<int>& front = spmv_front[p];
+	front.clear();
+	for(int v=lo; v<hi; v++) {
+		if( boolean ? ( spmv_y[v] != 0 ) : ( spmv_y[v] < spmv_vals[v] ) ) {
+			spmv_vals[v] = boolean ? spmv_level + superstep : spmv_y[v];
+			front.push_back(v);
+		}
+		spmv_y[v] = S::zero();
+	}
+
+	return;
+}
+
+/*
+	a sparse step: combine the products addressed to the
+	partition, read straight from the outboxes, in spmv_y as a
+	sparse accumulator, then the vertices whose value improves
+	become the next frontier.  For bfs the first product to
+	reach an unreached vertex is enough
+*/
+template<typename T>
+void Worker<T>::spmv_sparse(int q) {
+
+	typedef typename SemiringOf<T::pull_semantics>::type S;
+	bool boolean = ( T::pull_semantics == PULL_MIN_PLUS_ONE );
+	vector<int>& front = spmv_front[q];
+	vector<int>& touched = spmv_touched[q];
+	front.clear();
+	touched.clear();
+
+	for(int p=0; p<num_parts; p++) {
+		Message<V>* outbox = &out_msgs_q[ out_off[p*num_parts+q] ];
+		long long n = out_counts[p*num_parts+q];
+		for(long long i=0; i<n; i++) {
+			int v = outbox[i].get_dest_id();
+			if( boolean ) {
+				if( spmv_vals[v] == INT_MAX ) {
+					spmv_vals[v] = spmv_level + superstep;
+					front.push_back(v);
+				}
+				continue;
+			}
+			if( spmv_y[v] == S::zero() ) touched.push_back(v);
+			spmv_y[v] = S::add( spmv_y[v], outbox[i].get_value() );
+		}
+	}
+
+	for(size_t i=0; i<touched.size(); i++) {
+		int v = touched[i];
+		if( spmv_y[v] < spmv_vals[v] ) {
+			spmv_vals[v] = spmv_y[v];
+			front.push_back(v);
+		}
+		spmv_y[v] = S::zero();
+	}
+
+	return;
+}
+
+
+
+
+/** Atomic engine functions **/
+
+/*
+	the superstep loop of one partition in the atomic engine.
+	A push step writes and processes at once, so each superstep
+	has a single barrier past the write; the values move from the
+	vertices into atom_vals, and back once the frontier is empty
+*/
+template<typename T>
+void Worker<T>::run_atomic_partition(int p) {
+
+	double* times = &phase_times[3*p];
+	double t0, t1;
+
+	vector<int>& next = atom_next[p];
+	next.clear();
+	for(int i=part_bounds[p]; i<part_bounds[p+1]; i++) {
+		atom_vals[i] = vert_cont[i].get_value();
+		atom_stamp[i] = -1;
+		if( vert_cont[i].get_active() ) {
+			atom_stamp[i] = superstep;
+			next.push_back(i);
+			vert_cont[i].set_active(false);
+		}
+	}
+
+	// counters as in run_partition, with nothing to deliver
+	PerfCounters perf;
+	long long c[3][NUM_PERF_EVENTS];
+	bool counting = use_perf && perf.open();
+	if( use_perf && !counting && p == 0 )
+		printf("hardware counters unavailable, running without them\n");
+
+	perf.read(c[0]);
+	t0 = Metrics::now();
+	atomic_write(p);
+	times[0] = Metrics::now() - t0;
+	perf.read(c[1]);
+	if( counting ) record_counters(p, 0, c[0], c[1]);
+	end_superstep(p, false);
+
+	while( num_messages > 0 && !halted ) {
+		if( counting ) perf.read(c[0]);
+		t0 = Metrics::now();
+		if( pulling ) atomic_pull(p);
+		else atomic_push(p);
+		t1 = Metrics::now();
+		if( counting ) perf.read(c[1]);
+		atomic_write(p);
+		times[0] = Metrics::now() - t1;
+		times[1] = 0;
+		times[2] = t1 - t0;
+		if( counting ) {
+			perf.read(c[2]);
+			record_counters(p, 0, c[1], c[2]);
+			record_counters(p, 1, c[1], c[1]);
+			record_counters(p, 2, c[0], c[1]);
+		}
+		end_superstep(p, true);
+	}
+
+	for(int i=part_bounds[p]; i<part_bounds[p+1]; i++)
+		vert_cont[i].set_value( atom_vals[i] );
+
+	return;
+}
+
+/*
+	the write phase of the atomic engine: once every partition
+	is done finding vertices, one thread makes the vertices each
+	found the frontier, laid end to end at atom_off, and picks the
+	direction.  A pull step then reads the frontier array, filled
+	by the partition owning each vertex
+*/
+template<typename T>
+void Worker<T>::atomic_write(int p) {
+
+	vector<int>& found = atom_next[p];
+	long long traversed = 0;
+	for(size_t i=0; i<found.size(); i++)
+		traversed += csr1[ found[i]+1 ] - csr1[ found[i] ];
+
+	// no partition swaps out a share another may still be pushing from
+	part_frontier_edges[p] = traversed;
+	if( sync.wait() ) {
+		long long edges = 0;
+		atom_off[0] = 0;
+		for(int q=0; q<num_parts; q++) {
+			atom_front[q].swap( atom_next[q] );
+			atom_next[q].clear();
+			edges += part_frontier_edges[q];
+			atom_off[q+1] = atom_off[q] + atom_front[q].size();
+		}
+		if( direction == DIR_AUTO ) choose_direction(edges);
+	}
+	sync.wait();
+
+	if( pull_next ) {
+		for(int i=part_bounds[p]; i<part_bounds[p+1]; i++)
+			frontier[i] = ( atom_stamp[i] == superstep ) ? atom_vals[i] : PULL_INF;
+	}
+
+	long long* counts = &out_counts[p*num_parts];
+	for(int q=0; q<num_parts; q++)
+		counts[q] = 0;
+	counts[p] = traversed;
+	part_active[p] = atom_front[p].size();
+	part_traversed[p] = traversed;
+
+	return;
+}
+
+/*
+	a push step: the partition relaxes the edges of its even share
+	of the frontier, lowering each neighbor to what the edge offers
+	with an atomic min.  Whoever lowers a vertex first this superstep
+	puts it in their next frontier, so it is listed once
+*/
+template<typename T>
+void Worker<T>::atomic_push(int p) {
+
+	int add = ( T::pull_semantics == PULL_MIN_PLUS_ONE ) ? 1 : 0;
+	const int* w = ( T::pull_semantics == PULL_MIN_PLUS_WEIGHT ) ? weights : NULL;
+	vector<int>& next = atom_next[p];
+	int step = superstep;
+
+	long long total = atom_off[num_parts];
+	long long lo = total * p / num_parts, hi = total * (p+1) / num_parts;
+	int q = 0;
+	for(long long k=lo; k<hi; k++) {
+		while( atom_off[q+1] <= k ) q++;
+		int u = atom_front[q][ k - atom_off[q] ];
+		int xu = __atomic_load_n( &atom_vals[u], __ATOMIC_RELAXED );
+		for(int j=csr1[u]; j<csr1[u+1]; j++) {
+			int v = csr2[j];
+			int offer = xu + ( w ? w[j] : add );
+			int old = __atomic_load_n( &atom_vals[v], __ATOMIC_RELAXED );
+			while( offer < old ) {
+				if( __atomic_compare_exchange_n( &atom_vals[v], &old, offer, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) ) {
+					if( __atomic_exchange_n( &atom_stamp[v], step, __ATOMIC_RELAXED ) != step )
+						next.push_back(v);
+					break;
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+/*
+	a pull step: each vertex of the partition gathers the least
+	value its frontier neighbors offer, as pull_inbox does, and
+	joins the next frontier if that improves it.  Only the owner
+	writes a vertex, so no atomics are needed
+*/
+template<typename T>
+void Worker<T>::atomic_pull(int p) {
+
+	int lo = part_bounds[p], hi = part_bounds[p+1];
+	int add = ( T::pull_semantics == PULL_MIN_PLUS_ONE ) ? 1 : 0;
+	const int* w = ( T::pull_semantics == PULL_MIN_PLUS_WEIGHT ) ? weights : NULL;
+	kernels.gather_min( csr1, csr2, w, add, frontier, lo, hi, pull_best );
+
+	vector<int>& next = atom_next[p];
+	for(int i=lo; i<hi; i++) {
+		if( pull_best[i] < atom_vals[i] ) {
+			atom_vals[i] = pull_best[i];
+			atom_stamp[i] = superstep;
+			next.push_back(i);
+		}
+	}
+
+	return;
+}
 
 
 /** Logging functions **/
+
+/*
+	read the logging options, and if logging,
+	open the log file with a background writer
+*/
+template<typename T>
+void Worker<T>::init_logging() {
+
+	string level = opts.get_string("log", "off");
+	if( level == "off" ) log_level = LOG_OFF;
+	else if( level == "summary" ) log_level = LOG_SUMMARY;
+	else if( level == "delta" ) log_level = LOG_DELTA;
+	else if( level == "full" ) log_level = LOG_FULL;
+	else {
+		printf("error: unknown log level %s, use off, summary, delta or full\n", level.c_str() );
+		exit(-1);
+	}
+	log_binary = ( opts.get_string("logformat", "text") == "binary" );
+
+	set_logging( log_level != LOG_OFF );
+	if( !logging ) return;
+
+	logfilename = set_logfilename(graphfile);
+	if( !logwriter.open(logfilename) ) {
+		set_logging(false);
+		return;
+	}
+
+	// binary header: magic, then the log level
+	if( log_binary ) {
+		logwriter.write( "TLAVLOG1", 8 );
+		logwriter.put_int32( log_level );
+	}
+
+	return;
+}
+
+/*
+	log a superstep at the configured level.
+	called by a single thread between supersteps,
+	the writer thread does the file i/o
+*/
 template<typename T>
 void Worker<T>::log_superstep(int superstep) {
 
-	ofstream logfile;
-	logfile.open( logfilename.c_str() , ios::app );
+	if( log_binary ) {
+		log_superstep_binary(superstep);
+		return;
+	}
+
+	if( log_level == LOG_SUMMARY ) {
+		logwriter.put_str("superstep ");
+		logwriter.put_int(superstep);
+		logwriter.put_str("\tmessages ");
+		char num[24];
+		logwriter.write( num, BufferedWriter::format_long(num, num_messages) );
+		logwriter.put('\n');
+		return;
+	}
+
+	logwriter.put_str("/***********  superstep ");
+	logwriter.put_int(superstep);
+	logwriter.put_str(" **********/\n");
+
+	if( log_level == LOG_DELTA ) {
+		logwriter.put_str("vert_changed\n");
+		log_vertices_text(true);
+		logwriter.put('\n');
+		return;
+	}
 
-	logfile << "/***********  superstep " << superstep << " **********/" << endl;
-	logfile << "vert" << endl;
+	logwriter.put_str("vert\n");
+	log_vertices_text(false);
+	log_messages_text();
+
+	return;
+}
 
-	T vert;
-	int id, val;
-	string inf = "inf";
+/*
+	write each vertex id and value, or only the vertices
+	whose value changed since the last logged superstep
+*/
+template<typename T>
+void Worker<T>::log_vertices_text(bool changed_only) {
+
+	if( changed_only && log_prev == NULL ) {
+		log_prev = new V[num_verts];
+		changed_only = false;
+	}
+
+	V val;
 	for(int i=0; i<num_verts; i++) {
 
-		vert = vert_cont[i];
-		id = vert.get_id();
-		val = vert.get_value();
-		
-		logfile << id << "\t";
-		if( val == INT_MAX) 
-			logfile << inf << endl;
-		else
-			logfile << val << endl;
+		val = vert_cont[i].get_value();
+		if( changed_only && log_prev[i] == val )
+			continue;
+		if( log_prev != NULL ) log_prev[i] = val;
+
+		logwriter.put_int(i);
+		logwriter.put('\t');
+		put_value(val);
+		logwriter.put('\n');
 
 	}
 
-	logfile << endl << "messages_out" << endl;
-	logfile << "num\tdest_id\tvalue" << endl;
+	return;
+}
+
+/*
+	write every outgoing message, numbered in
+	partition order
+*/
+template<typename T>
+void Worker<T>::log_messages_text() {
+
+	logwriter.put_str("\nmessages_out\n");
+	logwriter.put_str("num\tdest_id\tvalue\n");
 	
-	for(int i=0; i<num_messages; i++) {
-		logfile << i << "\t" << out_msgs_q[i].get_dest_id() << "\t" << out_msgs_q[i].get_value() << endl;
+	int num=0;
+	Message<V>* outbox;
+	for(int r=0; r<num_parts*num_parts; r++) {
+		outbox = &out_msgs_q[ out_off[r] ];
+		for(long long i=0; i<out_counts[r]; i++) {
+			logwriter.put_int(num);
+			logwriter.put('\t');
+			logwriter.put_int( outbox[i].get_dest_id() );
+			logwriter.put('\t');
+			put_value( outbox[i].get_value() );
+			logwriter.put('\n');
+			num++;
+		}
 	}
-	logfile << endl;
+	logwriter.put('\n');
 
-	logfile.close();
+	return;
+}
+
+/*
+	binary superstep record, all int32 but the values,
+	which are 4 bytes of the program's value type:
+		superstep, num_messages, num_vert_records, num_msg_records,
+		then (id, value) per vertex record,
+		then (dest_id, value) per message record
+*/
+template<typename T>
+void Worker<T>::log_superstep_binary(int superstep) {
+
+	bool all_verts = ( log_level == LOG_FULL || (log_level == LOG_DELTA && log_prev == NULL) );
+	if( log_level == LOG_DELTA && log_prev == NULL )
+		log_prev = new V[num_verts];
+
+	int num_vert_records = 0;
+	if( all_verts ) {
+		num_vert_records = num_verts;
+	} else if( log_level == LOG_DELTA ) {
+		for(int i=0; i<num_verts; i++)
+			if( log_prev[i] != vert_cont[i].get_value() ) num_vert_records++;
+	}
+	int num_msg_records = ( log_level == LOG_FULL ) ? (int)num_messages : 0;
+
+	logwriter.put_int32(superstep);
+	logwriter.put_int32( (int)num_messages );
+	logwriter.put_int32(num_vert_records);
+	logwriter.put_int32(num_msg_records);
+
+	if( log_level >= LOG_DELTA ) {
+		V val;
+		for(int i=0; i<num_verts; i++) {
+			val = vert_cont[i].get_value();
+			if( !all_verts && log_prev[i] == val ) continue;
+			if( log_prev != NULL ) log_prev[i] = val;
+			logwriter.put_int32(i);
+			put_value32(val);
+		}
+	}
+
+	if( log_level == LOG_FULL ) {
+		Message<V>* outbox;
+		for(int r=0; r<num_parts*num_parts; r++) {
+			outbox = &out_msgs_q[ out_off[r] ];
+			for(long long i=0; i<out_counts[r]; i++) {
+				logwriter.put_int32( outbox[i].get_dest_id() );
+				put_value32( outbox[i].get_value() );
+			}
+		}
+	}
 
 	return;
 }
 
+/*
+	log a value as text, INT_MAX as inf
+	for the int programs, or as 4 raw bytes
+*/
+template<typename T>
+void Worker<T>::put_value(int val) {
+	if( val == INT_MAX )
+		logwriter.put_str("inf");
+	else
+		logwriter.put_int(val);
+}
+
+template<typename T>
+void Worker<T>::put_value(float val) {
+	logwriter.put_float(val);
+}
+
+template<typename T>
+void Worker<T>::put_value32(int val) {
+	logwriter.put_int32(val);
+}
+
+template<typename T>
+void Worker<T>::put_value32(float val) {
+	logwriter.put_float32(val);
+}
+
 /*
 	set the graph file name based on 
 	the graphfile name and time of logging
@@ -350,14 +1853,17 @@ void Worker<T>::log_superstep(int superstep) {
 template<typename T>
 string Worker<T>::set_logfilename(string graphstr) {
 
-	string logfilestr = "log/";
+	string logdir = opts.get_string("logdir", "log");
+	mkdir( logdir.c_str(), 0755 );
+	string logfilestr = logdir + "/";
 
 	string graphstr_nodirs;
 	int pos = graphstr.find_last_of('/');
 	graphstr_nodirs = graphstr.substr( pos+1, graphstr.length() - pos -1 );
+	if( graphstr_nodirs.find_last_of('.') != string::npos )
+		graphstr_nodirs.erase( graphstr_nodirs.find_last_of('.') );
 	
 	logfilestr += graphstr_nodirs;
-	logfilestr.erase( logfilestr.find_last_of('.') );
 	logfilestr+="_";
 	
 	time_t ttime;
@@ -369,6 +1875,7 @@ string Worker<T>::set_logfilename(string graphstr) {
 	strftime( buffer, sizeof(buffer), "%Y\%m\%d\%H\%M\%S", gtime);
 	logfilestr+=buffer;
 	logfilestr+=".log";
+	if( log_binary ) logfilestr+=".bin";
 
 	printf("logfile set as: %s\n", logfilestr.c_str() );
 	return logfilestr;
@@ -377,6 +1884,104 @@ string Worker<T>::set_logfilename(string graphstr) {
 
 /** end logging functions **/
 
+/*
+	copy the value of every vertex into values,
+	an array of num_verts
+*/
+template<typename T>
+void Worker<T>::get_values(V* values) {
+	for(int i=0; i<num_verts; i++)
+		values[i] = vert_cont[i].get_value();
+}
+
+/*
+	the program and arguments a run's result depends on, such
+	as the source, set by init_args so the result can be cached.
+	The engine is left out, since every engine gives the same
+	values
+*/
+template<typename T>
+void Worker<T>::set_cache_key(string args) {
+	cacheable = true;
+	cache_key = opts.get_string("program", "") + " " + args;
+}
+
+/*
+	write the value of every vertex to outfile, as text
+	under the header line or, with -outformat binary, as
+	raw 4 byte values.  In text, INT_MAX (or infinite) values
+	are written as the missing string unless it is NULL.
+*/
+template<typename T>
+void Worker<T>::write_values(string outfile, string header, const char* missing) {
+
+	V* values = new V[num_verts];
+	get_values(values);
+
+	ResultWriter writer(num_parts);
+	string format = opts.get_string("outformat", "text");
+	if( !writer.write(outfile, format, header, values, num_verts, missing) )
+		cout << "error: could not write output to " << outfile << endl;
+
+	delete [] values;
+}
+
+/*
+	the performance metrics of the load and run
+*/
+template<typename T>
+Metrics& Worker<T>::get_metrics() {
+	return metrics;
+}
+
+/*
+	the graph the worker runs on, for programs that also
+	search its CSR arrays outside of a superstep
+*/
+template<typename T>
+Graph& Worker<T>::get_graph() {
+	return g;
+}
+
+/*
+	with -cache, the stored result of this graph, program and
+	cache key, if any, read into the vertex values.  False
+	if there is none, or the program set no key
+*/
+template<typename T>
+bool Worker<T>::restore_cached() {
+
+	if( !cacheable || !opts.has("cache") ) return false;
+	if( !hashed ) {
+		graph_hash = ResultCache::hash_csr( num_verts, csr1, csr2, weights );
+		hashed = true;
+	}
+
+	ResultCache cache( opts.get_string("cache", ""), opts.get_int("cachebudget", RC_BUDGET_MB) * (1LL << 20) );
+	V* values = new V[num_verts];
+	bool found = cache.get( graph_hash, cache_key, values, sizeof(V) * (int64_t)num_verts );
+	if( found ) {
+		for(int i=0; i<num_verts; i++)
+			vert_cont[i].set_value( values[i] );
+	}
+	delete [] values;
+	return found;
+}
+
+/* with -cache, store the vertex values of the run just finished */
+template<typename T>
+void Worker<T>::store_cached() {
+
+	if( !cacheable || !opts.has("cache") ) return;
+
+	ResultCache cache( opts.get_string("cache", ""), opts.get_int("cachebudget", RC_BUDGET_MB) * (1LL << 20) );
+	V* values = new V[num_verts];
+	get_values(values);
+	if( !cache.put( graph_hash, cache_key, values, sizeof(V) * (int64_t)num_verts ) )
+		cout << "error: could not write the result to the cache " << opts.get_string("cache", "") << endl;
+	delete [] values;
+}
+
 /** protected member functions **/
 
 template<typename T>
@@ -450,35 +2055,50 @@ void Worker<T>::set_vert_cont(T* vc){
 }
 
 template<typename T>
-Message<int>* Worker<T>::get_out_msgs(){
+Message<typename T::value_type>* Worker<T>::get_out_msgs(){
 	return out_msgs_q;
 }
 
 template<typename T>
-void Worker<T>::set_out_msgs(Message<int>* omq){
+void Worker<T>::set_out_msgs(Message<V>* omq){
 	out_msgs_q = omq;
 }
 
 template<typename T>
-Message<int>* Worker<T>::get_in_msgs(){
+Message<typename T::value_type>* Worker<T>::get_in_msgs(){
 	return in_msgs_q;
 }
 
 template<typename T>
-void Worker<T>::set_in_msgs(Message<int>* imq){
+void Worker<T>::set_in_msgs(Message<V>* imq){
 	in_msgs_q = imq;
 }
 
 template<typename T>
-int Worker<T>::get_num_msgs(){
+long long Worker<T>::get_num_msgs(){
 	return num_messages;
 }
 
 template<typename T>
-void Worker<T>::set_num_msgs(int nm){
+void Worker<T>::set_num_msgs(long long nm){
 	num_messages = nm;
 }
 
+/* the aggregate of the last superstep */
+template<typename T>
+double Worker<T>::get_aggregate(){
+	return aggregate;
+}
+
+/*
+	halt once the aggregate of a superstep is below h,
+	or never if h is negative (the default)
+*/
+template<typename T>
+void Worker<T>::set_halt_aggregate(double h){
+	halt_aggregate = h;
+}
+
 /* 
 	future work
 
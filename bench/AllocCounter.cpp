@@ -0,0 +1,66 @@
+/*
+	Think-Like-A-Vertex Framework, AllocCounter.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the allocation counter.  On glibc, the
+	allocation functions are replaced by ones that count the
+	requested bytes, then call glibc's own implementations.
+	Elsewhere nothing is counted
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <stddef.h>
+#include <atomic>
+
+#include "AllocCounter.h"
+
+static std::atomic<long long> counted_bytes(0);
+static std::atomic<long long> counted_calls(0);
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+
+void* malloc(size_t n) {
+	counted_bytes.fetch_add(n, std::memory_order_relaxed);
+	counted_calls.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(n);
+}
+
+void* calloc(size_t n, size_t size) {
+	counted_bytes.fetch_add(n*size, std::memory_order_relaxed);
+	counted_calls.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t n) {
+	counted_bytes.fetch_add(n, std::memory_order_relaxed);
+	counted_calls.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(ptr, n);
+}
+
+}
+
+bool alloc_counting() { return true; }
+
+#else
+
+bool alloc_counting() { return false; }
+
+#endif
+
+/* bytes requested since the program started */
+long long alloc_bytes() {
+	return counted_bytes.load(std::memory_order_relaxed);
+}
+
+/* allocation calls since the program started */
+long long alloc_calls() {
+	return counted_calls.load(std::memory_order_relaxed);
+}
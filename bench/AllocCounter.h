@@ -0,0 +1,20 @@
+/*
+	Think-Like-A-Vertex Framework, AllocCounter.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Counts heap allocations of the whole process,
+	by interposing malloc, calloc and realloc on glibc.
+	Used by the microbenchmarks to report bytes per operation
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+bool alloc_counting();
+long long alloc_bytes();
+long long alloc_calls();
+
+#endif
@@ -0,0 +1,220 @@
+/*
+	Think-Like-A-Vertex Framework, Generators.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the synthetic graph generators
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <random>
+#include <algorithm>
+#include <stdio.h>
+
+#include "BufferedWriter.h"
+#include "Generators.h"
+
+/*
+	Kronecker/R-MAT generator with the Graph500 initiator
+	A=0.57, B=0.19, C=0.19, D=0.05, producing
+	edgefactor * 2^scale edges, with vertex labels scrambled
+	by a random permutation so degree does not follow the label
+*/
+void generate_rmat(int scale, int edgefactor, unsigned long seed, vector<pair<int,int> >& edges) {
+
+	const double A = 0.57, B = 0.19, C = 0.19;
+	int n = 1 << scale;
+	long long m = (long long)edgefactor * n;
+
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	vector<int> perm(n);
+	for(int i=0; i<n; i++) perm[i] = i;
+	std::shuffle( perm.begin(), perm.end(), rng );
+
+	edges.clear();
+	edges.reserve(m);
+	for(long long e=0; e<m; e++) {
+		int u=0, v=0;
+		for(int bit=0; bit<scale; bit++) {
+			double r = uniform(rng);
+			int u_bit = ( r > A+B );
+			int v_bit = ( r > A && r <= A+B ) || ( r > A+B+C );
+			u = (u << 1) | u_bit;
+			v = (v << 1) | v_bit;
+		}
+		edges.push_back( std::make_pair( perm[u], perm[v] ) );
+	}
+
+	return;
+}
+
+/*
+	Barabasi-Albert preferential attachment with 2^scale vertices,
+	where each new vertex attaches edgefactor edges to existing
+	vertices chosen with probability proportional to degree.
+	Sampling picks a uniform endpoint of the edges so far
+*/
+void generate_barabasi_albert(int scale, int edgefactor, unsigned long seed, vector<pair<int,int> >& edges) {
+
+	int n = 1 << scale;
+	int m = edgefactor;
+	if( m >= n ) m = n-1;
+
+	std::mt19937_64 rng(seed);
+	edges.clear();
+	edges.reserve( (long long)n * m );
+
+	// seed with a star on the first m+1 vertices
+	vector<int> endpoints;
+	endpoints.reserve( 2LL * n * m );
+	for(int v=1; v<=m; v++) {
+		edges.push_back( std::make_pair(0, v) );
+		endpoints.push_back(0);
+		endpoints.push_back(v);
+	}
+
+	vector<int> targets;
+	for(int v=m+1; v<n; v++) {
+		targets.clear();
+		while( (int)targets.size() < m ) {
+			std::uniform_int_distribution<long long> pick(0, endpoints.size()-1);
+			int t = endpoints[ pick(rng) ];
+			if( std::find( targets.begin(), targets.end(), t ) == targets.end() )
+				targets.push_back(t);
+		}
+		for(int i=0; i<m; i++) {
+			edges.push_back( std::make_pair( v, targets[i] ) );
+			endpoints.push_back(v);
+			endpoints.push_back(targets[i]);
+		}
+	}
+
+	return;
+}
+
+/*
+	2D grid of 2^scale vertices, 2^(scale/2) rows
+	by 2^(scale - scale/2) columns, each vertex linked
+	to its right and lower neighbor.  A high-diameter graph
+*/
+void generate_grid2d(int scale, vector<pair<int,int> >& edges) {
+
+	int rows = 1 << (scale/2);
+	int cols = 1 << (scale - scale/2);
+
+	edges.clear();
+	edges.reserve( 2LL * rows * cols );
+	for(int r=0; r<rows; r++) {
+		for(int c=0; c<cols; c++) {
+			int v = r*cols + c;
+			if( c+1 < cols ) edges.push_back( std::make_pair( v, v+1 ) );
+			if( r+1 < rows ) edges.push_back( std::make_pair( v, v+cols ) );
+		}
+	}
+
+	return;
+}
+
+/*
+	generate a graph by name: rmat, ba or grid.
+	returns false for an unknown generator
+*/
+bool generate_graph(string name, int scale, int edgefactor, unsigned long seed, vector<pair<int,int> >& edges) {
+
+	if( name == "rmat" || name == "kronecker" )
+		generate_rmat(scale, edgefactor, seed, edges);
+	else if( name == "ba" )
+		generate_barabasi_albert(scale, edgefactor, seed, edges);
+	else if( name == "grid" )
+		generate_grid2d(scale, edges);
+	else
+		return false;
+
+	return true;
+}
+
+/*
+	a weight from 1 to 100 for an undirected edge,
+	the same in both directions
+*/
+static int edge_weight(int u, int v, unsigned long seed) {
+	unsigned long long lo = std::min(u,v), hi = std::max(u,v);
+	unsigned long long h = (hi << 32 | lo) ^ (seed * 0x9E3779B97F4A7C15ULL);
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return 1 + (int)(h % 100);
+}
+
+/*
+	prepare generated edges for the engine, as edge_preproc does:
+	remove self-loops and duplicates, add reverse edges,
+	relabel the vertices with edges contiguously from 0
+	(keeping their order), sort, and assign symmetric weights.
+	returns the number of vertices
+*/
+int prepare_edgelist(vector<pair<int,int> >& edges, vector<int>& weights, unsigned long seed) {
+
+	int max_id = -1;
+	for(size_t i=0; i<edges.size(); i++)
+		max_id = std::max( max_id, std::max( edges[i].first, edges[i].second ) );
+
+	// both directions of every non-loop edge, packed for sorting
+	vector<unsigned long long> packed;
+	packed.reserve( 2 * edges.size() );
+	for(size_t i=0; i<edges.size(); i++) {
+		unsigned long long u = edges[i].first, v = edges[i].second;
+		if( u == v ) continue;
+		packed.push_back( u << 32 | v );
+		packed.push_back( v << 32 | u );
+	}
+	vector<pair<int,int> >().swap(edges);
+
+	std::sort( packed.begin(), packed.end() );
+	packed.erase( std::unique( packed.begin(), packed.end() ), packed.end() );
+
+	// contiguous labels for the vertices with edges
+	vector<int> label( max_id+1, -1 );
+	for(size_t i=0; i<packed.size(); i++)
+		label[ packed[i] >> 32 ] = 0;
+	int num_verts = 0;
+	for(int v=0; v<=max_id; v++)
+		if( label[v] == 0 ) label[v] = num_verts++;
+
+	// relabeling keeps the order, so the edges stay sorted
+	edges.resize( packed.size() );
+	weights.resize( packed.size() );
+	for(size_t i=0; i<packed.size(); i++) {
+		int u = packed[i] >> 32, v = packed[i] & 0xffffffff;
+		edges[i] = std::make_pair( label[u], label[v] );
+		weights[i] = edge_weight( u, v, seed );
+	}
+
+	return num_verts;
+}
+
+/*
+	write a weighted edgelist in the engine's input format
+*/
+bool write_edgelist(string filename, vector<pair<int,int> >& edges, vector<int>& weights) {
+
+	BufferedWriter out;
+	if( !out.open(filename) ) return false;
+
+	for(size_t i=0; i<edges.size(); i++) {
+		out.put_int( edges[i].first );
+		out.put('\t');
+		out.put_int( edges[i].second );
+		out.put('\t');
+		out.put_int( weights[i] );
+		out.put('\n');
+	}
+	out.close();
+
+	return true;
+}
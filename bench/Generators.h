@@ -0,0 +1,34 @@
+/*
+	Think-Like-A-Vertex Framework, Generators.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Synthetic graph generators for benchmarking:
+	Kronecker/R-MAT (Graph500 parameters), Barabasi-Albert
+	preferential attachment, and 2D grids.
+
+	Generated edges are prepared the same way edge_preproc
+	prepares an edgelist, so the engine can load them
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <string>
+#include <vector>
+#include <utility>
+using std::pair;
+using std::string;
+using std::vector;
+
+void generate_rmat(int, int, unsigned long, vector<pair<int,int> >&);
+void generate_barabasi_albert(int, int, unsigned long, vector<pair<int,int> >&);
+void generate_grid2d(int, vector<pair<int,int> >&);
+bool generate_graph(string, int, int, unsigned long, vector<pair<int,int> >&);
+
+int prepare_edgelist(vector<pair<int,int> >&, vector<int>&, unsigned long);
+bool write_edgelist(string, vector<pair<int,int> >&, vector<int>&);
+
+#endif
@@ -0,0 +1,363 @@
+/*
+	Think-Like-A-Vertex Framework, main_bench.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Graph500-style end-to-end benchmark of the TLAV programs.
+
+	Generates a synthetic graph, prepares and writes it as
+	an edgelist, then for each kernel (bfs, sssp, cc) times the
+	construction of the Worker (loading and initializing the graph)
+	separately from the kernel runs from sampled sources.
+	Every run is validated against a simple sequential reference,
+	and the kernel times and traversed edges per second (TEPS)
+	are reported with quartiles, harmonic mean TEPS, and its
+	standard deviation.
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "gpregellib.h"
+#include "WorkerBFS.h"
+#include "VertexBFS.h"
+#include "WorkerSSSP.h"
+#include "VertexSSSP.h"
+#include "WorkerCC.h"
+#include "VertexCC.h"
+#include "Generators.h"
+
+#include <vector>
+#include <queue>
+#include <random>
+#include <unistd.h>
+#include <cmath>
+
+using namespace std;
+
+/* the prepared graph, in CSR form for the references */
+struct BenchGraph {
+	int num_verts;
+	vector<int> offsets;
+	vector<int> neighbors;
+	vector<int> weights;
+};
+
+void build_csr(vector<pair<int,int> >&, vector<int>&, int, BenchGraph&);
+void sample_sources(BenchGraph&, int, unsigned long, vector<int>&);
+void reference_bfs(BenchGraph&, int, vector<int>&);
+void reference_sssp(BenchGraph&, int, vector<int>&);
+void reference_cc(BenchGraph&, vector<int>&);
+long long component_edges(BenchGraph&, vector<int>&);
+bool validate(vector<int>&, vector<int>&, string);
+void print_stats(string, vector<double>&, bool);
+
+/*
+	Benchmark main program
+*/
+int main(int argc, char* argv[]) {
+
+	Options opts(argc, argv, 1);
+	if( opts.has("help") ) {
+		printf("usage: ./tlav_bench  [-gen rmat|ba|grid] [-scale s] [-edgefactor e]\n"
+			"                    [-kernels bfs,sssp,cc] [-sources k] [-seed n]\n"
+			"                    [-tmpdir dir] [-keep] [Worker options, e.g. -threads n]\n");
+		return 0;
+	}
+
+	string gen = opts.get_string("gen", "rmat");
+	int scale = opts.get_int("scale", 14);
+	int edgefactor = opts.get_int("edgefactor", 16);
+	unsigned long seed = opts.get_int("seed", 1);
+	int num_sources = opts.get_int("sources", 16);
+	string kernels = opts.get_string("kernels", "bfs,sssp,cc");
+	opts.set("quiet", "1");
+
+	/* generate, prepare and write the graph */
+	vector<pair<int,int> > edges;
+	vector<int> weights;
+
+	double start = Metrics::now();
+	if( !generate_graph(gen, scale, edgefactor, seed, edges) ) {
+		printf("error: unknown generator %s, use rmat, ba or grid\n", gen.c_str() );
+		return -1;
+	}
+	double gen_time = Metrics::now() - start;
+	long long generated = edges.size();
+
+	start = Metrics::now();
+	int num_verts = prepare_edgelist(edges, weights, seed);
+	double prep_time = Metrics::now() - start;
+
+	char filename[256];
+	snprintf(filename, sizeof(filename), "%s/tlav_bench_%s_s%d_e%d_%d.txt",
+		opts.get_string("tmpdir", "/tmp").c_str(), gen.c_str(), scale, edgefactor, (int)getpid() );
+	start = Metrics::now();
+	if( !write_edgelist(filename, edges, weights) ) return -1;
+	double write_time = Metrics::now() - start;
+
+	BenchGraph graph;
+	build_csr(edges, weights, num_verts, graph);
+	vector<pair<int,int> >().swap(edges);
+	vector<int>().swap(weights);
+
+	printf("graph: %s  scale: %d  edgefactor: %d  seed: %lu\n", gen.c_str(), scale, edgefactor, seed);
+	printf("generated_edges: %lld\n", generated);
+	printf("num_vertices: %d\n", num_verts);
+	printf("num_directed_edges: %d\n", (int)graph.neighbors.size() );
+	printf("generation_time: %.6f\n", gen_time);
+	printf("preparation_time: %.6f\n", prep_time);
+	printf("edgelist_write_time: %.6f\n", write_time);
+
+	vector<int> sources;
+	sample_sources(graph, num_sources, seed, sources);
+
+	/* run each kernel */
+	bool all_valid = true;
+	vector<int> values(num_verts), reference;
+	string kernel;
+	size_t pos = 0;
+	while( pos <= kernels.size() ) {
+		size_t comma = kernels.find(',', pos);
+		if( comma == string::npos ) comma = kernels.size();
+		kernel = kernels.substr(pos, comma-pos);
+		pos = comma+1;
+		if( kernel.size() == 0 ) continue;
+
+		vector<double> times, teps;
+		bool valid = true;
+		double construction;
+
+		if( kernel == "bfs" ) {
+			start = Metrics::now();
+			WorkerBFS<VertexBFS> worker(filename, opts);
+			construction = Metrics::now() - start;
+			for(size_t i=0; i<sources.size(); i++) {
+				worker.init_args(1, sources[i]);
+				start = Metrics::now();
+				worker.run();
+				times.push_back( Metrics::now() - start );
+				worker.get_values( &values[0] );
+				reference_bfs(graph, sources[i], reference);
+				valid = validate(values, reference, kernel) && valid;
+				teps.push_back( component_edges(graph, reference) / times.back() );
+			}
+		} else if( kernel == "sssp" ) {
+			start = Metrics::now();
+			WorkerSSSP<VertexSSSP> worker(filename, opts);
+			construction = Metrics::now() - start;
+			for(size_t i=0; i<sources.size(); i++) {
+				worker.init_args(1, sources[i]);
+				start = Metrics::now();
+				worker.run();
+				times.push_back( Metrics::now() - start );
+				worker.get_values( &values[0] );
+				reference_sssp(graph, sources[i], reference);
+				valid = validate(values, reference, kernel) && valid;
+				teps.push_back( component_edges(graph, reference) / times.back() );
+			}
+		} else if( kernel == "cc" ) {
+			start = Metrics::now();
+			WorkerCC<VertexCC> worker(filename, opts);
+			construction = Metrics::now() - start;
+			reference_cc(graph, reference);
+			for(size_t i=0; i<sources.size(); i++) {
+				worker.init_args(0);
+				start = Metrics::now();
+				worker.run();
+				times.push_back( Metrics::now() - start );
+				worker.get_values( &values[0] );
+				valid = validate(values, reference, kernel) && valid;
+				teps.push_back( graph.neighbors.size() / 2 / times.back() );
+			}
+		} else {
+			printf("error: unknown kernel %s, use bfs, sssp or cc\n", kernel.c_str() );
+			continue;
+		}
+
+		printf("\nkernel: %s\n", kernel.c_str() );
+		printf("construction_time: %.6f\n", construction);
+		printf("num_runs: %d\n", (int)times.size() );
+		print_stats("time", times, false);
+		print_stats("TEPS", teps, true);
+		printf("validation: %s\n", valid ? "passed" : "FAILED");
+		all_valid = all_valid && valid;
+	}
+
+	if( !opts.has("keep") )
+		unlink(filename);
+	else
+		printf("\nedgelist kept as %s\n", filename);
+
+	return all_valid ? 0 : 1;
+}
+
+/*
+	CSR of the prepared, sorted edgelist
+*/
+void build_csr(vector<pair<int,int> >& edges, vector<int>& weights, int num_verts, BenchGraph& graph) {
+
+	graph.num_verts = num_verts;
+	graph.offsets.assign(num_verts+1, 0);
+	graph.neighbors.resize( edges.size() );
+	graph.weights = weights;
+	for(size_t i=0; i<edges.size(); i++) {
+		graph.offsets[ edges[i].first+1 ]++;
+		graph.neighbors[i] = edges[i].second;
+	}
+	for(int v=0; v<num_verts; v++)
+		graph.offsets[v+1] += graph.offsets[v];
+
+	return;
+}
+
+/*
+	sample distinct source vertices uniformly,
+	every prepared vertex has at least one edge
+*/
+void sample_sources(BenchGraph& graph, int k, unsigned long seed, vector<int>& sources) {
+
+	std::mt19937_64 rng(seed ^ 0x5eed);
+	if( k > graph.num_verts ) k = graph.num_verts;
+
+	vector<int> ids( graph.num_verts );
+	for(int v=0; v<graph.num_verts; v++) ids[v] = v;
+	for(int i=0; i<k; i++) {
+		std::uniform_int_distribution<int> pick(i, graph.num_verts-1);
+		std::swap( ids[i], ids[ pick(rng) ] );
+		sources.push_back( ids[i] );
+	}
+
+	return;
+}
+
+/* hops from the source with a queue, INT_MAX if unreached */
+void reference_bfs(BenchGraph& graph, int src, vector<int>& level) {
+
+	level.assign(graph.num_verts, INT_MAX);
+	vector<int> frontier;
+	frontier.push_back(src);
+	level[src] = 0;
+	for(size_t i=0; i<frontier.size(); i++) {
+		int u = frontier[i];
+		for(int e=graph.offsets[u]; e<graph.offsets[u+1]; e++) {
+			int v = graph.neighbors[e];
+			if( level[v] == INT_MAX ) {
+				level[v] = level[u]+1;
+				frontier.push_back(v);
+			}
+		}
+	}
+
+	return;
+}
+
+/* distances from the source with Dijkstra, INT_MAX if unreached */
+void reference_sssp(BenchGraph& graph, int src, vector<int>& dist) {
+
+	dist.assign(graph.num_verts, INT_MAX);
+	priority_queue< pair<int,int>, vector<pair<int,int> >, greater<pair<int,int> > > heap;
+	dist[src] = 0;
+	heap.push( make_pair(0, src) );
+	while( !heap.empty() ) {
+		int d = heap.top().first, u = heap.top().second;
+		heap.pop();
+		if( d > dist[u] ) continue;
+		for(int e=graph.offsets[u]; e<graph.offsets[u+1]; e++) {
+			int v = graph.neighbors[e];
+			int nd = d + graph.weights[e];
+			if( nd < dist[v] ) {
+				dist[v] = nd;
+				heap.push( make_pair(nd, v) );
+			}
+		}
+	}
+
+	return;
+}
+
+/* smallest vertex id of each component, with union-find */
+void reference_cc(BenchGraph& graph, vector<int>& label) {
+
+	label.resize(graph.num_verts);
+	for(int v=0; v<graph.num_verts; v++) label[v] = v;
+	for(int u=0; u<graph.num_verts; u++) {
+		for(int e=graph.offsets[u]; e<graph.offsets[u+1]; e++) {
+			int a = u, b = graph.neighbors[e];
+			while( label[a] != a ) a = label[a] = label[label[a]];
+			while( label[b] != b ) b = label[b] = label[label[b]];
+			if( a < b ) label[b] = a;
+			else if( b < a ) label[a] = b;
+		}
+	}
+	for(int v=0; v<graph.num_verts; v++)
+		label[v] = label[ label[v] ];
+
+	return;
+}
+
+/*
+	undirected edges in the component reached from the source,
+	the Graph500 definition of traversed edges
+*/
+long long component_edges(BenchGraph& graph, vector<int>& reached) {
+	long long edges = 0;
+	for(int v=0; v<graph.num_verts; v++)
+		if( reached[v] != INT_MAX )
+			edges += graph.offsets[v+1] - graph.offsets[v];
+	return edges / 2;
+}
+
+/* compare a result with its reference */
+bool validate(vector<int>& values, vector<int>& reference, string kernel) {
+	for(size_t v=0; v<values.size(); v++) {
+		if( values[v] != reference[v] ) {
+			printf("validation error: %s vertex %d has %d, expected %d\n",
+				kernel.c_str(), (int)v, values[v], reference[v] );
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+	print min, quartiles, max, mean and standard deviation.
+	for rates, also the harmonic mean and its standard deviation,
+	as in the Graph500 output
+*/
+void print_stats(string name, vector<double>& x, bool rate) {
+
+	int n = x.size();
+	if( n == 0 ) return;
+	vector<double> s = x;
+	sort( s.begin(), s.end() );
+
+	double mean = 0;
+	for(int i=0; i<n; i++) mean += s[i];
+	mean /= n;
+	double var = 0;
+	for(int i=0; i<n; i++) var += (s[i]-mean) * (s[i]-mean);
+	double stddev = ( n > 1 ) ? sqrt( var / (n-1) ) : 0;
+
+	printf("min_%s: %.6e\n", name.c_str(), s[0] );
+	printf("firstquartile_%s: %.6e\n", name.c_str(), s[n/4] );
+	printf("median_%s: %.6e\n", name.c_str(), s[n/2] );
+	printf("thirdquartile_%s: %.6e\n", name.c_str(), s[(3*n)/4 < n ? (3*n)/4 : n-1] );
+	printf("max_%s: %.6e\n", name.c_str(), s[n-1] );
+	printf("mean_%s: %.6e\n", name.c_str(), mean );
+	printf("stddev_%s: %.6e\n", name.c_str(), stddev );
+
+	if( !rate ) return;
+
+	double inv_mean = 0;
+	for(int i=0; i<n; i++) inv_mean += 1.0 / s[i];
+	inv_mean /= n;
+	double inv_var = 0;
+	for(int i=0; i<n; i++) inv_var += (1.0/s[i] - inv_mean) * (1.0/s[i] - inv_mean);
+	double harmonic = 1.0 / inv_mean;
+	double harmonic_stddev = ( n > 1 ) ? sqrt( inv_var / (n-1) ) * harmonic * harmonic / sqrt((double)n) : 0;
+
+	printf("harmonic_mean_%s: %.6e\n", name.c_str(), harmonic );
+	printf("harmonic_stddev_%s: %.6e\n", name.c_str(), harmonic_stddev );
+
+	return;
+}
@@ -0,0 +1,424 @@
+/*
+	Think-Like-A-Vertex Framework, main_microbench.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Microbenchmarks of the engine's hot functions in isolation:
+	the Worker's write_messages, deliver_messages, process_inbox
+	and log_superstep, loading a Graph from an edgelist,
+	and DynamicArray::push_back growth.
+
+	Inputs are controlled by the generator (the degree distribution),
+	and the frontier density (the fraction of active vertices,
+	which sets the number of messages).  Each benchmark is warmed up,
+	then repeated, reporting the median ns and bytes allocated
+	per operation.  Results can be saved as a baseline and later
+	runs compared against it.
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "gpregellib.h"
+#include "WorkerBFS.h"
+#include "VertexBFS.h"
+#include "Generators.h"
+#include "AllocCounter.h"
+#include "DynamicArray.h"
+
+#include <map>
+#include <vector>
+#include <random>
+#include <functional>
+#include <unistd.h>
+
+using namespace std;
+
+/* the result of one benchmark */
+struct BenchResult {
+	string name;
+	long long ops;
+	double ns_per_op;
+	double min_ns_per_op;
+	double bytes_per_op;
+};
+
+/*
+	Runs the microbenchmarks.  A friend of the Worker,
+	so it can drive the phases of a superstep directly
+*/
+class MicroBench {
+
+	public:
+		MicroBench(Options&);
+		void run();
+		bool compare(string, double);
+		void save(string);
+
+	private:
+		typedef WorkerBFS<VertexBFS> BenchWorker;
+		typedef void (Worker<VertexBFS>::*Phase)(int);
+
+		void bench_graph(string);
+		void bench_phases(string, BenchWorker&);
+		void bench_logging(string, BenchWorker&);
+		void bench_push_back(string, long long);
+
+		long long set_frontier(BenchWorker&, double);
+		void measure(string, long long, function<void()>, function<void()>, function<void()>);
+
+		Options opts;
+		int warmup;
+		int reps;
+		unsigned long seed;
+		vector<double> densities;
+		vector<BenchResult> results;
+
+};
+
+/*
+	Microbenchmark main program
+*/
+int main(int argc, char* argv[]) {
+
+	Options opts(argc, argv, 1);
+	if( opts.has("help") ) {
+		printf("usage: ./tlav_microbench  [-gen rmat,grid] [-scale s] [-edgefactor e]\n"
+			"                         [-density 0.01,0.1,0.5,1] [-reps r] [-warmup w]\n"
+			"                         [-save file] [-baseline file] [-tolerance pct]\n"
+			"                         [-tmpdir dir] [Worker options, e.g. -threads n]\n");
+		return 0;
+	}
+	opts.set("quiet", "1");
+
+	// the phases measured are those of the vertex engine, on the
+	// threads asked for, not whatever the planner would pick
+	if( !opts.has("engine") ) opts.set("engine", "vertex");
+	if( !opts.has("threads") && !opts.has("numa") ) opts.set("threads", "1");
+
+	MicroBench bench(opts);
+	bench.run();
+
+	if( opts.has("save") )
+		bench.save( opts.get_string("save", "") );
+	if( opts.has("baseline") ) {
+		if( !bench.compare( opts.get_string("baseline", ""), opts.get_double("tolerance", 10) ) )
+			return 1;
+	}
+
+	return 0;
+}
+
+/* split a comma separated list */
+static vector<string> split_list(string list) {
+	vector<string> items;
+	size_t pos = 0;
+	while( pos <= list.size() ) {
+		size_t comma = list.find(',', pos);
+		if( comma == string::npos ) comma = list.size();
+		if( comma > pos ) items.push_back( list.substr(pos, comma-pos) );
+		pos = comma+1;
+	}
+	return items;
+}
+
+/* Constructor, read the benchmark options */
+MicroBench::MicroBench(Options& _opts) {
+	opts = _opts;
+	warmup = opts.get_int("warmup", 2);
+	reps = opts.get_int("reps", 10);
+	if( reps < 1 ) reps = 1;
+	seed = opts.get_int("seed", 1);
+	vector<string> d = split_list( opts.get_string("density", "0.01,0.1,0.5,1") );
+	for(size_t i=0; i<d.size(); i++)
+		densities.push_back( atof( d[i].c_str() ) );
+}
+
+/*
+	for each generator, build a graph, write it as an edgelist,
+	and benchmark every function on it
+*/
+void MicroBench::run() {
+
+	int scale = opts.get_int("scale", 16);
+	int edgefactor = opts.get_int("edgefactor", 16);
+	vector<string> gens = split_list( opts.get_string("gen", "rmat,grid") );
+
+	printf("%-40s %12s %12s %12s %12s\n", "benchmark", "ops", "ns/op", "min_ns/op", "bytes/op");
+
+	for(size_t g=0; g<gens.size(); g++) {
+
+		vector<pair<int,int> > edges;
+		vector<int> weights;
+		if( !generate_graph(gens[g], scale, edgefactor, seed, edges) ) {
+			printf("error: unknown generator %s, use rmat, ba or grid\n", gens[g].c_str() );
+			continue;
+		}
+		prepare_edgelist(edges, weights, seed);
+
+		char filename[256];
+		snprintf(filename, sizeof(filename), "%s/tlav_microbench_%s_%d.txt",
+			opts.get_string("tmpdir", "/tmp").c_str(), gens[g].c_str(), (int)getpid() );
+		write_edgelist(filename, edges, weights);
+		long long num_edges = edges.size();
+		vector<pair<int,int> >().swap(edges);
+		vector<int>().swap(weights);
+
+		bench_graph(gens[g] + "|" + filename);
+		bench_push_back(gens[g], num_edges);
+		{
+			BenchWorker worker(filename, opts);
+			bench_phases(gens[g], worker);
+			bench_logging(gens[g], worker);
+		}
+
+		unlink(filename);
+	}
+
+	if( !alloc_counting() )
+		printf("note: allocations are not counted on this platform, bytes/op is 0\n");
+
+	return;
+}
+
+/*
+	warm up, then time body over the repetitions, running
+	setup before and teardown after each, outside the timing.
+	reports the median and minimum per operation
+*/
+void MicroBench::measure(string name, long long ops, function<void()> setup,
+		function<void()> body, function<void()> teardown) {
+
+	vector<double> times, bytes;
+	for(int i=0; i<warmup+reps; i++) {
+		setup();
+		long long a0 = alloc_bytes();
+		double t0 = Metrics::now();
+		body();
+		double t = Metrics::now() - t0;
+		long long a = alloc_bytes() - a0;
+		teardown();
+		if( i >= warmup ) {
+			times.push_back(t);
+			bytes.push_back(a);
+		}
+	}
+	sort( times.begin(), times.end() );
+	sort( bytes.begin(), bytes.end() );
+
+	BenchResult r;
+	r.name = name;
+	r.ops = ops > 0 ? ops : 1;
+	r.ns_per_op = times[ times.size()/2 ] * 1e9 / r.ops;
+	r.min_ns_per_op = times[0] * 1e9 / r.ops;
+	r.bytes_per_op = bytes[ bytes.size()/2 ] / r.ops;
+	results.push_back(r);
+
+	printf("%-40s %12lld %12.3f %12.3f %12.3f\n", r.name.c_str(), r.ops, r.ns_per_op, r.min_ns_per_op, r.bytes_per_op );
+	fflush(stdout);
+}
+
+/*
+	Graph::init_from_edgelist, i.e. create_csr_from_edgelist,
+	per directed edge.  spec is "gen|filename"
+*/
+void MicroBench::bench_graph(string spec) {
+
+	string gen = spec.substr(0, spec.find('|'));
+	string filename = spec.substr(spec.find('|')+1);
+
+	Graph* graph = NULL;
+	long long num_edges = 0;
+	{
+		Graph probe;
+		probe.init_from_edgelist(filename);
+		num_edges = probe.get_num_dir_edges();
+	}
+
+	measure( "graph_load/" + gen, num_edges,
+		[&]() { graph = new Graph(); },
+		[&]() { graph->init_from_edgelist(filename); },
+		[&]() { delete graph; graph = NULL; } );
+}
+
+/*
+	DynamicArray::push_back growth from empty,
+	per element, for as many elements as the graph has edges
+*/
+void MicroBench::bench_push_back(string gen, long long n) {
+
+	DynamicArray* array = NULL;
+	measure( "dynamic_array_push_back/" + gen, n,
+		[&]() { array = new DynamicArray(); },
+		[&]() { for(long long i=0; i<n; i++) array->push_back( (int)i ); },
+		[&]() { delete array; array = NULL; } );
+}
+
+/*
+	reset every vertex to unreached and inactive, then
+	activate a random fraction of them with value 0.
+	returns the number of messages the frontier will write
+*/
+long long MicroBench::set_frontier(BenchWorker& w, double density) {
+
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	long long messages = 0;
+	VertexBFS* verts = w.vert_cont;
+	for(int i=0; i<w.num_verts; i++) {
+		if( uniform(rng) < density ) {
+			verts[i].set_value(0);
+			verts[i].set_active(true);
+			messages += verts[i].get_degree();
+		} else {
+			verts[i].set_value(INT_MAX);
+			verts[i].set_active(false);
+		}
+	}
+	return messages;
+}
+
+/*
+	the three phases of a superstep, each per message,
+	at every frontier density
+*/
+void MicroBench::bench_phases(string gen, BenchWorker& w) {
+
+	Phase write = &Worker<VertexBFS>::write_messages;
+	Phase deliver = &Worker<VertexBFS>::deliver_messages;
+	Phase process = &Worker<VertexBFS>::process_inbox;
+	function<void()> none = [](){};
+
+	for(size_t i=0; i<densities.size(); i++) {
+		double d = densities[i];
+		char suffix[64];
+		snprintf(suffix, sizeof(suffix), "/%s/d%g", gen.c_str(), d);
+		long long msgs = set_frontier(w, d);
+
+		measure( string("write_messages") + suffix, msgs,
+			[&]() { set_frontier(w, d); },
+			[&]() { w.run_partitions(write); },
+			none );
+
+		measure( string("deliver_messages") + suffix, msgs,
+			[&]() { set_frontier(w, d); w.run_partitions(write); },
+			[&]() { w.run_partitions(deliver); },
+			none );
+
+		measure( string("process_inbox") + suffix, msgs,
+			[&]() { set_frontier(w, d); w.run_partitions(write); w.run_partitions(deliver); },
+			[&]() { w.run_partitions(process); },
+			none );
+	}
+
+	set_frontier(w, 0);
+	return;
+}
+
+/*
+	log_superstep at each level and format, per vertex,
+	after a superstep at the middle frontier density.
+	the log is written to /dev/null, and the body includes
+	waiting for the writer thread
+*/
+void MicroBench::bench_logging(string gen, BenchWorker& w) {
+
+	const char* levels[] = { "summary", "delta", "full" };
+	double d = densities[ densities.size()/2 ];
+	Phase write = &Worker<VertexBFS>::write_messages;
+	Phase deliver = &Worker<VertexBFS>::deliver_messages;
+	Phase process = &Worker<VertexBFS>::process_inbox;
+
+	if( !w.logwriter.open("/dev/null") ) return;
+	w.set_logging(true);
+
+	for(int binary=0; binary<2; binary++) {
+		for(int l=0; l<3; l++) {
+			w.log_level = LOG_SUMMARY + l;
+			w.log_binary = binary;
+			char name[96];
+			snprintf(name, sizeof(name), "log_superstep/%s/%s/%s", gen.c_str(), levels[l], binary ? "binary" : "text");
+
+			// a superstep of messages, then vertex changes since the delta snapshot
+			measure( name, w.num_verts,
+				[&]() {
+					set_frontier(w, d);
+					w.run_partitions(write);
+					w.run_partitions(deliver);
+					delete [] w.log_prev;
+					w.log_prev = NULL;
+					if( w.log_level == LOG_DELTA ) w.log_superstep(1);
+					w.run_partitions(process);
+					w.logwriter.flush();
+				},
+				[&]() { w.log_superstep(2); w.logwriter.flush(); },
+				[](){} );
+		}
+	}
+
+	w.logwriter.close();
+	w.set_logging(false);
+	set_frontier(w, 0);
+	return;
+}
+
+/*
+	save the results as a baseline, one benchmark per line
+*/
+void MicroBench::save(string filename) {
+
+	FILE* out = fopen( filename.c_str(), "w" );
+	if( out == NULL ) {
+		printf("error: cannot write baseline %s\n", filename.c_str() );
+		return;
+	}
+	fprintf(out, "# benchmark ns_per_op bytes_per_op\n");
+	for(size_t i=0; i<results.size(); i++)
+		fprintf(out, "%s %.6f %.6f\n", results[i].name.c_str(), results[i].ns_per_op, results[i].bytes_per_op );
+	fclose(out);
+	printf("saved baseline %s\n", filename.c_str() );
+}
+
+/*
+	compare the results against a saved baseline.
+	a benchmark regresses if its ns/op or bytes/op grew by
+	more than tolerance percent.  returns false on any regression
+*/
+bool MicroBench::compare(string filename, double tolerance) {
+
+	ifstream instream( filename.c_str() );
+	if( !instream.is_open() ) {
+		printf("error: cannot read baseline %s\n", filename.c_str() );
+		return false;
+	}
+
+	map<string, pair<double,double> > baseline;
+	string line;
+	while( getline(instream, line) ) {
+		if( line.size() == 0 || line[0] == '#' ) continue;
+		char name[256];
+		double ns, bytes;
+		if( sscanf( line.c_str(), "%255s %lf %lf", name, &ns, &bytes ) == 3 )
+			baseline[name] = make_pair(ns, bytes);
+	}
+
+	printf("\n%-40s %12s %12s %10s %10s\n", "benchmark", "base_ns/op", "ns/op", "time", "bytes");
+	int regressions = 0;
+	for(size_t i=0; i<results.size(); i++) {
+		BenchResult& r = results[i];
+		map<string, pair<double,double> >::iterator itr = baseline.find(r.name);
+		if( itr == baseline.end() ) {
+			printf("%-40s %12s %12.3f %10s\n", r.name.c_str(), "-", r.ns_per_op, "new");
+			continue;
+		}
+		double base_ns = itr->second.first, base_bytes = itr->second.second;
+		double dt = base_ns > 0 ? 100.0 * (r.ns_per_op - base_ns) / base_ns : 0;
+		double db = base_bytes > 0 ? 100.0 * (r.bytes_per_op - base_bytes) / base_bytes : ( r.bytes_per_op > 0 ? 100.0 : 0 );
+		bool regressed = dt > tolerance || db > tolerance;
+		if( regressed ) regressions++;
+		printf("%-40s %12.3f %12.3f %+9.1f%% %+9.1f%%%s\n", r.name.c_str(), base_ns, r.ns_per_op, dt, db,
+			regressed ? "  REGRESSION" : "" );
+	}
+	printf("%d regressions beyond %.1f%%\n", regressions, tolerance);
+
+	return regressions == 0;
+}
@@ -36,7 +36,7 @@ void VertexBFS::process_message( Message<int>* msg ) {
 	How to compute the value to send out to neighbors.
 	For BFS, we send out our current number of hops, plus 1
 */
-void VertexBFS::send_message( Message<int>* messages_out, int num_messages, int dest_id, int weight ) {
+void VertexBFS::send_message( Message<int>* messages_out, int num_messages, int dest_id, int ) {
 
 	Message<int> msg;
 	msg.set_dest_id(dest_id);
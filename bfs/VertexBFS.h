@@ -20,6 +20,9 @@ class VertexBFS: public Vertex {
 
 		VertexBFS();
 		
+		// keeps the least value, sends its value plus one
+		static const PullSemantics pull_semantics = PULL_MIN_PLUS_ONE;
+
 		virtual void process_message( Message<int>* );
 		virtual void send_message( Message<int>*, int, int, int );
 
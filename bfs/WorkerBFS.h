@@ -10,8 +10,8 @@
 */
 
 
-#ifndef WORKERSSSP_H
-#define WORKERSSSP_H
+#ifndef WORKERBFS_H
+#define WORKERBFS_H
 
 #include "Worker.h"
 #include "gpregellib.h"
@@ -21,6 +21,7 @@ class WorkerBFS: public Worker<T> {
 
 	public:
 		WorkerBFS(string);
+		WorkerBFS(string, Options);
 		void init_args(int, ...);
 		void write_output(string);
 
@@ -31,6 +32,10 @@ class WorkerBFS: public Worker<T> {
 template<typename T>
 WorkerBFS<T>::WorkerBFS(string infile):Worker<T>(infile) {}
 
+/* Constructor with optional arguments */
+template<typename T>
+WorkerBFS<T>::WorkerBFS(string infile, Options opts):Worker<T>(infile, opts) {}
+
 /*
 	Read the arguments to the Worker evocations
 	Gets the bfs source node input by the user
@@ -50,6 +55,7 @@ void WorkerBFS<T>::init_args(int num_args, ...) {
 		cout << "error: src out of range" << endl;
 		exit(-1);
 	}
+	this->set_cache_key( "src=" + to_string(src) );
 
 	T* vert_cont = this->get_vert_cont();
 	int num_verts = this->get_num_verts();
@@ -77,28 +83,7 @@ void WorkerBFS<T>::init_args(int num_args, ...) {
 */
 template<typename T>
 void WorkerBFS<T>::write_output(string outfile) {
-
-	ofstream outstream;
-	outstream.open( outfile.c_str() );
-
-	T vert, *vert_cont;
-	int value, id;
-	outstream << "v_id\tlevel" << endl;
-	for(int i=0; i<this->get_num_verts(); i++) {
-		vert_cont = this->get_vert_cont();
-		vert = vert_cont[i];
-		value = vert.get_value();
-		id = vert.get_id();
-		if( value == INT_MAX ) {
-			outstream << id << "\t" << "unreached" << endl;
-		}	else {	
-			outstream << id << "\t" << value << endl;
-		}
-	}
-
-	outstream.close();
-
-	return;
+	this->write_values(outfile, "v_id\tlevel", "unreached");
 }
 
 #endif
@@ -6,7 +6,9 @@
 	Utilizes BFS worker and vertex classes
 	
 	Input an edgelist and source vertex, and output the 
-	number of hops from the source
+	number of hops from the source.  With -target t, only
+	the hops from the source to t are found, by bidirectional
+	search over the graph's CSR arrays
 
 	This software is distributed under 
 	the modified Berkeley Software Distribution (BSD) License.
@@ -14,17 +16,86 @@
 #include "gpregellib.h"
 #include "WorkerBFS.h"
 #include "VertexBFS.h"
+#include "BidirectionalBfs.h"
 
 using namespace std;
 
+/*
+	the hops from src to the target by bidirectional search,
+	written as the level of the target, or with -path the
+	level of every vertex on a shortest path in order
+*/
+int run_point_to_point(string graphfile, int src, string outfile, Options& opts) {
+
+	Metrics metrics;
+	metrics.set_program("bfs");
+
+	double start = Metrics::now();
+	Graph g;
+	g.set_reader( opts.get_string("reader", "auto") );
+	g.init_from_edgelist(graphfile);
+	int num_verts = g.get_num_verts();
+	metrics.set_load_time( Metrics::now() - start );
+	metrics.set_graph( num_verts, g.get_num_dir_edges() );
+	printf("loaded %d nodes and %d edges\n", num_verts, g.get_num_dir_edges());
+
+	int dst = opts.get_int("target", -1);
+	if( src < 0 || src >= num_verts || dst < 0 || dst >= num_verts ) {
+		cout << "error: src or target out of range" << endl;
+		return -1;
+	}
+
+	BidirectionalBfs search( num_verts, g.get_csr1(), g.get_csr2() );
+	start = Metrics::now();
+	int hops = search.query(src, dst);
+	metrics.set_run_time( Metrics::now() - start );
+	metrics.add_field( "hops", hops );
+	metrics.add_field( "visited", search.get_verts_visited() );
+	metrics.add_field( "edges_scanned", search.get_edges_scanned() );
+
+	if( hops < 0 ) printf("hops: unreached\n");
+	else printf("hops: %d\n", hops);
+	if( !opts.has("quiet") )
+		printf("load %.3f s, query %.6f s, %d vertices visited, %lld edges scanned\n", metrics.get_load_time(),
+			metrics.get_run_time(), search.get_verts_visited(), search.get_edges_scanned() );
+	if( opts.has("metrics") )
+		metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
+
+	vector<int> path;
+	if( opts.has("path") ) path = search.get_path();
+	else if( hops >= 0 ) path.push_back(dst);
+
+	BufferedWriter out;
+	if( !out.open(outfile, false) ) {
+		cout << "error: could not write output to " << outfile << endl;
+		return -1;
+	}
+	out.put_str("v_id\tlevel\n");
+	for(size_t i=0; i<path.size(); i++) {
+		out.put_int( path[i] );
+		out.put('\t');
+		out.put_int( ( i+1 == path.size() ) ? hops : (int)i );
+		out.put('\n');
+	}
+	if( hops < 0 ) {
+		out.put_int(dst);
+		out.put_str("\tunreached\n");
+	}
+	out.close();
+
+	printf("Complete\n");
+
+	return 0;
+}
+
 /*
 	main driver program
 */
 int main(int argc, char* argv[]) {
 
 	//inputs
-	if( argc != 4 ) {
-		printf("usage: ./pregel_bfs  edgelist_in  src  outfile\n");
+	if( argc < 4 ) {
+		printf("usage: ./pregel_bfs  edgelist_in  src  outfile  [-threads n] [-numa] [-target t [-path]]\n");
 		return -1;
 	}
 	
@@ -32,12 +103,17 @@ int main(int argc, char* argv[]) {
 	string graphfile = argv[1];
 	int src = atoi(argv[2]);
 	string outfile = argv[3];
+	Options opts(argc, argv, 4);
+	opts.set("program", "bfs");
 
 	printf("Hello World\n");
 	printf("Loading graph %s\n", argv[1]);
+
+	if( opts.has("target") )
+		return run_point_to_point(graphfile, src, outfile, opts);
 	
 	// initialize worker with graph file	
-	WorkerBFS<VertexBFS> worker(graphfile);
+	WorkerBFS<VertexBFS> worker(graphfile, opts);
 	
 	// program takes one input argument (the source vert)
 	int n_args = 1;
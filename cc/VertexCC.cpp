@@ -36,7 +36,7 @@ void VertexCC::process_message( Message<int>* msg ) {
 	When active, send to neighbors a vert's current value,
 	i.e. send your current connected component id 
 */
-void VertexCC::send_message( Message<int>* messages_out, int num_messages, int dest_id, int weight ) {
+void VertexCC::send_message( Message<int>* messages_out, int num_messages, int dest_id, int ) {
 
 	Message<int> msg;
 	msg.set_dest_id(dest_id);
@@ -19,6 +19,9 @@ class VertexCC: public Vertex {
 
 		VertexCC();
 		
+		// keeps the least value, sends its value
+		static const PullSemantics pull_semantics = PULL_MIN;
+
 		// implement the two Vertex virtual functions
 		virtual void process_message( Message<int>* );
 		virtual void send_message( Message<int>*, int, int, int );
@@ -19,6 +19,7 @@ class WorkerCC: public Worker<T> {
 
 	public:
 		WorkerCC(string);
+		WorkerCC(string, Options);
 		void init_args(int, ...);
 		void write_output(string);
 
@@ -28,14 +29,19 @@ class WorkerCC: public Worker<T> {
 template<typename T>
 WorkerCC<T>::WorkerCC(string infile):Worker<T>(infile) {}
 
+/* Constructor with optional arguments */
+template<typename T>
+WorkerCC<T>::WorkerCC(string infile, Options opts):Worker<T>(infile, opts) {}
+
 /*
 	How to initialize vertices at the start of the program.
 	No input (or source vertex) is required, but list
 	every vertex as active
 */
 template<typename T>
-void WorkerCC<T>::init_args(int num_args, ...) {
+void WorkerCC<T>::init_args(int, ...) {
 	
+	this->set_cache_key("");
 
 	T* vert_cont = this->get_vert_cont();
 	int num_verts = this->get_num_verts();
@@ -56,24 +62,7 @@ void WorkerCC<T>::init_args(int num_args, ...) {
 */
 template<typename T>
 void WorkerCC<T>::write_output(string outfile) {
-
-	ofstream outstream;
-	outstream.open( outfile.c_str() );
-
-	T vert, *vert_cont;
-	int value, id;
-	outstream << "v_id\tcomponent" << endl;
-	vert_cont = this->get_vert_cont();
-	for(int i=0; i<this->get_num_verts(); i++) {
-		vert = vert_cont[i];
-		value = vert.get_value();
-		id = vert.get_id();
-		outstream << id << "\t" << value << endl;
-	}
-
-	outstream.close();
-
-	return;
+	this->write_values(outfile, "v_id\tcomponent", NULL);
 }
 
 #endif
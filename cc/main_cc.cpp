@@ -7,6 +7,8 @@
 	Takes in an edgelist and outputs the connected
 	component of each vertex.  The id of the connected 
 	component is the smallest vert_id among vertices in a component.
+	With -engine unionfind, the components are found by the
+	union-find engine over the graph's CSR arrays instead
 
 	This software is distributed under 
 	the modified Berkeley Software Distribution (BSD) License.
@@ -15,24 +17,96 @@
 #include "gpregellib.h"
 #include "WorkerCC.h"
 #include "VertexCC.h"
+#include "UnionFind.h"
 
 using namespace std;
 
+/*
+	find the components by union-find rather than supersteps,
+	writing the same output as the vertex engine
+*/
+int run_union_find(string graphfile, string outfile, Options& opts) {
+
+	Metrics metrics;
+	metrics.set_program("cc");
+
+	double start = Metrics::now();
+	Graph g;
+	g.set_reader( opts.get_string("reader", "auto") );
+	g.init_from_edgelist(graphfile);
+	int num_verts = g.get_num_verts();
+	metrics.set_load_time( Metrics::now() - start );
+	metrics.set_graph( num_verts, g.get_num_dir_edges() );
+	printf("loaded %d nodes and %d edges\n", num_verts, g.get_num_dir_edges());
+
+	int threads = opts.get_int("threads", 1);
+	ResultWriter writer(threads);
+
+	// with -cache, under the key the vertex engine uses, as the components are the same
+	uint64_t graph_hash = 0;
+	long long cache_budget = opts.get_int("cachebudget", RC_BUDGET_MB) * (1LL << 20);
+	if( opts.has("cache") ) {
+		graph_hash = ResultCache::hash_csr( num_verts, g.get_csr1(), g.get_csr2(), g.get_weights() );
+		ResultCache cache( opts.get_string("cache", ""), cache_budget );
+		vector<int> comp(num_verts);
+		if( cache.get( graph_hash, "cc ", comp.data(), sizeof(int) * (int64_t)num_verts ) ) {
+			printf("restored the result from the cache\n");
+			if( !writer.write(outfile, opts.get_string("outformat", "text"), "v_id\tcomponent", comp.data(), num_verts, NULL) )
+				cout << "error: could not write output to " << outfile << endl;
+			printf("Complete\n");
+			return 0;
+		}
+	}
+
+	UnionFind uf(threads);
+	metrics.set_threads( threads );
+
+	start = Metrics::now();
+	uf.find_components( num_verts, g.get_csr1(), g.get_csr2() );
+	metrics.set_run_time( Metrics::now() - start );
+	metrics.add_field( "components", uf.get_num_components() );
+
+	printf("components: %d\n", uf.get_num_components());
+	if( !opts.has("quiet") )
+		printf("load %.3f s, link %.3f s, %lld edges skipped in the component of %d\n", metrics.get_load_time(),
+			metrics.get_run_time(), uf.get_skipped_edges(), uf.get_skipped_root() );
+	if( opts.has("metrics") )
+		metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
+
+	if( opts.has("cache") ) {
+		ResultCache cache( opts.get_string("cache", ""), cache_budget );
+		if( !cache.put( graph_hash, "cc ", uf.get_components(), sizeof(int) * (int64_t)num_verts ) )
+			cout << "error: could not write the result to the cache " << opts.get_string("cache", "") << endl;
+	}
+
+	if( !writer.write(outfile, opts.get_string("outformat", "text"), "v_id\tcomponent", uf.get_components(), num_verts, NULL) )
+		cout << "error: could not write output to " << outfile << endl;
+
+	printf("Complete\n");
+
+	return 0;
+}
+
 int main(int argc, char* argv[]) {
 
 	//arguments include edgelist in and the string of the file to be outputted
-	if( argc != 3 ) {
-		printf("usage: ./pregel_cc  edgelist_in  outfile\n");
+	if( argc < 3 ) {
+		printf("usage: ./pregel_cc  edgelist_in  outfile  [-threads n] [-numa] [-engine vertex|spmv|atomic|unionfind]\n");
 		return -1;
 	}
 
 	string graphfile = argv[1];
 	string outfile = argv[2];
+	Options opts(argc, argv, 3);
+	opts.set("program", "cc");
 
 	printf("Loading graph %s\n", argv[1]);
+
+	if( opts.get_string("engine", "vertex") == "unionfind" )
+		return run_union_find(graphfile, outfile, opts);
 	
 	// initialize the graph structure in the worker
-	WorkerCC<VertexCC> worker(graphfile);
+	WorkerCC<VertexCC> worker(graphfile, opts);
 	
 	// no input arguments required
 	int n_args = 0;
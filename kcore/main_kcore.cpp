@@ -0,0 +1,75 @@
+/*
+	Think-Like-A-Vertex Framework, main_kcore.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Driver program for k-core decomposition.
+	Utilizes the bucketed peeling engine over the graph's CSR
+	arrays, rather than a Worker, since the vertex-centric
+	h-index formulation sends a message per edge every superstep
+
+	Input an edgelist, and output the coreness of every vertex,
+	the largest k for which it is in the k-core
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "gpregellib.h"
+#include "CorePeeler.h"
+
+using namespace std;
+
+/*
+	main driver program
+*/
+int main(int argc, char* argv[]) {
+
+	//inputs
+	if( argc < 3 ) {
+		printf("usage: ./tlav_kcore  edgelist_in  outfile  [-threads n]\n");
+		return -1;
+	}
+
+	// arguments to variables
+	string graphfile = argv[1];
+	string outfile = argv[2];
+	Options opts(argc, argv, 3);
+
+	Metrics metrics;
+	metrics.set_program("kcore");
+
+	printf("Loading graph %s\n", argv[1]);
+
+	double start = Metrics::now();
+	Graph g;
+	g.set_reader( opts.get_string("reader", "auto") );
+	g.init_from_edgelist(graphfile);
+	int num_verts = g.get_num_verts();
+	metrics.set_load_time( Metrics::now() - start );
+	metrics.set_graph( num_verts, g.get_num_dir_edges() );
+	printf("loaded %d nodes and %d edges\n", num_verts, g.get_num_dir_edges());
+
+	int threads = opts.get_int("threads", 1);
+	CorePeeler peeler(threads);
+	metrics.set_threads( threads );
+
+	start = Metrics::now();
+	peeler.peel( num_verts, g.get_csr1(), g.get_csr2() );
+	metrics.set_run_time( Metrics::now() - start );
+	metrics.add_field( "max_core", peeler.get_max_core() );
+
+	printf("max core: %d\n", peeler.get_max_core());
+	if( !opts.has("quiet") )
+		printf("load %.3f s, peel %.3f s, %lld rounds\n", metrics.get_load_time(),
+			metrics.get_run_time(), peeler.get_num_rounds() );
+	if( opts.has("metrics") )
+		metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
+
+	ResultWriter writer(threads);
+	if( !writer.write(outfile, opts.get_string("outformat", "text"), "v_id\tcoreness", peeler.get_coreness(), num_verts, NULL) )
+		cout << "error: could not write output to " << outfile << endl;
+
+	printf("Complete\n");
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+	Think-Like-A-Vertex Framework, CsrImage.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Layout of a binary CSR image, as written by edge_preproc
+	and loaded by Graph without any parsing.
+
+	The file starts with a fixed header, followed by its
+	sections, each starting at an 8-byte aligned offset
+	given in the header, so the file can also be mapped
+	and used in place:
+
+		offsets		int32[num_verts+1], the CSR row offsets (csr1)
+		neighbors	int32[num_edges], the CSR neighbors (csr2)
+		weights		int32[num_edges], if CSR_WEIGHTED
+		ids		int32[num_verts], each vertex's id in the
+				original edgelist, if CSR_ID_MAP
+
+	Every value is little-endian.  num_edges counts each
+	undirected edge twice, once from each end.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef CSRIMAGE_H
+#define CSRIMAGE_H
+
+#include <stdint.h>
+
+#define CSR_MAGIC "TLAVCSR1"
+#define CSR_MAGIC_LEN 8
+
+// flags
+#define CSR_WEIGHTED 1
+#define CSR_ID_MAP 2
+
+struct CsrHeader {
+	char magic[CSR_MAGIC_LEN];
+	int64_t num_verts;
+	int64_t num_edges;
+	int64_t flags;
+
+	// byte offsets of each section, 0 if absent
+	int64_t offsets_at;
+	int64_t neighbors_at;
+	int64_t weights_at;
+	int64_t ids_at;
+};
+
+/* the offset of the section after one of n int32 values at offset */
+inline int64_t csr_next_section(int64_t offset, int64_t n) {
+	return ( offset + n * 4 + 7 ) & ~(int64_t)7;
+}
+
+#endif
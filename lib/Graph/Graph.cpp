@@ -5,59 +5,71 @@
 	Implementation of a Graph object for TLAV program
 	Used for underlying graph representation 
 
-	Can load graphs in the adjacency or edgelist format
+	Can load graphs in the adjacency or edgelist format.
+	The CSR arrays are sized from counts taken before they
+	are filled, and are all carved from the graph's arena.
+	Edgelists are counted as their blocks arrive from the
+	disk, then parsed in parallel chunks
 	
 	This software is distributed under 
 	the modified Berkeley Software Distribution (BSD) License.
 */
 
-#include<fstream>
-using std::ifstream;
-
 #include<cstdlib>
-using std::atoi;
 
 #include<iostream>
 using std::cout;
 using std::endl;
 
+#include<thread>
+#include<vector>
+using std::vector;
+
 #include "string.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#include "DynamicArray.h"
+#include "Arena.h"
+#include "AsyncReader.h"
 #include "Graph.h"
+#include "CsrImage.h"
 
 /* Constructor */
 Graph::Graph() {
-
+	csr1 = NULL;
+	csr2 = NULL;
+	weights = NULL;
+	read_mode = READ_AUTO;
+	read_uring = false;
 }
 
 /*
 	Initiate a graph given the string of a graphfile
 	Graph file assumed to be stored in adjacency list format.
-	Read the graph and store it as an adjacency list,
-	then convert the internal adjacency list into 
+	Read the graph straight into
 	the compressed sparse row format
 */
 Graph::Graph(string infile) {
 
+	csr1 = NULL;
+	csr2 = NULL;
+	weights = NULL;
+	read_mode = READ_AUTO;
+	read_uring = false;
 	filename = infile;
-	create_adjlist_from_file(filename);
-	create_csr_from_adjlist();
-	remove_adjlist();
+	create_csr_from_adjlist(filename);
 
 }
 
-/* Destructor */
-Graph::~Graph() {
-	delete [] csr1;
-	delete [] csr2;
-}
+/* Destructor, the arena releases the CSR arrays */
+Graph::~Graph() {}
 
 /*
 	Initiate a graph given the string of a graphfile
 	Graph file assumed to be stored in adjacency list format.
-	Read the graph and store it as an adjacency list,
-	then convert the internal adjacency list into 
+	Read the graph straight into
 	the compressed sparse row format
 	
 	Same as constructing a graph with an input file
@@ -65,19 +77,21 @@ Graph::~Graph() {
 void Graph::init(string infile) {
 
 	filename = infile;
-	create_adjlist_from_file(filename);
-	create_csr_from_adjlist();
-	remove_adjlist();
+	create_csr_from_adjlist(filename);
 
 }
 
 /*
 	Initialize a graph given a
-	graphfile written in the edgelist format
+	graphfile written in the edgelist format,
+	or a binary CSR image
 */
 void Graph::init_from_edgelist(string infile) {
 	filename = infile;
-	create_csr_from_edgelist();
+	if( is_csr_image(filename) )
+		load_csr_image();
+	else
+		create_csr_from_edgelist();
 }
 
 /* num verts accessor */
@@ -131,248 +145,548 @@ string Graph::get_filename() {
 	return filename;
 }
 
+/*
+	replace the CSR arrays with copies placed elsewhere
+	in memory, e.g. re-homed onto NUMA nodes,
+	releasing the original arrays.  The copies come from
+	another arena, whose blocks the graph takes over
+*/
+void Graph::replace_csr(int* new_csr1, int* new_csr2, int* new_weights, Arena& from) {
+	arena.release();
+	arena.adopt(from);
+	csr1 = new_csr1;
+	csr2 = new_csr2;
+	weights = new_weights;
+}
+
+/*
+	read edgelists and images by io_uring or pread,
+	or by io_uring where the kernel allows (READ_AUTO)
+*/
+void Graph::set_read_mode(int mode) {
+	read_mode = mode;
+}
+
+/*
+	the read mode by name, as given to the -reader option:
+	auto, uring or pread.  Any other name is an error
+*/
+void Graph::set_reader(string name) {
+	int mode = AsyncReader::parse_mode(name);
+	if( mode < 0 ) {
+		cout << "error: unknown reader " << name << ", use auto, uring or pread" << endl;
+		exit(-1);
+	}
+	read_mode = mode;
+}
+
+/*
+	whether the last edgelist or image was read by io_uring
+*/
+bool Graph::get_read_uring() {
+	return read_uring;
+}
+
 /***** Private functions *****/
 
 /*
-	Create an adjacency list representation
-	of the inputted graph file,
-	assuming the graph is stored in adjacency list format
-	
-	adjacency list stored in 2-D array, where each
-	index stores that verice's neighbors
+	parse an integer from [p,end) as atoi would:
+	leading whitespace, an optional sign, then digits
 */
-void Graph::create_adjlist_from_file(string infile) {
-
-	num_verts = read_adjlist_rows(infile);
-	num_neighbors= new int[num_verts];
-	adjlist=new int*[num_verts];
-	read_row_neighbors(infile);
-	int row_size;
-	num_edges=0;
-	for(int i=0; i<num_verts; i++) {
-		row_size = num_neighbors[i];
-		adjlist[i]=new int[row_size];
-		num_edges+=row_size;
+static inline int parse_int(const char* p, const char* end) {
+	while( p < end && ( *p == ' ' || (*p >= '\t' && *p <= '\r') ) ) p++;
+	bool neg = false;
+	if( p < end && ( *p == '-' || *p == '+' ) ) {
+		neg = ( *p == '-' );
+		p++;
 	}
-	read_adjlist(infile);
-	return;
+	unsigned int v = 0;
+	while( p < end && *p >= '0' && *p <= '9' ) {
+		v = v*10 + (*p - '0');
+		p++;
+	}
+	return neg ? (int)(0u - v) : (int)v;
 }
 
 /*
-	Create a Compressed Sparse Row formmatted
-	graph representation from the 
-	adjacency list representation
+	parse an edgelist line, split on its first and last tabs,
+	with a weight of 1 when there is only one tab
 */
-void Graph::create_csr_from_adjlist() {
-	csr1=new int[num_verts+1];
-  csr2=new int[num_edges];
-	int row_size=0;
-	int edge_count=0;
-	csr1[0]=0;
-	for(int i=0; i<num_verts; i++) {
-		row_size=num_neighbors[i];
-		for(int j=0; j<row_size; j++) {
-			csr2[edge_count] = adjlist[i][j];
-			edge_count++;
+static void parse_weighted_edgeline( const char* line, const char* eol, int* edge ) {
+
+	const char* t1 = (const char*)memchr(line, '\t', eol - line);
+	const char* t2 = t1;
+	if( t1 != NULL ) {
+		for(const char* c=eol-1; c>t1; c--) {
+			if( *c == '\t' ) {
+				t2 = c;
+				break;
+			}
 		}
-		csr1[i+1]=edge_count;
 	}
+
+	// unweighted, a line without tabs is read as both ends
+	if( t1 == t2 ) {
+		edge[0] = parse_int( line, ( t1 != NULL ) ? t1 : eol );
+		edge[1] = parse_int( ( t1 != NULL ) ? t1+1 : line, eol );
+		edge[2]=1;
+	} else { // weighted 
+		edge[0] = parse_int( line, t1 );
+		edge[1] = parse_int( t1+1, t2 );
+		edge[2] = parse_int( t2+1, eol );
+	}
+	
 	return;
+}
+
+/*
+	an edgelist file read into memory by blocks, and split
+	into per-thread chunks of whole blocks.  A chunk parses the
+	lines that start in it, each line an edge, and keeps its
+	row starts, first and last source, and largest label
+*/
+struct EdgelistJob {
+	AsyncReader* reader;
+	const char* text;
+	size_t size;
+	vector<int> newlines;
+	vector<int> block_lines;
+	vector<size_t> bounds;
+	vector< vector<int> > rows;
+	vector<int> first_v1;
+	vector<int> last_v1;
+	vector<int> largest;
+	vector<bool> empty;
+	int* csr2;
+	int* weights;
+};
+
+/*
+	count the newlines of each block as it is read,
+	so counting overlaps the reads still in flight
+*/
+static void count_edgelist_blocks(EdgelistJob* job, int) {
+	int i;
+	while( job->reader->next(i) ) {
+		const ReadPiece& piece = job->reader->get_piece(i);
+		const char* p = piece.dest;
+		const char* end = p + piece.len;
+		int count = 0;
+		while( ( p = (const char*)memchr(p, '\n', end - p) ) != NULL ) {
+			count++;
+			p++;
+		}
+		job->newlines[i] = count;
+	}
+}
 
+/*
+	parse the lines starting in a chunk into the edges from
+	its first line's index, the newlines before the line
+*/
+static void fill_edgelist_chunk(EdgelistJob* job, int t) {
+
+	const char* text = job->text;
+	const char* file_end = text + job->size;
+	size_t lo = job->bounds[t], hi = job->bounds[t+1];
+	int e = job->block_lines[ lo / AR_BLOCK ];
+	const char* p = text + lo;
+	if( lo > 0 ) {
+		const char* nl = (const char*)memchr(text + lo - 1, '\n', hi - (lo - 1));
+		p = ( nl == NULL ) ? text + hi : nl + 1;
+		if( nl != NULL && nl >= text + lo ) e++;
+	}
+	const char* end = text + hi;
+
+	vector<int>& rows = job->rows[t];
+	int edge[3];
+	int v1 = 0, largest = -1;
+	job->empty[t] = ( p >= end );
+	for(bool first=true; p<end; first=false) {
+		const char* eol = (const char*)memchr(p, '\n', file_end - p);
+		if( eol == NULL ) eol = file_end;
+		parse_weighted_edgeline(p, eol, edge);
+		if( first ) job->first_v1[t] = edge[0];
+		if( first || v1 != edge[0] ) {
+			rows.push_back(e);
+			v1 = edge[0];
+		}
+		job->csr2[e] = edge[1];
+		job->weights[e] = edge[2];
+		e++;
+		if( edge[1] > largest ) largest = edge[1];
+		p = eol + 1;
+	}
+	job->last_v1[t] = v1;
+	job->largest[t] = largest;
+}
+
+/*
+	run a pass of an edgelist job, a thread per chunk
+*/
+static void run_edgelist_pass( EdgelistJob* job, int threads, void (*pass)(EdgelistJob*, int) ) {
+	if( threads == 1 ) {
+		pass(job, 0);
+		return;
+	}
+	vector<std::thread> pool;
+	for(int t=0; t<threads; t++)
+		pool.push_back( std::thread(pass, job, t) );
+	for(int t=0; t<threads; t++)
+		pool[t].join();
 }
 
 /* 
 	create the CSR graph representation 
 	from an edgelist file.
 	Utilized the fact that the sorted edgelist
-	can smoothly create the CSR arrays
+	can smoothly create the CSR arrays.
+	Every line is an edge, so a count of the lines sizes the
+	arrays before they are filled.  The file is read with a
+	queue of large reads in flight, its lines counted block by
+	block as the reads complete, then parsed in parallel chunks,
+	each from the edge its count of lines before it gives.
+	The row starts of the chunks are joined at the end, a row
+	spanning two chunks started by the first
 */
 void Graph::create_csr_from_edgelist() {
 
-	ifstream infile;
-	infile.open(filename.c_str());
-	string line;
-
-	DynamicArray n1,n2,w;
-	int edge[3];
-	int edgecount=0, v1=-1;
+	AsyncReader reader;
+	size_t size = reader.open(filename) ? reader.get_size() : 0;
+
+	// a thread per cpu, but at least a few MB each
+	int threads = std::thread::hardware_concurrency();
+	threads = std::max( 1, std::min( threads, (int)(size >> 22) + 1 ) );
+
+	Arena text_arena;
+	text_arena.reserve( size + 64 );
+	char* text = text_arena.alloc_array<char>( size + 1 );
+	reader.add( 0, size, text );
+	reader.start(read_mode);
+	read_uring = reader.get_uring();
+
+	EdgelistJob job;
+	job.reader = &reader;
+	job.text = text;
+	job.size = size;
+	int blocks = reader.get_num_pieces();
+	job.newlines.resize(blocks);
+	run_edgelist_pass( &job, std::min( threads, std::max( blocks, 1 ) ), count_edgelist_blocks );
+	if( reader.get_failed() ) {
+		cout << "error: cannot read " << filename << endl;
+		exit(-1);
+	}
+	reader.finish();
+
+	// the lines before each block, and in all, a last line may lack its newline
+	job.block_lines.resize( blocks + 1 );
+	job.block_lines[0] = 0;
+	for(int b=0; b<blocks; b++)
+		job.block_lines[b+1] = job.block_lines[b] + job.newlines[b];
+	int lines = job.block_lines[blocks];
+	if( size > 0 && text[size-1] != '\n' ) lines++;
+
+	// at most a row per edge, until large labels without edges
+	arena.reserve( sizeof(int) * ( 3 * (size_t)lines + 1 ) + 3 * 64 );
+	csr2 = arena.alloc_array<int>(lines);
+	weights = arena.alloc_array<int>(lines);
+	csr1 = arena.alloc_array<int>( (size_t)lines + 1 );
+
+	// chunks of whole blocks
+	threads = std::min( threads, std::max( blocks, 1 ) );
+	job.bounds.resize( threads + 1 );
+	for(int t=0; t<=threads; t++)
+		job.bounds[t] = std::min( size, (size_t)( (long long)blocks * t / threads ) * AR_BLOCK );
+	job.bounds[threads] = size;
+	job.rows.resize(threads);
+	job.first_v1.resize(threads);
+	job.last_v1.resize(threads);
+	job.largest.resize(threads);
+	job.empty.resize(threads);
+	job.csr2 = csr2;
+	job.weights = weights;
+	run_edgelist_pass( &job, threads, fill_edgelist_chunk );
+
+	// join the rows, a chunk continuing the last row of the one before
+	int edgecount = lines, rows = 0, v1 = -1;
 	int largest_node_label = -1;
 	int last_v1;
-
-	while( getline(infile, line) ) {
-		parse_weighted_edgeline(line, edge);
-		if( v1 != edge[0] ) {
-			n1.push_back(edgecount);
-			v1 = edge[0];
-		}
-		n2.push_back(edge[1]);
-		w.push_back(edge[2]);	
-		edgecount++;
-
-		if( edge[1] > largest_node_label ) {
-			largest_node_label = edge[1];
-		}
+	for(int t=0; t<threads; t++) {
+		if( job.empty[t] ) continue;
+		vector<int>& chunk_rows = job.rows[t];
+		size_t k = ( job.first_v1[t] == v1 ) ? 1 : 0;
+		for(; k<chunk_rows.size(); k++)
+			csr1[rows++] = chunk_rows[k];
+		v1 = job.last_v1[t];
+		largest_node_label = std::max( largest_node_label, job.largest[t] );
 	}
 	last_v1 = v1;
-	n1.push_back(edgecount);
-
+	csr1[rows++] = edgecount;
 
 	// account for large-labeled nodes w/ no out-edges
 	int num_extra_nodes = largest_node_label - last_v1;
-	for(int i=0; i<num_extra_nodes; i++) {
-		n1.push_back(edgecount);
+	if( num_extra_nodes < 0 ) num_extra_nodes = 0;
+	num_verts = rows - 1 + num_extra_nodes;
+	num_edges = edgecount;
+
+	if( num_verts > lines ) {
+		int* wider = arena.alloc_array<int>( (size_t)num_verts + 1 );
+		memcpy( wider, csr1, sizeof(int) * rows );
+		csr1 = wider;
+	}
+	for(int i=rows; i<=num_verts; i++) {
+		csr1[i] = edgecount;
 	}
-
-	num_verts = n1.get_size() - 1;
-	num_edges = n2.get_size();
-
-	csr1 = new int[num_verts +1];
-	csr2 = new int[num_edges];
-	weights = new int[num_edges];
-
-	memcpy( csr1, n1.get_array(), sizeof(int) * (num_verts+1) );
-	memcpy( csr2, n2.get_array(), sizeof(int) * num_edges );
-	memcpy( weights, w.get_array(), sizeof(int) * num_edges );
 
 	return;
 }
 
 /*
-	Deallocate the adjacency list representation
-*/	
-void Graph::remove_adjlist() {
-	for(int i=0; i<num_verts; i++)
-		delete [] adjlist[i];
-	delete [] adjlist;
-	delete [] num_neighbors;
-	return;
+	map a graph file for reading, NULL with a size
+	of 0 if the file is empty or cannot be opened
+*/
+const char* Graph::map_graph_file(string infile, size_t& size) {
+
+	size = 0;
+	int fd = open( infile.c_str(), O_RDONLY );
+	struct stat st;
+	if( fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0 ) {
+		if( fd >= 0 ) close(fd);
+		return NULL;
+	}
+	size = st.st_size;
+	const char* text = (const char*)mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close(fd);
+	if( text == MAP_FAILED ) {
+		cout << "error: cannot map " << infile << endl;
+		exit(-1);
+	}
+	madvise( (void*)text, size, MADV_SEQUENTIAL );
+	return text;
+}
+
+/* unmap a mapped graph file */
+void Graph::unmap_graph_file(const char* text, size_t size) {
+	if( text != NULL )
+		munmap( (void*)text, size );
 }
 
 /*
-	Get the number of rows in an adjacency list file
+	whether a file starts with the magic of a CSR image
 */
-int Graph::read_adjlist_rows(string infile) {
-	ifstream instream;
-	instream.open(infile.c_str());
-	string line;
-	int num_rows=0;
-	while( getline( instream, line) )
-		num_rows++;
-	instream.close();
-	return num_rows;
+bool Graph::is_csr_image(string infile) {
+	char magic[CSR_MAGIC_LEN];
+	int fd = open( infile.c_str(), O_RDONLY );
+	if( fd < 0 ) return false;
+	bool is_image = ( read(fd, magic, CSR_MAGIC_LEN) == CSR_MAGIC_LEN
+		&& memcmp(magic, CSR_MAGIC, CSR_MAGIC_LEN) == 0 );
+	close(fd);
+	return is_image;
 }
 
 /*
-	Get the number of neighbors for each vertex
-	in an adjacency list
-*/	
-void Graph::read_row_neighbors(string infile) {
-	ifstream instream;
-	instream.open( infile.c_str() );
-	string line;
-	int row=0;
-	int neighbor_count=0;
-	while( getline( instream, line) ) {
-		neighbor_count=parse_row_neighbors( line );	
-		num_neighbors[row]=neighbor_count;
-		row++;
+	load the CSR arrays straight from a binary CSR image,
+	read into place with a queue of large reads in flight.
+	Unweighted images get weights of 1, as unweighted
+	edgelists do, while the reads are in flight.
+*/
+void Graph::load_csr_image() {
+
+	int fd = open( filename.c_str(), O_RDONLY );
+	CsrHeader header;
+	read_csr_section( fd, 0, &header, sizeof(header) );
+
+	if( header.num_verts < 0 || header.num_verts >= INT32_MAX
+			|| header.num_edges < 0 || header.num_edges > INT32_MAX ) {
+		cout << "error: " << filename << " is too large" << endl;
+		exit(-1);
+	}
+	num_verts = header.num_verts;
+	num_edges = header.num_edges;
+
+	arena.reserve( sizeof(int) * ( (size_t)num_verts + 1 + 2 * (size_t)num_edges ) + 3 * 64 );
+	csr1 = arena.alloc_array<int>( (size_t)num_verts + 1 );
+	csr2 = arena.alloc_array<int>(num_edges);
+	weights = arena.alloc_array<int>(num_edges);
+
+	close(fd);
+
+	AsyncReader reader;
+	if( !reader.open(filename) ) {
+		cout << "error: cannot read CSR image " << filename << endl;
+		exit(-1);
+	}
+	reader.add( header.offsets_at, sizeof(int) * ((int64_t)num_verts + 1), csr1 );
+	reader.add( header.neighbors_at, sizeof(int) * (int64_t)num_edges, csr2 );
+	if( header.flags & CSR_WEIGHTED )
+		reader.add( header.weights_at, sizeof(int) * (int64_t)num_edges, weights );
+	reader.start(read_mode);
+	read_uring = reader.get_uring();
+	if( !( header.flags & CSR_WEIGHTED ) ) {
+		for(int i=0; i<num_edges; i++)
+			weights[i] = 1;
+	}
+
+	int piece;
+	while( reader.next(piece) ) {}
+	if( reader.get_failed() ) {
+		cout << "error: cannot read CSR image " << filename << endl;
+		exit(-1);
 	}
-	instream.close();
 	return;
 }
 
 /*
-	parse the given line of an adjacency list
-	assumes space delimitted
+	read len bytes of a CSR image at offset,
+	exiting if the image is cut short
 */
-int Graph::parse_row_neighbors( string line ) {
-	
-	int neighbor_count=0;
-	bool parsed_v=false;
-	for(int i=0; i<line.size(); i++) {
-		if( line[i] == ' ' ) {
-			if(parsed_v==false) {
-				parsed_v=true;
-			} else {
-				neighbor_count++;
-			}
-		}		
+void Graph::read_csr_section(int fd, int64_t offset, void* data, int64_t len) {
+
+	char* out = (char*)data;
+	while( len > 0 ) {
+		size_t chunk = ( len > (1<<30) ) ? (1<<30) : len;
+		ssize_t n = pread( fd, out, chunk, offset );
+		if( n <= 0 ) {
+			cout << "error: cannot read CSR image " << filename << endl;
+			exit(-1);
+		}
+		out += n;
+		offset += n;
+		len -= n;
 	}
-	neighbor_count++;
-
-	return neighbor_count;
 }
 
-/* searches for the 2 tabs in a weighted edgelist file */
-void Graph::parse_weighted_edgeline( string edgeline, int* edge ) {
+/* an adjacency list file split into per-thread chunks of whole rows */
+struct AdjlistJob {
+	const char* text;
+	vector<size_t> bounds;
+	vector<int> rows;
+	vector<int> edges;
+	int* csr1;
+	int* csr2;
+};
 
-	// unweighted
-	if(edgeline.find_first_of('\t') == edgeline.find_last_of('\t') ) {
-		int t1 = edgeline.find_first_of('\t');
-		
-		edge[0] = atoi( edgeline.substr(0,t1).c_str() );
-		edge[1] = atoi( edgeline.substr(t1+1, edgeline.length()-t1-1 ).c_str() );
-		edge[2]=1;
-	} else { // weighted 
-		int t1 = edgeline.find_first_of('\t');
-		int t2 = edgeline.find_last_of('\t');
-		edge[0]=atoi( edgeline.substr(0,t1).c_str() );
-		edge[1]=atoi( edgeline.substr(t1+1, t2-t1-1).c_str() );
-		edge[2]=atoi( edgeline.substr(t2+1, edgeline.length()-t2-1).c_str() );
+/*
+	count the rows and neighbors of a chunk.  A row is
+	space delimitted, the vertex then its neighbors; a row
+	of one token has that token as its only neighbor.
+*/
+static void count_adjlist_chunk(AdjlistJob* job, int t) {
+	const char* p = job->text + job->bounds[t];
+	const char* end = job->text + job->bounds[t+1];
+	int rows = 0, edges = 0;
+	while( p < end ) {
+		const char* eol = (const char*)memchr(p, '\n', end - p);
+		if( eol == NULL ) eol = end;
+		int spaces = 0;
+		for(const char* c=p; c<eol; c++)
+			spaces += ( *c == ' ' );
+		edges += ( spaces > 0 ) ? spaces : 1;
+		rows++;
+		p = eol + 1;
 	}
-	
-	return;
+	job->rows[t] = rows;
+	job->edges[t] = edges;
 }
 
 /*
-	open an adjacency graph file and 
-	parse each row into the adjacency list
+	fill the CSR rows of a chunk, from the chunk's
+	first row and first edge found by the counts
 */
-void Graph::read_adjlist(string infile) {
-
-	ifstream instream;
-	instream.open( infile.c_str() );
-	string line;
-	int row_count=0;
-	while( getline( instream, line ) ) {
-		parse_adjlist_row( line, adjlist[row_count] );
-		row_count++;
+static void fill_adjlist_chunk(AdjlistJob* job, int t) {
+	const char* p = job->text + job->bounds[t];
+	const char* end = job->text + job->bounds[t+1];
+	int row = job->rows[t];
+	int edge = job->edges[t];
+	while( p < end ) {
+		const char* eol = (const char*)memchr(p, '\n', end - p);
+		if( eol == NULL ) eol = end;
+		job->csr1[row++] = edge;
+		const char* sp = (const char*)memchr(p, ' ', eol - p);
+		if( sp == NULL ) {
+			job->csr2[edge++] = parse_int(p, eol);
+		} else {
+			for(const char* tok=sp+1; ; ) {
+				const char* next = (const char*)memchr(tok, ' ', eol - tok);
+				if( next == NULL ) next = eol;
+				job->csr2[edge++] = parse_int(tok, next);
+				if( next == eol ) break;
+				tok = next + 1;
+			}
+		}
+		p = eol + 1;
 	}
+}
 
-	return;
+/*
+	run a pass over every chunk, a thread per chunk
+*/
+static void run_adjlist_pass( AdjlistJob* job, int threads, void (*pass)(AdjlistJob*, int) ) {
+	if( threads == 1 ) {
+		pass(job, 0);
+		return;
+	}
+	vector<std::thread> pool;
+	for(int t=0; t<threads; t++)
+		pool.push_back( std::thread(pass, job, t) );
+	for(int t=0; t<threads; t++)
+		pool[t].join();
 }
 
 /*
-	parse each row of the adjacency list,
-	placing the neighbors in the file into
-	each entry in the internal adjacency list
+	Create the Compressed Sparse Row format straight from
+	an adjacency list file, mapped into memory, in two
+	parallel passes over chunks of whole rows: the first counts
+	each chunk's rows and neighbors, the second parses the
+	neighbors into place, so there is no intermediate copy
 */
-void Graph::parse_adjlist_row( string line, int* row ) {
-
-	string vert_str;
-	int start, length;
-	bool parsed_v=false;
-	start=0;
-	int vert;
-	int vert_count=0;
-	for(int i=0; i<line.size(); i++) {
-		if( line[i] == ' ' ) {
-			length=i-start;
-			vert_str = line.substr( start , length );
-			if(parsed_v==false) {
-				parsed_v=true;
-			} else {
-				vert = atoi(vert_str.c_str() );
-				row[vert_count] = vert;
-				vert_count++;
-			}
-			start=i+1;
-		}		
+void Graph::create_csr_from_adjlist(string infile) {
+
+	num_verts = 0;
+	num_edges = 0;
+
+	size_t size;
+	const char* text = map_graph_file(infile, size);
+
+	// a thread per cpu, but at least a few MB each
+	int threads = std::thread::hardware_concurrency();
+	threads = std::max( 1, std::min( threads, (int)(size >> 22) + 1 ) );
+	if( size == 0 ) threads = 1;
+
+	AdjlistJob job;
+	job.text = text;
+	job.bounds.resize(threads + 1);
+	job.rows.resize(threads);
+	job.edges.resize(threads);
+
+	// start each chunk after a newline
+	job.bounds[0] = 0;
+	for(int t=1; t<threads; t++) {
+		size_t b = std::max( size * t / threads, job.bounds[t-1] );
+		while( b > 0 && b < size && text[b-1] != '\n' ) b++;
+		job.bounds[t] = b;
+	}
+	job.bounds[threads] = size;
+
+	run_adjlist_pass( &job, threads, count_adjlist_chunk );
+
+	// each chunk's first row and first edge
+	for(int t=0; t<threads; t++) {
+		int rows = job.rows[t], edges = job.edges[t];
+		job.rows[t] = num_verts;
+		job.edges[t] = num_edges;
+		num_verts += rows;
+		num_edges += edges;
 	}
-	length=line.size()-start;
-	vert_str = line.substr( start , length );
-	vert = atoi(vert_str.c_str() );
-	row[vert_count] = vert;
 
+	arena.reserve( sizeof(int) * ( (size_t)num_verts + 1 + (size_t)num_edges ) + 2 * 64 );
+	csr1 = arena.alloc_array<int>( (size_t)num_verts + 1 );
+	csr2 = arena.alloc_array<int>(num_edges);
+	csr1[num_verts] = num_edges;
+	job.csr1 = csr1;
+	job.csr2 = csr2;
+	run_adjlist_pass( &job, threads, fill_adjlist_chunk );
+
+	unmap_graph_file(text, size);
 	return;
 }
@@ -5,7 +5,9 @@
 	Header of a Graph object for TLAV program
 	Used for the system's internal graph representation 
 
-	Can load graphs in the adjacency or edgelist format
+	Can load graphs in the adjacency or edgelist format,
+	or as a binary CSR image written by edge_preproc.
+	Edgelists and images are read by an AsyncReader
 	
 	This software is distributed under 
 	the modified Berkeley Software Distribution (BSD) License.
@@ -16,8 +18,11 @@
 #define GRAPH_H
 
 #include<string>
+#include<stdint.h>
 using std::string;
 
+#include "Arena.h"
+
 class Graph{
 
 	/* constructor, destructor, and public accessor functions */
@@ -36,21 +41,22 @@ class Graph{
 		int* get_weights();
 		int get_degree(int);
 		string get_filename();
+		void replace_csr(int*, int*, int*, Arena&);
+		void set_read_mode(int);
+		void set_reader(string);
+		bool get_read_uring();
 
 
 	/* private functions */
 	private:
 
-		void create_adjlist_from_file(string infile);
-		void create_csr_from_adjlist();
+		void create_csr_from_adjlist(string infile);
 		void create_csr_from_edgelist();
-		void remove_adjlist();
-		int read_adjlist_rows(string infile);
-		void read_row_neighbors(string infile);
-		int parse_row_neighbors(string line);
-		void parse_weighted_edgeline(string, int*);
-		void read_adjlist(string infile);
-		void parse_adjlist_row( string line, int* row );
+		bool is_csr_image(string);
+		void load_csr_image();
+		void read_csr_section(int, int64_t, void*, int64_t);
+		const char* map_graph_file(string, size_t&);
+		void unmap_graph_file(const char*, size_t);
 
 
 	/* private variables */
@@ -60,10 +66,15 @@ class Graph{
 		int* csr1;
 		int* csr2;
 		int* weights;
-		int* num_neighbors;
-		int** adjlist;
 		string filename;
 
+		// how edgelists and images are read, and whether by io_uring
+		int read_mode;
+		bool read_uring;
+
+		// holds the CSR arrays
+		Arena arena;
+
 };
 
 #endif
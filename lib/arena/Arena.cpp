@@ -0,0 +1,129 @@
+/*
+	Think-Like-A-Vertex Framework, Arena.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the arena of large arrays
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "Arena.h"
+
+using namespace std;
+
+// blocks are aligned to, and sized in, huge pages
+#define HUGE_PAGE (2UL<<20)
+
+// arrays start on a cache line
+#define ALIGN 64
+
+std::atomic<size_t> Arena::mapped_total(0);
+
+/* Constructor, nothing mapped */
+Arena::Arena() {}
+
+/* Destructor, unmap every block */
+Arena::~Arena() {
+	release();
+}
+
+/*
+	make room for bytes more of arrays in one block,
+	e.g. every array of a graph once its counts are known.
+	Each array may round up to a cache line.
+*/
+void Arena::reserve(size_t bytes) {
+	if( !blocks.empty() && blocks.back().size - blocks.back().used >= bytes )
+		return;
+	map_block(bytes);
+}
+
+/*
+	an array of bytes from the last block,
+	mapping another if it does not fit
+*/
+void* Arena::alloc(size_t bytes) {
+	bytes = ( bytes + ALIGN - 1 ) & ~(size_t)(ALIGN - 1);
+	if( bytes == 0 ) bytes = ALIGN;
+	if( blocks.empty() || blocks.back().size - blocks.back().used < bytes )
+		map_block(bytes);
+	Block& b = blocks.back();
+	void* p = b.base + b.used;
+	b.used += bytes;
+	return p;
+}
+
+/*
+	map a block of at least bytes, aligned to a huge page
+	by mapping a huge page more and trimming the ends,
+	and advise huge pages for it
+*/
+void Arena::map_block(size_t bytes) {
+
+	size_t size = ( bytes + HUGE_PAGE - 1 ) & ~(HUGE_PAGE - 1);
+	if( size == 0 ) size = HUGE_PAGE;
+
+	char* raw = (char*)mmap( NULL, size + HUGE_PAGE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+	if( raw == MAP_FAILED ) {
+		cout << "error: cannot map " << size << " bytes: " << strerror(errno) << endl;
+		exit(-1);
+	}
+	char* base = (char*)( ( (uintptr_t)raw + HUGE_PAGE - 1 ) & ~(uintptr_t)(HUGE_PAGE - 1) );
+	if( base > raw )
+		munmap( raw, base - raw );
+	if( raw + HUGE_PAGE > base )
+		munmap( base + size, raw + HUGE_PAGE - base );
+
+#ifdef MADV_HUGEPAGE
+	// only advice, without transparent huge pages it is ignored
+	madvise( base, size, MADV_HUGEPAGE );
+#endif
+
+	mapped_total += size;
+	Block b;
+	b.base = base;
+	b.size = size;
+	b.used = 0;
+	blocks.push_back(b);
+}
+
+/*
+	take over every block of another arena, which is left empty.
+	The blocks go before this arena's, so allocation goes on
+	from the same block as before.
+*/
+void Arena::adopt(Arena& other) {
+	blocks.insert( blocks.begin(), other.blocks.begin(), other.blocks.end() );
+	other.blocks.clear();
+}
+
+/* unmap every block, releasing all the arrays at once */
+void Arena::release() {
+	for(size_t i=0; i<blocks.size(); i++) {
+		munmap( blocks[i].base, blocks[i].size );
+		mapped_total -= blocks[i].size;
+	}
+	blocks.clear();
+}
+
+/* the bytes mapped by the arena */
+size_t Arena::get_mapped() {
+	size_t n = 0;
+	for(size_t i=0; i<blocks.size(); i++)
+		n += blocks[i].size;
+	return n;
+}
+
+/* the bytes mapped by every arena of the process */
+size_t Arena::get_mapped_total() {
+	return mapped_total;
+}
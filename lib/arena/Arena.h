@@ -0,0 +1,72 @@
+/*
+	Think-Like-A-Vertex Framework, Arena.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	An arena of large arrays: the CSR arrays of a Graph,
+	and the vertices and message queues of a Worker.
+
+	Memory is mapped from the kernel in blocks aligned to 2MB
+	and advised to be backed by transparent huge pages, which cuts
+	TLB misses on random vertex access.  Arrays are carved from the
+	blocks and never freed one at a time; the whole arena is released
+	at once.  Sizing the arena up front with reserve() lets every
+	array of a load share one block.
+
+	Pages are not touched until written, so a thread that first
+	writes its share of an array still places it on its own node.
+	Another arena's blocks can be taken over with adopt(),
+	handing arrays between owners without a copy.  The bytes
+	mapped by every arena of the process are counted, as the
+	blocks are not on the heap malloc reports.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+using std::vector;
+
+class Arena {
+
+	public:
+		Arena();
+		~Arena();
+		void reserve(size_t);
+		void* alloc(size_t);
+		void adopt(Arena&);
+		void release();
+		size_t get_mapped();
+		static size_t get_mapped_total();
+
+		/* an uninitialized array of n elements */
+		template<typename E>
+		E* alloc_array(size_t n) {
+			return static_cast<E*>( alloc( sizeof(E) * n ) );
+		}
+
+	private:
+		// not copyable, the blocks have one owner
+		Arena(const Arena&);
+		Arena& operator=(const Arena&);
+
+		struct Block {
+			char* base;
+			size_t size;
+			size_t used;
+		};
+
+		void map_block(size_t);
+
+		vector<Block> blocks;
+
+		// bytes mapped by all arenas
+		static std::atomic<size_t> mapped_total;
+
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*
+	Think-Like-A-Vertex Framework, BidirectionalBfs.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the point-to-point bidirectional search
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <algorithm>
+
+#include "BidirectionalBfs.h"
+
+/*
+	Constructor, over the n vertices of CSR arrays
+	that hold every edge in both directions
+*/
+BidirectionalBfs::BidirectionalBfs(int n, const int* _csr1, const int* _csr2) {
+
+	num_verts = n;
+	csr1 = _csr1;
+	csr2 = _csr2;
+
+	arena.reserve( 2 * ( sizeof(unsigned) + 2 * sizeof(int) ) * (size_t)n + 6 * 64 );
+	Side* sides[2] = { &fwd, &bwd };
+	for(int i=0; i<2; i++) {
+		sides[i]->stamp = arena.alloc_array<unsigned>(n);
+		sides[i]->dist = arena.alloc_array<int>(n);
+		sides[i]->parent = arena.alloc_array<int>(n);
+		std::fill( sides[i]->stamp, sides[i]->stamp + n, 0u );
+		sides[i]->frontier_edges = 0;
+		sides[i]->depth = 0;
+	}
+	epoch = 0;
+	src = dst = meet = hops = -1;
+	verts_visited = 0;
+	edges_scanned = 0;
+}
+
+/*
+	the hops from s to t, or -1 if t cannot be reached:
+	expand the side with fewer frontier edges a level at a time
+	until a level meets the other side or a frontier runs out
+*/
+int BidirectionalBfs::query(int s, int t) {
+
+	src = s;
+	dst = t;
+	meet = hops = -1;
+	verts_visited = 0;
+	edges_scanned = 0;
+
+	// a new stamp for the marks of this query, clearing them on wrap
+	if( ++epoch == 0 ) {
+		std::fill( fwd.stamp, fwd.stamp + num_verts, 0u );
+		std::fill( bwd.stamp, bwd.stamp + num_verts, 0u );
+		epoch = 1;
+	}
+	init_side(fwd, s);
+	init_side(bwd, t);
+	if( s == t ) {
+		meet = s;
+		hops = 0;
+		return hops;
+	}
+
+	while( !fwd.frontier.empty() && !bwd.frontier.empty() ) {
+		bool forward = ( fwd.frontier_edges <= bwd.frontier_edges );
+		int found = forward ? expand(fwd, bwd) : expand(bwd, fwd);
+		if( found >= 0 ) {
+			hops = found;
+			break;
+		}
+	}
+	return hops;
+}
+
+/* start a side's search from vertex v */
+void BidirectionalBfs::init_side(Side& side, int v) {
+	side.frontier.clear();
+	side.next.clear();
+	side.depth = 0;
+	visit(side, v, 0, -1);
+	side.frontier.push_back(v);
+	side.frontier_edges = csr1[v+1] - csr1[v];
+}
+
+/* mark v seen by a side, at distance d through parent p */
+inline void BidirectionalBfs::visit(Side& side, int v, int d, int p) {
+	side.stamp[v] = epoch;
+	side.dist[v] = d;
+	side.parent[v] = p;
+	verts_visited++;
+}
+
+/* whether a side has seen v in this query */
+inline bool BidirectionalBfs::seen(const Side& side, int v) {
+	return side.stamp[v] == epoch;
+}
+
+/*
+	expand a side's frontier by one level.  Every vertex it
+	reaches that the other side has seen is a meeting; the
+	whole level is expanded, and the shortest total through
+	its meetings returned, or -1 if there are none
+*/
+int BidirectionalBfs::expand(Side& side, Side& other) {
+
+	int best = -1;
+	long long next_edges = 0;
+	side.next.clear();
+
+	for(size_t i=0; i<side.frontier.size(); i++) {
+		int u = side.frontier[i];
+		edges_scanned += csr1[u+1] - csr1[u];
+		for(int j=csr1[u]; j<csr1[u+1]; j++) {
+			int v = csr2[j];
+			if( seen(side, v) ) continue;
+			visit(side, v, side.depth+1, u);
+			side.next.push_back(v);
+			next_edges += csr1[v+1] - csr1[v];
+
+			if( seen(other, v) ) {
+				int total = side.depth + 1 + other.dist[v];
+				if( best < 0 || total < best ) {
+					best = total;
+					meet = v;
+				}
+			}
+		}
+	}
+
+	side.depth++;
+	side.frontier.swap(side.next);
+	side.frontier_edges = next_edges;
+	return best;
+}
+
+/*
+	the vertices of a shortest path of the last query, from
+	the source to the target, empty if it was not reached
+*/
+vector<int> BidirectionalBfs::get_path() {
+
+	vector<int> path;
+	if( hops < 0 ) return path;
+
+	for(int v=meet; v!=-1; v=fwd.parent[v])
+		path.push_back(v);
+	std::reverse( path.begin(), path.end() );
+	for(int v=bwd.parent[meet]; v!=-1; v=bwd.parent[v])
+		path.push_back(v);
+	return path;
+}
+
+/* the vertices either side visited in the last query */
+int BidirectionalBfs::get_verts_visited() {
+	return verts_visited;
+}
+
+/* the directed edges scanned in the last query */
+long long BidirectionalBfs::get_edges_scanned() {
+	return edges_scanned;
+}
@@ -0,0 +1,80 @@
+/*
+	Think-Like-A-Vertex Framework, BidirectionalBfs.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Point-to-point hop distance by bidirectional breadth-first
+	search over the CSR arrays, for queries that need only the
+	distance between two vertices rather than from one to all.
+
+	A forward search from the source and a backward search from
+	the target take turns a level at a time, each turn expanding
+	whichever frontier has fewer edges to scan; the graph is
+	undirected, so both follow the same rows.  Once a level
+	reaches a vertex the other side has seen, the level is
+	finished and the least of its meetings is the distance, so
+	a query scans only the neighborhoods of its two ends.
+
+	The marks of both sides are stamped with the query number,
+	so a query touches only the vertices it visits, and the
+	parents they record give the path.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef BIDIRECTIONALBFS_H
+#define BIDIRECTIONALBFS_H
+
+#include <vector>
+using std::vector;
+
+#include "Arena.h"
+
+class BidirectionalBfs {
+
+	public:
+		BidirectionalBfs(int, const int*, const int*);
+
+		int query(int, int);
+		vector<int> get_path();
+		int get_verts_visited();
+		long long get_edges_scanned();
+
+	private:
+		// a direction of the search
+		struct Side {
+			unsigned* stamp;
+			int* dist;
+			int* parent;
+			vector<int> frontier;
+			vector<int> next;
+			long long frontier_edges;
+			int depth;
+		};
+
+		void init_side(Side&, int);
+		void visit(Side&, int, int, int);
+		bool seen(const Side&, int);
+		int expand(Side&, Side&);
+
+		// the graph
+		int num_verts;
+		const int* csr1;
+		const int* csr2;
+
+		Arena arena;
+		Side fwd;
+		Side bwd;
+		unsigned epoch;
+
+		// the last query: where the sides met, and the work it took
+		int src;
+		int dst;
+		int meet;
+		int hops;
+		int verts_visited;
+		long long edges_scanned;
+
+};
+
+#endif
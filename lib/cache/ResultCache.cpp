@@ -0,0 +1,195 @@
+/*
+	Think-Like-A-Vertex Framework, ResultCache.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the persistent result cache
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "ResultCache.h"
+
+// multipliers of the hash lanes and of the final mix
+#define RC_PRIME1 0x9E3779B185EBCA87ULL
+#define RC_PRIME2 0xC2B2AE3D27D4EB4FULL
+
+/* Constructor, over the directory dir holding at most budget bytes */
+ResultCache::ResultCache(string _dir, long long _budget) {
+	dir = _dir;
+	budget = _budget;
+	evicted = 0;
+	mkdir( dir.c_str(), 0755 );
+}
+
+/* a 64 bit value with every input bit spread over every output bit */
+static inline uint64_t mix(uint64_t h) {
+	h ^= h >> 33;
+	h *= RC_PRIME2;
+	h ^= h >> 29;
+	h *= RC_PRIME1;
+	h ^= h >> 32;
+	return h;
+}
+
+/*
+	hash len bytes into h: four lanes of 8 byte words, each
+	multiplied and rotated on its own so the loop runs at the
+	speed of memory, folded together with the length at the end
+*/
+uint64_t ResultCache::hash_bytes(uint64_t h, const void* data, size_t len) {
+
+	const char* p = (const char*)data;
+	uint64_t lane[4] = { h, h + RC_PRIME1, h + RC_PRIME2, h - RC_PRIME1 };
+	size_t i = 0;
+	for(; i+32<=len; i+=32) {
+		for(int l=0; l<4; l++) {
+			uint64_t w;
+			memcpy( &w, p + i + 8*l, 8 );
+			lane[l] = ( lane[l] ^ w ) * RC_PRIME1;
+			lane[l] = ( lane[l] << 31 ) | ( lane[l] >> 33 );
+		}
+	}
+	for(; i<len; i++)
+		lane[ i & 3 ] = ( lane[ i & 3 ] ^ (unsigned char)p[i] ) * RC_PRIME2;
+
+	uint64_t out = len;
+	for(int l=0; l<4; l++)
+		out = mix( out ^ lane[l] );
+	return out;
+}
+
+/* the content hash of n vertices of CSR arrays and their weights */
+uint64_t ResultCache::hash_csr(int n, const int* csr1, const int* csr2, const int* weights) {
+	uint64_t h = mix( (uint64_t)n );
+	h = hash_bytes( h, csr1, sizeof(int) * ( (size_t)n + 1 ) );
+	h = hash_bytes( h, csr2, sizeof(int) * (size_t)csr1[n] );
+	if( weights ) h = hash_bytes( h, weights, sizeof(int) * (size_t)csr1[n] );
+	return h;
+}
+
+/* the file of the result of key on the graph of graph_hash */
+string ResultCache::path_of(uint64_t graph_hash, string key) {
+	char name[32];
+	snprintf( name, sizeof(name), "%016llx", (unsigned long long)hash_bytes( graph_hash, key.data(), key.size() ) );
+	return dir + "/" + name + RC_SUFFIX;
+}
+
+/*
+	read the value_bytes of the result of key on the graph of
+	graph_hash into values, marking it used.  False if there
+	is no such result
+*/
+bool ResultCache::get(uint64_t graph_hash, string key, void* values, int64_t value_bytes) {
+
+	string path = path_of(graph_hash, key);
+	FILE* file = fopen( path.c_str(), "rb" );
+	if( !file ) return false;
+
+	ResultHeader header;
+	string stored;
+	bool ok = fread( &header, sizeof(header), 1, file ) == 1
+		&& memcmp( header.magic, RC_MAGIC, RC_MAGIC_LEN ) == 0
+		&& header.graph_hash == graph_hash
+		&& header.value_bytes == value_bytes
+		&& header.key_len == (int64_t)key.size();
+	if( ok ) {
+		stored.resize( key.size() );
+		ok = ( key.empty() || fread( &stored[0], key.size(), 1, file ) == 1 )
+			&& stored == key
+			&& ( value_bytes == 0 || fread( values, value_bytes, 1, file ) == 1 );
+	}
+	fclose(file);
+
+	if( ok ) utimes( path.c_str(), NULL );
+	return ok;
+}
+
+/*
+	store the value_bytes of values as the result of key on
+	the graph of graph_hash, then evict down to the budget
+*/
+bool ResultCache::put(uint64_t graph_hash, string key, const void* values, int64_t value_bytes) {
+
+	string path = path_of(graph_hash, key);
+	char suffix[32];
+	snprintf( suffix, sizeof(suffix), ".tmp%d", (int)getpid() );
+	string tmp = path + suffix;
+	FILE* file = fopen( tmp.c_str(), "wb" );
+	if( !file ) return false;
+
+	ResultHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, RC_MAGIC, RC_MAGIC_LEN );
+	header.graph_hash = graph_hash;
+	header.value_bytes = value_bytes;
+	header.key_len = key.size();
+	bool ok = fwrite( &header, sizeof(header), 1, file ) == 1
+		&& ( key.empty() || fwrite( key.data(), key.size(), 1, file ) == 1 )
+		&& ( value_bytes == 0 || fwrite( values, value_bytes, 1, file ) == 1 );
+	if( fclose(file) != 0 ) ok = false;
+	if( ok ) ok = rename( tmp.c_str(), path.c_str() ) == 0;
+	if( !ok ) {
+		unlink( tmp.c_str() );
+		return false;
+	}
+
+	evict();
+	return true;
+}
+
+/*
+	remove the least recently used results until the
+	results in the directory fit within the budget
+*/
+void ResultCache::evict() {
+
+	DIR* d = opendir( dir.c_str() );
+	if( !d ) return;
+
+	struct Entry {
+		double used;
+		long long bytes;
+		string path;
+		bool operator<(const Entry& other) const { return used < other.used; }
+	};
+	std::vector<Entry> entries;
+	long long total = 0;
+	size_t suffix_len = strlen(RC_SUFFIX);
+	struct dirent* ent;
+	while( ( ent = readdir(d) ) != NULL ) {
+		size_t len = strlen( ent->d_name );
+		if( len <= suffix_len || strcmp( ent->d_name + len - suffix_len, RC_SUFFIX ) != 0 ) continue;
+		Entry e;
+		e.path = dir + "/" + ent->d_name;
+		struct stat info;
+		if( stat( e.path.c_str(), &info ) != 0 ) continue;
+		e.used = info.st_mtim.tv_sec + info.st_mtim.tv_nsec * 1e-9;
+		e.bytes = info.st_size;
+		total += e.bytes;
+		entries.push_back(e);
+	}
+	closedir(d);
+
+	std::sort( entries.begin(), entries.end() );
+	for(size_t i=0; i<entries.size() && total > budget; i++) {
+		if( unlink( entries[i].path.c_str() ) != 0 ) continue;
+		total -= entries[i].bytes;
+		evicted++;
+	}
+}
+
+/* the results this cache has evicted */
+long long ResultCache::get_evicted() {
+	return evicted;
+}
@@ -0,0 +1,75 @@
+/*
+	Think-Like-A-Vertex Framework, ResultCache.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	A directory of the final vertex values of past runs, so that
+	a program rerun on an unchanged graph with the same arguments
+	returns its result without running.
+
+	A result is keyed by a content hash of the loaded CSR arrays,
+	the program and its arguments (such as the source), and
+	stored as one file named by the hash of the key:
+
+		magic		the 8 bytes TLAVRC01
+		graph_hash	uint64
+		value_bytes	int64
+		key_len		int64
+		key		char[key_len], the program and arguments
+		values		value_bytes of raw vertex values
+
+	A result is only returned if the whole key matches, so hash
+	collisions between file names cannot return a wrong result.
+	Each file's modification time is its last use: reading a
+	result touches it, and storing one evicts the least recently
+	used results until the directory is within its byte budget.
+	Results are written to a temporary file and renamed into
+	place, so concurrent runs never read half a result.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <stdint.h>
+#include <string>
+using std::string;
+
+#define RC_MAGIC "TLAVRC01"
+#define RC_MAGIC_LEN 8
+#define RC_SUFFIX ".res"
+
+// the default size of the cache directory, in MB
+#define RC_BUDGET_MB 1024
+
+struct ResultHeader {
+	char magic[RC_MAGIC_LEN];
+	uint64_t graph_hash;
+	int64_t value_bytes;
+	int64_t key_len;
+};
+
+class ResultCache {
+
+	public:
+		ResultCache(string, long long);
+
+		static uint64_t hash_csr(int, const int*, const int*, const int*);
+
+		bool get(uint64_t, string, void*, int64_t);
+		bool put(uint64_t, string, const void*, int64_t);
+		long long get_evicted();
+
+	private:
+		static uint64_t hash_bytes(uint64_t, const void*, size_t);
+		string path_of(uint64_t, string);
+		void evict();
+
+		string dir;
+		long long budget;
+		long long evicted;
+
+};
+
+#endif
@@ -0,0 +1,491 @@
+/*
+	Think-Like-A-Vertex Framework, ContractionHierarchy.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the contraction hierarchy
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include "CsrImage.h"
+#include "ContractionHierarchy.h"
+
+typedef std::pair<int,int> KeyVert;
+
+/* Constructor, an empty hierarchy */
+ContractionHierarchy::ContractionHierarchy() {
+	num_verts = 0;
+	num_core = 0;
+	witness_epoch = 0;
+	epoch = 0;
+	meet = -1;
+	best = INT_MAX;
+	settled = 0;
+}
+
+/*
+	build the hierarchy of the n vertices of the CSR arrays,
+	which hold every edge in both directions with its weight:
+	contract the vertex of least priority, updating priorities
+	lazily as they are popped, until every vertex is contracted
+	or the least has too many edges left to contract
+*/
+void ContractionHierarchy::build(int n, const int* csr1, const int* csr2, const int* weights) {
+
+	num_verts = n;
+	adj.assign( n, vector<Arc>() );
+	for(int v=0; v<n; v++) {
+		for(int j=csr1[v]; j<csr1[v+1]; j++) {
+			if( csr2[j] == v ) continue;
+			Arc arc = { csr2[j], weights[j], -1 };
+			adj[v].push_back(arc);
+		}
+	}
+	contracted.assign(n, false);
+	deleted.assign(n, 0);
+	depth.assign(n, 0);
+	witness_stamp.assign(n, 0);
+	witness_dist.assign(n, 0);
+	witness_target.assign(n, 0);
+	witness_epoch = 0;
+	rank.assign(n, 0);
+
+	std::priority_queue< KeyVert, vector<KeyVert>, std::greater<KeyVert> > queue;
+	for(int v=0; v<n; v++)
+		queue.push( KeyVert( priority(v), v ) );
+
+	int order = 0;
+	while( !queue.empty() ) {
+		int v = queue.top().second;
+		queue.pop();
+		if( contracted[v] ) continue;
+
+		// contract v only if it is still least once brought up to date
+		int p = priority(v);
+		if( !queue.empty() && p > queue.top().first ) {
+			queue.push( KeyVert(p, v) );
+			continue;
+		}
+		if( p == INT_MAX ) break;
+		contract(v, false);
+		contracted[v] = true;
+		rank[v] = order++;
+
+		// the edges v has left become its upward row
+		for(size_t i=0; i<adj[v].size(); i++) {
+			vector<Arc>& row = adj[ adj[v][i].to ];
+			deleted[ adj[v][i].to ]++;
+			depth[ adj[v][i].to ] = std::max( depth[ adj[v][i].to ], depth[v] + 1 );
+			for(size_t k=0; k<row.size(); k++) {
+				if( row[k].to == v ) {
+					row[k] = row.back();
+					row.pop_back();
+					break;
+				}
+			}
+		}
+	}
+
+	// the core shares the top rank, each vertex keeping its edges
+	num_core = n - order;
+	for(int v=0; v<n; v++)
+		if( !contracted[v] ) rank[v] = order;
+
+	up1.assign(n+1, 0);
+	for(int v=0; v<n; v++)
+		up1[v+1] = up1[v] + adj[v].size();
+	up2.resize( up1[n] );
+	up_weight.resize( up1[n] );
+	up_mid.resize( up1[n] );
+	for(int v=0; v<n; v++) {
+		for(size_t i=0; i<adj[v].size(); i++) {
+			up2[ up1[v] + i ] = adj[v][i].to;
+			up_weight[ up1[v] + i ] = adj[v][i].weight;
+			up_mid[ up1[v] + i ] = adj[v][i].mid;
+		}
+	}
+	vector< vector<Arc> >().swap(adj);
+	vector<bool>().swap(contracted);
+	vector<int>().swap(deleted);
+	vector<unsigned>().swap(witness_stamp);
+	vector<int>().swap(witness_dist);
+	vector<unsigned>().swap(witness_target);
+	init_query();
+}
+
+/*
+	the shortcuts contracting v needs between each pair of its
+	remaining neighbors, added to the graph unless simulating
+*/
+int ContractionHierarchy::contract(int v, bool simulate) {
+
+	const vector<Arc>& arcs = adj[v];
+	int count = 0;
+	for(size_t i=0; i+1<arcs.size(); i++) {
+		int u = arcs[i].to;
+		int limit = 0;
+		if( ++witness_epoch == 0 ) {
+			std::fill( witness_stamp.begin(), witness_stamp.end(), 0u );
+			std::fill( witness_target.begin(), witness_target.end(), 0u );
+			witness_epoch = 1;
+		}
+		for(size_t j=i+1; j<arcs.size(); j++) {
+			limit = std::max( limit, arcs[j].weight );
+			witness_target[ arcs[j].to ] = witness_epoch;
+		}
+		witness_search( u, v, arcs[i].weight + limit, arcs.size() - i - 1 );
+
+		for(size_t j=i+1; j<arcs.size(); j++) {
+			int w = arcs[j].to;
+			int through = arcs[i].weight + arcs[j].weight;
+			if( witness_stamp[w] == witness_epoch && witness_dist[w] <= through ) continue;
+			count++;
+			if( !simulate ) add_arc( u, w, through, v );
+		}
+	}
+	return count;
+}
+
+/*
+	join u and w by an edge of the given weight through mid,
+	or lower the weight of the edge they already have
+*/
+void ContractionHierarchy::add_arc(int u, int w, int weight, int mid) {
+
+	int ends[2][2] = { {u, w}, {w, u} };
+	for(int e=0; e<2; e++) {
+		vector<Arc>& row = adj[ ends[e][0] ];
+		size_t k = 0;
+		while( k < row.size() && row[k].to != ends[e][1] ) k++;
+		if( k == row.size() ) {
+			Arc arc = { ends[e][1], weight, mid };
+			row.push_back(arc);
+		} else if( weight < row[k].weight ) {
+			row[k].weight = weight;
+			row[k].mid = mid;
+		}
+	}
+}
+
+/*
+	Dijkstra from s over the remaining graph without avoid,
+	until the num_targets marked vertices are settled, the
+	least key passes limit, or CH_WITNESS_SETTLED vertices are
+	settled or CH_WITNESS_SCANNED edges scanned, leaving
+	distances in witness_dist
+*/
+void ContractionHierarchy::witness_search(int s, int avoid, int limit, int num_targets) {
+
+	std::greater<KeyVert> later;
+	vector<KeyVert>& heap = witness_heap;
+	heap.clear();
+	witness_stamp[s] = witness_epoch;
+	witness_dist[s] = 0;
+	heap.push_back( KeyVert(0, s) );
+
+	int count = 0;
+	long long scanned = 0;
+	while( !heap.empty() && count < CH_WITNESS_SETTLED && scanned < CH_WITNESS_SCANNED ) {
+		int d = heap.front().first, u = heap.front().second;
+		std::pop_heap( heap.begin(), heap.end(), later );
+		heap.pop_back();
+		if( d > witness_dist[u] ) continue;
+		if( d > limit ) break;
+		count++;
+		if( witness_target[u] == witness_epoch && --num_targets == 0 ) break;
+		scanned += adj[u].size();
+		for(size_t i=0; i<adj[u].size(); i++) {
+			int x = adj[u][i].to;
+			if( x == avoid ) continue;
+			int nd = d + adj[u][i].weight;
+			if( witness_stamp[x] != witness_epoch || nd < witness_dist[x] ) {
+				witness_stamp[x] = witness_epoch;
+				witness_dist[x] = nd;
+				heap.push_back( KeyVert(nd, x) );
+				std::push_heap( heap.begin(), heap.end(), later );
+			}
+		}
+	}
+}
+
+/*
+	the priority of v: twice the shortcuts it would add less
+	the edges it would remove, plus its neighbors contracted
+	and its depth.  INT_MAX, for the core, past CH_CORE_DEGREE
+*/
+int ContractionHierarchy::priority(int v) {
+	if( adj[v].size() > CH_CORE_DEGREE ) return INT_MAX;
+	return 2 * ( contract(v, true) - (int)adj[v].size() ) + deleted[v] + depth[v];
+}
+
+/* write all of len bytes, false on an error */
+static bool write_all(int fd, const void* data, size_t len) {
+
+	const char* p = (const char*)data;
+	while( len > 0 ) {
+		ssize_t n = write( fd, p, len );
+		if( n <= 0 ) return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/* read len bytes at offset, false if the file is cut short */
+static bool read_at(int fd, int64_t offset, void* data, size_t len) {
+
+	char* p = (char*)data;
+	while( len > 0 ) {
+		ssize_t n = pread( fd, p, len, offset );
+		if( n <= 0 ) return false;
+		p += n;
+		offset += n;
+		len -= n;
+	}
+	return true;
+}
+
+/*
+	write the hierarchy to file, recording the hash of the
+	graph it was built from.  It is written to a temporary
+	file and renamed into place, so no reader sees half of it
+*/
+bool ContractionHierarchy::save(string file, uint64_t graph_hash) {
+
+	char suffix[32];
+	snprintf( suffix, sizeof(suffix), ".tmp%d", (int)getpid() );
+	string tmp = file + suffix;
+	int fd = open( tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 ) return false;
+
+	ChHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, CH_MAGIC, CH_MAGIC_LEN );
+	header.num_verts = num_verts;
+	header.num_arcs = up2.size();
+	header.graph_hash = graph_hash;
+	header.offsets_at = csr_next_section( 0, sizeof(header) / 4 );
+	header.targets_at = csr_next_section( header.offsets_at, header.num_verts + 1 );
+	header.weights_at = csr_next_section( header.targets_at, header.num_arcs );
+	header.mids_at = csr_next_section( header.weights_at, header.num_arcs );
+	header.ranks_at = csr_next_section( header.mids_at, header.num_arcs );
+
+	const vector<int>* sections[5] = { &up1, &up2, &up_weight, &up_mid, &rank };
+	int64_t starts[5] = { header.offsets_at, header.targets_at, header.weights_at, header.mids_at, header.ranks_at };
+	const char zeros[8] = {0};
+
+	bool ok = write_all( fd, &header, sizeof(header) );
+	int64_t at = sizeof(header);
+	for(int s=0; s<5 && ok; s++) {
+		ok = write_all( fd, zeros, starts[s] - at );
+		if( ok && !sections[s]->empty() )
+			ok = write_all( fd, &(*sections[s])[0], sections[s]->size() * sizeof(int) );
+		at = starts[s] + sections[s]->size() * sizeof(int);
+	}
+	if( close(fd) != 0 ) ok = false;
+	if( ok ) ok = rename( tmp.c_str(), file.c_str() ) == 0;
+	if( !ok ) unlink( tmp.c_str() );
+	return ok;
+}
+
+/*
+	read a hierarchy from file, false if there is none
+	or it was built from a graph of another hash
+*/
+bool ContractionHierarchy::load(string file, uint64_t graph_hash) {
+
+	int fd = open( file.c_str(), O_RDONLY );
+	if( fd < 0 ) return false;
+
+	ChHeader header;
+	bool ok = read_at( fd, 0, &header, sizeof(header) )
+		&& memcmp( header.magic, CH_MAGIC, CH_MAGIC_LEN ) == 0
+		&& header.graph_hash == graph_hash
+		&& header.num_verts >= 0 && header.num_verts < INT_MAX
+		&& header.num_arcs >= 0 && header.num_arcs <= INT_MAX;
+	if( ok ) {
+		num_verts = header.num_verts;
+		up1.resize( num_verts + 1 );
+		up2.resize( header.num_arcs );
+		up_weight.resize( header.num_arcs );
+		up_mid.resize( header.num_arcs );
+		rank.resize( num_verts );
+
+		vector<int>* sections[5] = { &up1, &up2, &up_weight, &up_mid, &rank };
+		int64_t starts[5] = { header.offsets_at, header.targets_at, header.weights_at, header.mids_at, header.ranks_at };
+		for(int s=0; s<5 && ok; s++)
+			if( !sections[s]->empty() )
+				ok = read_at( fd, starts[s], &(*sections[s])[0], sections[s]->size() * sizeof(int) );
+	}
+	close(fd);
+	if( ok ) {
+		int top = num_verts > 0 ? *std::max_element( rank.begin(), rank.end() ) : 0;
+		num_core = num_verts - top;
+		init_query();
+	}
+	return ok;
+}
+
+/* size the marks of both sides of a query */
+void ContractionHierarchy::init_query() {
+	Side* sides[2] = { &fwd, &bwd };
+	for(int i=0; i<2; i++) {
+		sides[i]->stamp.assign(num_verts, 0);
+		sides[i]->dist.assign(num_verts, 0);
+		sides[i]->parent.assign(num_verts, -1);
+	}
+	epoch = 0;
+}
+
+/*
+	the distance from s to t, or -1 if t cannot be reached:
+	search up the hierarchy from both ends, each step settling
+	the least key of either side, until neither side's least
+	key is under the best meeting
+*/
+int ContractionHierarchy::query(int s, int t) {
+
+	if( ++epoch == 0 ) {
+		std::fill( fwd.stamp.begin(), fwd.stamp.end(), 0u );
+		std::fill( bwd.stamp.begin(), bwd.stamp.end(), 0u );
+		epoch = 1;
+	}
+	best = INT_MAX;
+	meet = -1;
+	settled = 0;
+	fwd.heap.clear();
+	bwd.heap.clear();
+	reach(fwd, s, 0, -1);
+	reach(bwd, t, 0, -1);
+
+	std::greater<KeyVert> later;
+	for(;;) {
+		bool f_open = !fwd.heap.empty() && fwd.heap.front().first < best;
+		bool b_open = !bwd.heap.empty() && bwd.heap.front().first < best;
+		if( !f_open && !b_open ) break;
+		bool forward = f_open && ( !b_open || fwd.heap.front().first <= bwd.heap.front().first );
+		Side& side = forward ? fwd : bwd;
+		Side& other = forward ? bwd : fwd;
+
+		int d = side.heap.front().first, u = side.heap.front().second;
+		std::pop_heap( side.heap.begin(), side.heap.end(), later );
+		side.heap.pop_back();
+		if( d > side.dist[u] ) continue;
+		settled++;
+
+		if( seen(other, u) && d + other.dist[u] < best ) {
+			best = d + other.dist[u];
+			meet = u;
+		}
+
+		// stall u if a higher neighbor reaches it shorter, since
+		// no shortest path then climbs through u
+		bool stalled = false;
+		for(int j=up1[u]; j<up1[u+1] && !stalled; j++) {
+			int x = up2[j];
+			stalled = seen(side, x) && side.dist[x] + up_weight[j] < d;
+		}
+		if( stalled ) continue;
+
+		for(int j=up1[u]; j<up1[u+1]; j++) {
+			int x = up2[j], nd = d + up_weight[j];
+			if( !seen(side, x) || nd < side.dist[x] )
+				reach(side, x, nd, u);
+		}
+	}
+	return ( meet < 0 ) ? -1 : best;
+}
+
+/* whether a side has reached v in this query */
+inline bool ContractionHierarchy::seen(const Side& side, int v) {
+	return side.stamp[v] == epoch;
+}
+
+/* reach v from p at distance d, queueing it */
+void ContractionHierarchy::reach(Side& side, int v, int d, int p) {
+	side.stamp[v] = epoch;
+	side.dist[v] = d;
+	side.parent[v] = p;
+	side.heap.push_back( KeyVert(d, v) );
+	std::push_heap( side.heap.begin(), side.heap.end(), std::greater<KeyVert>() );
+}
+
+/*
+	the vertices of a shortest path of the last query in order,
+	with the distance of each from the source, by unpacking
+	the shortcuts of the path up to the meeting and down again.
+	Empty if the target was not reached
+*/
+void ContractionHierarchy::get_path(vector<int>& path, vector<int>& dists) {
+
+	path.clear();
+	dists.clear();
+	if( meet < 0 ) return;
+
+	vector<int> ups;
+	for(int v=meet; v!=-1; v=fwd.parent[v])
+		ups.push_back(v);
+	std::reverse( ups.begin(), ups.end() );
+	for(int v=bwd.parent[meet]; v!=-1; v=bwd.parent[v])
+		ups.push_back(v);
+
+	path.push_back( ups[0] );
+	dists.push_back(0);
+	for(size_t i=0; i+1<ups.size(); i++)
+		unpack( ups[i], ups[i+1], path, dists );
+}
+
+/*
+	append the edges from a to b, adjacent in the hierarchy,
+	expanding a shortcut into the two edges through its mid
+*/
+void ContractionHierarchy::unpack(int a, int b, vector<int>& path, vector<int>& dists) {
+
+	int low = ( rank[a] < rank[b] ) ? a : b;
+	int high = a + b - low;
+	int j = up1[low];
+	while( up2[j] != high ) j++;
+
+	if( up_mid[j] < 0 ) {
+		path.push_back(b);
+		dists.push_back( dists.back() + up_weight[j] );
+		return;
+	}
+	unpack( a, up_mid[j], path, dists );
+	unpack( up_mid[j], b, path, dists );
+}
+
+/* the number of vertices of the hierarchy */
+int ContractionHierarchy::get_num_verts() {
+	return num_verts;
+}
+
+/* the number of upward edges, shortcuts included */
+long long ContractionHierarchy::get_num_arcs() {
+	return up2.size();
+}
+
+/* the number of upward edges that are shortcuts */
+long long ContractionHierarchy::get_num_shortcuts() {
+	return up2.size() - std::count( up_mid.begin(), up_mid.end(), -1 );
+}
+
+/* the vertices sharing the top rank, left uncontracted */
+int ContractionHierarchy::get_num_core() {
+	return num_core;
+}
+
+/* the vertices the last query settled */
+int ContractionHierarchy::get_settled() {
+	return settled;
+}
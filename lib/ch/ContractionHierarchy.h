@@ -0,0 +1,165 @@
+/*
+	Think-Like-A-Vertex Framework, ContractionHierarchy.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	A contraction hierarchy over a weighted undirected graph,
+	for repeated point-to-point shortest path queries without
+	a traversal of the whole graph per query.
+
+	Vertices are contracted one at a time, least important
+	first: the importance of a vertex is twice the shortcuts its
+	contraction adds less the edges it removes, plus the
+	neighbors already contracted and its depth in the hierarchy,
+	kept up to date lazily.
+	Contracting v joins each pair of its remaining neighbors
+	u, w by a shortcut of weight d(u,v)+d(v,w) through v,
+	unless a witness search from u that avoids v, settling at
+	most CH_WITNESS_SETTLED vertices, finds a path as short.
+	The edges v has left when it is contracted, all to vertices
+	contracted later, are its upward edges.
+
+	Contraction stops once the least important vertex has more
+	than CH_CORE_DEGREE edges left, as the hubs of a power-law
+	graph soon do: the vertices left form a core that shares the
+	top rank and keeps all its edges, so the query runs a plain
+	bidirectional Dijkstra within it.
+
+	A query is a Dijkstra search up the hierarchy from each end,
+	over the upward edges only, since the graph is undirected.
+	The sides take turns by the lesser key, each stopping once
+	its least key is no less than the best meeting.  A vertex
+	that a higher neighbor reaches by a shorter way is stalled,
+	not expanded, and a path is unpacked by replacing each
+	shortcut with its two edges.
+
+	The hierarchy is stored next to the graph file as an image
+	in the manner of CsrImage.h:
+
+		offsets		int32[num_verts+1], the upward rows
+		targets		int32[num_arcs], the head of each upward edge
+		weights		int32[num_arcs]
+		mids		int32[num_arcs], the vertex a shortcut passes,
+				-1 for an edge of the graph
+		ranks		int32[num_verts], the contraction order,
+				the core sharing the last
+
+	along with the content hash of the CSR arrays it was built
+	from (ResultCache::hash_csr), so a changed edge or weight
+	makes it stale even if the graph file keeps its size.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#define CH_MAGIC "TLAVCH02"
+#define CH_MAGIC_LEN 8
+
+// vertices a witness search settles before giving up
+#define CH_WITNESS_SETTLED 500
+
+// edges a witness search scans before giving up, so that
+// it does not wade through the rows of the hubs
+#define CH_WITNESS_SCANNED 1000
+
+// edges left past which a vertex is left in the core
+#define CH_CORE_DEGREE 16
+
+struct ChHeader {
+	char magic[CH_MAGIC_LEN];
+	int64_t num_verts;
+	int64_t num_arcs;
+	uint64_t graph_hash;
+
+	// byte offsets of each section
+	int64_t offsets_at;
+	int64_t targets_at;
+	int64_t weights_at;
+	int64_t mids_at;
+	int64_t ranks_at;
+};
+
+class ContractionHierarchy {
+
+	public:
+		ContractionHierarchy();
+
+		void build(int, const int*, const int*, const int*);
+		bool save(string, uint64_t);
+		bool load(string, uint64_t);
+
+		int query(int, int);
+		void get_path(vector<int>&, vector<int>&);
+
+		int get_num_verts();
+		long long get_num_arcs();
+		long long get_num_shortcuts();
+		int get_num_core();
+		int get_settled();
+
+	private:
+		// an edge of the remaining graph while building
+		struct Arc {
+			int to;
+			int weight;
+			int mid;
+		};
+
+		// a direction of the query
+		struct Side {
+			vector<unsigned> stamp;
+			vector<int> dist;
+			vector<int> parent;
+			vector< std::pair<int,int> > heap;
+		};
+
+		int contract(int, bool);
+		void add_arc(int, int, int, int);
+		void witness_search(int, int, int, int);
+		int priority(int);
+
+		void init_query();
+		bool seen(const Side&, int);
+		void reach(Side&, int, int, int);
+		void unpack(int, int, vector<int>&, vector<int>&);
+
+		// the upward rows, their weights and the vertices shortcuts pass
+		int num_verts;
+		vector<int> up1;
+		vector<int> up2;
+		vector<int> up_weight;
+		vector<int> up_mid;
+		vector<int> rank;
+		int num_core;
+
+		// the remaining graph while building, and the witness search
+		// marks: the vertices reached, and those it looks for
+		vector< vector<Arc> > adj;
+		vector<bool> contracted;
+		vector<int> deleted;
+		vector<int> depth;
+		vector<unsigned> witness_stamp;
+		vector<int> witness_dist;
+		vector<unsigned> witness_target;
+		vector< std::pair<int,int> > witness_heap;
+		unsigned witness_epoch;
+
+		// the last query
+		Side fwd;
+		Side bwd;
+		unsigned epoch;
+		int meet;
+		int best;
+		int settled;
+
+};
+
+#endif
@@ -10,8 +10,8 @@
 	and tracks the number of elements in the array with size.
 	when size reaches capacity, the array capacity is doubled
 	
-	For TLAV, this is used only by the Graph class in dynamically 
-	creating arrays to store graph information, not by TLAV programs
+	The Graph class now sizes its arrays up front in an Arena,
+	so this is kept only as a baseline for the microbenchmarks
 */
 
 #ifndef DYNAMIC_ARRAY_H
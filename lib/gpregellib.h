@@ -17,8 +17,25 @@
 #include <fstream>
 #include <iostream>
 #include <limits.h>
+#include <string.h>
+#include <thread>
+#include <new>
+#include <algorithm>
+#include <sys/stat.h>
 
 // Pregel headers
+#include "Options.h"
+#include "Barrier.h"
+#include "Numa.h"
+#include "BufferedWriter.h"
+#include "ResultWriter.h"
+#include "AsyncReader.h"
+#include "ResultCache.h"
+#include "Metrics.h"
+#include "PerfCounters.h"
+#include "PullKernels.h"
+#include "Semiring.h"
+#include "Planner.h"
 #include "Graph.h"
 #include "Message.h"
 #include "Vertex.h"
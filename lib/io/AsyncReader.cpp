@@ -0,0 +1,361 @@
+/*
+	Think-Like-A-Vertex Framework, AsyncReader.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the asynchronous file reader
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define AR_HAVE_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#include "AsyncReader.h"
+
+/* the mapped submission and completion rings of an io_uring */
+struct AsyncReader::Ring {
+	int fd;
+	unsigned entries;
+	unsigned* sq_tail;
+	unsigned* sq_mask;
+	unsigned* sq_array;
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned* cq_mask;
+	void* sqes;
+	void* cqes;
+	void* sq_ring;
+	void* cq_ring;
+	size_t sq_len;
+	size_t cq_len;
+	size_t sqes_len;
+};
+
+/* Constructor, with no file open */
+AsyncReader::AsyncReader() {
+	fd = -1;
+	size = 0;
+	uring = false;
+	ring = NULL;
+	next_claim = 0;
+	published = 0;
+	taken = 0;
+	failed = false;
+}
+
+/* Destructor, wait for the reads in flight and close */
+AsyncReader::~AsyncReader() {
+	finish();
+}
+
+/* open a file to read, false if it cannot be */
+bool AsyncReader::open(string infile) {
+	finish();
+	filename = infile;
+	fd = ::open( infile.c_str(), O_RDONLY );
+	struct stat st;
+	if( fd < 0 || fstat(fd, &st) != 0 ) {
+		if( fd >= 0 ) ::close(fd);
+		fd = -1;
+		return false;
+	}
+	size = st.st_size;
+	return true;
+}
+
+/* the size of the open file in bytes */
+int64_t AsyncReader::get_size() {
+	return size;
+}
+
+/*
+	read len bytes at offset into dest, as pieces ending
+	on block boundaries of the file
+*/
+void AsyncReader::add(int64_t offset, int64_t len, void* dest) {
+	char* out = (char*)dest;
+	while( len > 0 ) {
+		ReadPiece piece;
+		piece.offset = offset;
+		piece.len = std::min( len, AR_BLOCK - offset % AR_BLOCK );
+		piece.dest = out;
+		pieces.push_back(piece);
+		offset += piece.len;
+		out += piece.len;
+		len -= piece.len;
+	}
+}
+
+/*
+	start reading every piece added, through an io_uring
+	unless mode is READ_PREAD or it cannot be set up
+*/
+void AsyncReader::start(int mode) {
+	next_claim = published = taken = 0;
+	failed = false;
+	if( pieces.empty() ) return;
+
+	if( mode != READ_PREAD ) ring = setup_ring(AR_DEPTH);
+	uring = ( ring != NULL );
+	if( uring ) {
+		threads.push_back( std::thread( &AsyncReader::uring_main, this ) );
+	} else {
+		int pool = std::min( AR_DEPTH, (int)pieces.size() );
+		for(int t=0; t<pool; t++)
+			threads.push_back( std::thread( &AsyncReader::pread_main, this ) );
+	}
+}
+
+/*
+	take a piece that has been read, waiting for one if none
+	has.  False once every piece has been taken
+*/
+bool AsyncReader::next(int& i) {
+	std::unique_lock<std::mutex> lock(mtx);
+	while( ready.empty() && taken < (int)pieces.size() )
+		cond.wait(lock);
+	if( ready.empty() ) return false;
+	i = ready.front();
+	ready.pop_front();
+	taken++;
+	return true;
+}
+
+/* wait for the reads in flight, then release the ring and file */
+void AsyncReader::finish() {
+	for(size_t t=0; t<threads.size(); t++)
+		threads[t].join();
+	threads.clear();
+	close_ring(ring);
+	ring = NULL;
+	if( fd >= 0 ) ::close(fd);
+	fd = -1;
+	pieces.clear();
+	ready.clear();
+}
+
+/* the number of pieces to read */
+int AsyncReader::get_num_pieces() {
+	return pieces.size();
+}
+
+/* a piece to read */
+const ReadPiece& AsyncReader::get_piece(int i) {
+	return pieces[i];
+}
+
+/* whether any piece could not be read in full */
+bool AsyncReader::get_failed() {
+	std::lock_guard<std::mutex> lock(mtx);
+	return failed;
+}
+
+/* whether the reads go through an io_uring */
+bool AsyncReader::get_uring() {
+	return uring;
+}
+
+/* the mode named auto, uring or pread, -1 for any other */
+int AsyncReader::parse_mode(string name) {
+	if( name == "auto" ) return READ_AUTO;
+	if( name == "uring" ) return READ_URING;
+	if( name == "pread" ) return READ_PREAD;
+	return -1;
+}
+
+/***** Private functions *****/
+
+/* hand a read piece to the takers */
+void AsyncReader::publish(int i, bool ok) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if( !ok ) failed = true;
+	ready.push_back(i);
+	published++;
+	cond.notify_all();
+}
+
+/* read all of a piece with pread, false if the file ends first */
+bool AsyncReader::read_piece(int i) {
+	ReadPiece& piece = pieces[i];
+	int64_t done = 0;
+	while( done < piece.len ) {
+		ssize_t n = pread( fd, piece.dest + done, piece.len - done, piece.offset + done );
+		if( n < 0 && errno == EINTR ) continue;
+		if( n <= 0 ) return false;
+		done += n;
+	}
+	return true;
+}
+
+/* a thread of the pread pool, reading the next unclaimed piece */
+void AsyncReader::pread_main() {
+	for(;;) {
+		int i;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if( next_claim == (int)pieces.size() ) return;
+			i = next_claim++;
+		}
+		publish( i, read_piece(i) );
+	}
+}
+
+#ifdef AR_HAVE_URING
+
+/*
+	set up an io_uring of entries submissions and map its rings,
+	NULL if the kernel has none or refuses it
+*/
+AsyncReader::Ring* AsyncReader::setup_ring(unsigned entries) {
+
+	struct io_uring_params params;
+	memset( &params, 0, sizeof(params) );
+	int ring_fd = syscall( __NR_io_uring_setup, entries, &params );
+	if( ring_fd < 0 ) return NULL;
+
+	Ring* r = new Ring;
+	r->fd = ring_fd;
+	r->entries = params.sq_entries;
+	r->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	r->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	r->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	// newer kernels map both rings at once
+	bool single = ( params.features & IORING_FEAT_SINGLE_MMAP );
+	if( single ) r->sq_len = r->cq_len = std::max( r->sq_len, r->cq_len );
+	r->sq_ring = mmap( NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING );
+	r->cq_ring = single ? r->sq_ring
+		: mmap( NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING );
+	r->sqes = mmap( NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES );
+	if( r->sq_ring == MAP_FAILED || r->cq_ring == MAP_FAILED || r->sqes == MAP_FAILED ) {
+		if( r->sq_ring != MAP_FAILED ) munmap( r->sq_ring, r->sq_len );
+		if( !single && r->cq_ring != MAP_FAILED ) munmap( r->cq_ring, r->cq_len );
+		if( r->sqes != MAP_FAILED ) munmap( r->sqes, r->sqes_len );
+		::close(ring_fd);
+		delete r;
+		return NULL;
+	}
+
+	char* sq = (char*)r->sq_ring;
+	char* cq = (char*)r->cq_ring;
+	r->sq_tail = (unsigned*)( sq + params.sq_off.tail );
+	r->sq_mask = (unsigned*)( sq + params.sq_off.ring_mask );
+	r->sq_array = (unsigned*)( sq + params.sq_off.array );
+	r->cq_head = (unsigned*)( cq + params.cq_off.head );
+	r->cq_tail = (unsigned*)( cq + params.cq_off.tail );
+	r->cq_mask = (unsigned*)( cq + params.cq_off.ring_mask );
+	r->cqes = cq + params.cq_off.cqes;
+	return r;
+}
+
+/* unmap the rings of an io_uring and close it */
+void AsyncReader::close_ring(Ring* r) {
+	if( r == NULL ) return;
+	munmap( r->sqes, r->sqes_len );
+	if( r->cq_ring != r->sq_ring ) munmap( r->cq_ring, r->cq_len );
+	munmap( r->sq_ring, r->sq_len );
+	::close( r->fd );
+	delete r;
+}
+
+/*
+	the thread driving the io_uring: keep the submission queue
+	full, and wait for completions.  A short read is resubmitted
+	for the rest of its piece, and a piece the ring fails to
+	read, as on kernels without IORING_OP_READ, is read by pread
+*/
+void AsyncReader::uring_main() {
+
+	Ring* r = ring;
+	int n = pieces.size();
+	vector<int64_t> done(n, 0);
+	std::deque<int> queue;
+	for(int i=0; i<n; i++)
+		queue.push_back(i);
+
+	int in_flight = 0, finished = 0;
+	unsigned unsubmitted = 0;
+	while( finished < n ) {
+		unsigned tail = *r->sq_tail;
+		while( in_flight < (int)r->entries && !queue.empty() ) {
+			int i = queue.front();
+			queue.pop_front();
+			unsigned idx = tail & *r->sq_mask;
+			struct io_uring_sqe* sqe = &( (struct io_uring_sqe*)r->sqes )[idx];
+			memset( sqe, 0, sizeof(*sqe) );
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = fd;
+			sqe->off = pieces[i].offset + done[i];
+			sqe->addr = (uint64_t)(uintptr_t)( pieces[i].dest + done[i] );
+			sqe->len = pieces[i].len - done[i];
+			sqe->user_data = i;
+			r->sq_array[idx] = idx;
+			tail++;
+			unsubmitted++;
+			in_flight++;
+		}
+		__atomic_store_n( r->sq_tail, tail, __ATOMIC_RELEASE );
+
+		int ret = syscall( __NR_io_uring_enter, r->fd, unsubmitted, 1, IORING_ENTER_GETEVENTS, NULL, 0 );
+		if( ret < 0 && errno != EINTR && errno != EAGAIN ) {
+			// the ring is unusable: read what is left by pread
+			for(int i=0; i<n; i++)
+				if( done[i] >= 0 && done[i] < pieces[i].len )
+					publish( i, read_piece(i) );
+			return;
+		}
+		if( ret > 0 ) unsubmitted -= std::min( (unsigned)ret, unsubmitted );
+
+		unsigned head = *r->cq_head;
+		unsigned cq_tail = __atomic_load_n( r->cq_tail, __ATOMIC_ACQUIRE );
+		for(; head != cq_tail; head++) {
+			struct io_uring_cqe* cqe = &( (struct io_uring_cqe*)r->cqes )[ head & *r->cq_mask ];
+			int i = cqe->user_data;
+			int res = cqe->res;
+			in_flight--;
+			if( res == -EINTR || res == -EAGAIN ) {
+				queue.push_front(i);
+			} else if( res < 0 ) {
+				publish( i, read_piece(i) );
+				done[i] = -1;
+				finished++;
+			} else if( res > 0 && done[i] + res < pieces[i].len ) {
+				done[i] += res;
+				queue.push_front(i);
+			} else {
+				publish( i, res > 0 );
+				done[i] = -1;
+				finished++;
+			}
+		}
+		__atomic_store_n( r->cq_head, head, __ATOMIC_RELEASE );
+	}
+}
+
+#else
+
+/* no io_uring on this system */
+AsyncReader::Ring* AsyncReader::setup_ring(unsigned) {
+	return NULL;
+}
+
+void AsyncReader::close_ring(Ring*) {}
+
+void AsyncReader::uring_main() {}
+
+#endif
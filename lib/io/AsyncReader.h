@@ -0,0 +1,100 @@
+/*
+	Think-Like-A-Vertex Framework, AsyncReader.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Asynchronous file reader, so the disk keeps reading while
+	the caller works on what has already arrived.
+
+	The caller lists the ranges of the file it wants and where
+	each goes, then starts the reader.  Ranges are split into
+	pieces of AR_BLOCK bytes at block-aligned file offsets, and
+	a queue of AR_DEPTH pieces is kept in flight, through a
+	Linux io_uring driven by one thread, or where io_uring is
+	missing or refused, a pool of AR_DEPTH threads each issuing
+	a pread.  Any number of threads take pieces with next()
+	as they complete, in whatever order they complete.
+
+	The io_uring is set up with raw system calls, so there
+	is no dependency on liburing.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef ASYNCREADER_H
+#define ASYNCREADER_H
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+using std::string;
+using std::vector;
+
+// bytes per read, and reads in flight
+#define AR_BLOCK (1<<20)
+#define AR_DEPTH 16
+
+// how reads are issued
+enum ReadMode { READ_AUTO, READ_URING, READ_PREAD };
+
+/* a range of the file, read into dest */
+struct ReadPiece {
+	int64_t offset;
+	int64_t len;
+	char* dest;
+};
+
+class AsyncReader {
+
+	public:
+		AsyncReader();
+		~AsyncReader();
+		bool open(string);
+		int64_t get_size();
+		void add(int64_t, int64_t, void*);
+		void start(int);
+		bool next(int&);
+		void finish();
+
+		int get_num_pieces();
+		const ReadPiece& get_piece(int);
+		bool get_failed();
+		bool get_uring();
+
+		static int parse_mode(string);
+
+	private:
+		struct Ring;
+		static Ring* setup_ring(unsigned);
+		static void close_ring(Ring*);
+		void uring_main();
+		void pread_main();
+		bool read_piece(int);
+		void publish(int, bool);
+
+		int fd;
+		int64_t size;
+		string filename;
+		vector<ReadPiece> pieces;
+		bool uring;
+
+		// the io_uring, if set up
+		Ring* ring;
+
+		// pieces claimed by the pread pool, and those complete
+		int next_claim;
+		std::deque<int> ready;
+		int published;
+		int taken;
+		bool failed;
+		std::mutex mtx;
+		std::condition_variable cond;
+		vector<std::thread> threads;
+
+};
+
+#endif
@@ -0,0 +1,280 @@
+/*
+	Think-Like-A-Vertex Framework, BufferedWriter.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the buffered file writer
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "BufferedWriter.h"
+
+// number of buffers, one being filled and the rest in flight
+#define NUM_BUFFERS 3
+
+/* two-digit pairs "00" to "99" for integer formatting */
+static const char digit_pairs[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/* Constructor, not yet open */
+BufferedWriter::BufferedWriter() {
+	fd = -1;
+	async = false;
+	stopping = false;
+	buf_size = 0;
+	cur.data = NULL;
+	cur.len = 0;
+	num_in_flight = 0;
+}
+
+/* Destructor, write everything and close */
+BufferedWriter::~BufferedWriter() {
+	close();
+}
+
+/*
+	open a file for writing, truncating it unless appending.
+	with async, buffers are written by a background thread
+*/
+bool BufferedWriter::open(string filename, bool _async, size_t buffer_size, bool append) {
+
+	close();
+
+	int flags = O_WRONLY | O_CREAT | ( append ? O_APPEND : O_TRUNC );
+	fd = ::open( filename.c_str(), flags, 0644 );
+	if( fd < 0 ) {
+		printf("error: cannot open %s for writing: %s\n", filename.c_str(), strerror(errno) );
+		return false;
+	}
+
+	async = _async;
+	stopping = false;
+	buf_size = buffer_size;
+	cur.data = (char*)malloc(buf_size);
+	cur.len = 0;
+	if( async ) {
+		for(int i=1; i<NUM_BUFFERS; i++) {
+			Buffer b;
+			b.data = (char*)malloc(buf_size);
+			b.len = 0;
+			free_q.push_back(b);
+		}
+		writer = std::thread( &BufferedWriter::writer_main, this );
+	}
+
+	return true;
+}
+
+/*
+	write out any buffered data, stop the writer thread,
+	and close the file
+*/
+void BufferedWriter::close() {
+
+	if( fd < 0 ) return;
+
+	flush();
+	if( async ) {
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stopping = true;
+		}
+		cond.notify_all();
+		writer.join();
+		while( free_q.size() > 0 ) {
+			free( free_q.front().data );
+			free_q.pop_front();
+		}
+	}
+	free(cur.data);
+	cur.data = NULL;
+	cur.len = 0;
+
+	::close(fd);
+	fd = -1;
+}
+
+/* is a file open */
+bool BufferedWriter::is_open() {
+	return fd >= 0;
+}
+
+/*
+	hand the current buffer to the writer and
+	wait until everything written so far is in the file
+*/
+void BufferedWriter::flush() {
+
+	if( fd < 0 ) return;
+	if( cur.len > 0 ) submit();
+	if( async ) {
+		std::unique_lock<std::mutex> lock(mtx);
+		while( full_q.size() > 0 || num_in_flight > 0 )
+			cond.wait(lock);
+	}
+}
+
+/* append raw bytes */
+void BufferedWriter::write(const void* src, size_t n) {
+
+	const char* bytes = (const char*)src;
+	while( n > 0 ) {
+		if( cur.len == buf_size ) submit();
+		size_t chunk = buf_size - cur.len;
+		if( chunk > n ) chunk = n;
+		memcpy( cur.data + cur.len, bytes, chunk );
+		cur.len += chunk;
+		bytes += chunk;
+		n -= chunk;
+	}
+}
+
+/* append a null-terminated string */
+void BufferedWriter::put_str(const char* str) {
+	write( str, strlen(str) );
+}
+
+/*
+	format an integer as decimal text into out,
+	two digits at a time, returns the number of characters
+*/
+int BufferedWriter::format_int(char* out, int v) {
+
+	char tmp[12];
+	int pos = 12;
+	unsigned int u = ( v < 0 ) ? 0u - (unsigned int)v : (unsigned int)v;
+
+	while( u >= 100 ) {
+		unsigned int r = (u % 100) * 2;
+		u /= 100;
+		tmp[--pos] = digit_pairs[r+1];
+		tmp[--pos] = digit_pairs[r];
+	}
+	if( u >= 10 ) {
+		tmp[--pos] = digit_pairs[u*2+1];
+		tmp[--pos] = digit_pairs[u*2];
+	} else {
+		tmp[--pos] = '0' + u;
+	}
+	if( v < 0 ) tmp[--pos] = '-';
+
+	int len = 12 - pos;
+	memcpy( out, tmp + pos, len );
+	return len;
+}
+
+/*
+	format a 64-bit integer as decimal text into out,
+	returns the number of characters
+*/
+int BufferedWriter::format_long(char* out, long long v) {
+
+	char tmp[24];
+	int pos = 24;
+	unsigned long long u = ( v < 0 ) ? 0ull - (unsigned long long)v : (unsigned long long)v;
+
+	while( u >= 100 ) {
+		unsigned int r = (u % 100) * 2;
+		u /= 100;
+		tmp[--pos] = digit_pairs[r+1];
+		tmp[--pos] = digit_pairs[r];
+	}
+	if( u >= 10 ) {
+		tmp[--pos] = digit_pairs[u*2+1];
+		tmp[--pos] = digit_pairs[u*2];
+	} else {
+		tmp[--pos] = '0' + u;
+	}
+	if( v < 0 ) tmp[--pos] = '-';
+
+	int len = 24 - pos;
+	memcpy( out, tmp + pos, len );
+	return len;
+}
+
+/*
+	format a float as decimal text into out, with the 9 significant
+	digits that read back as the same float, at most 15 characters.
+	Returns the number of characters
+*/
+int BufferedWriter::format_float(char* out, float v) {
+
+	char tmp[32];
+	int len = snprintf( tmp, sizeof(tmp), "%.9g", (double)v );
+	memcpy( out, tmp, len );
+	return len;
+}
+
+/*
+	hand off the current buffer, either writing it directly,
+	or queueing it for the writer and taking a free buffer
+*/
+void BufferedWriter::submit() {
+
+	if( !async ) {
+		write_fd( cur.data, cur.len );
+		cur.len = 0;
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mtx);
+	full_q.push_back(cur);
+	cond.notify_all();
+	while( free_q.size() == 0 )
+		cond.wait(lock);
+	cur = free_q.front();
+	free_q.pop_front();
+	cur.len = 0;
+}
+
+/* write all bytes to the file, retrying short writes */
+void BufferedWriter::write_fd(const char* data, size_t n) {
+	while( n > 0 ) {
+		ssize_t w = ::write( fd, data, n );
+		if( w < 0 ) {
+			if( errno == EINTR ) continue;
+			printf("error: write failed: %s\n", strerror(errno) );
+			return;
+		}
+		data += w;
+		n -= w;
+	}
+}
+
+/*
+	background thread, writes full buffers in order
+	and returns them to the free queue
+*/
+void BufferedWriter::writer_main() {
+
+	std::unique_lock<std::mutex> lock(mtx);
+	while( true ) {
+		while( full_q.size() == 0 && !stopping )
+			cond.wait(lock);
+		if( full_q.size() == 0 && stopping )
+			break;
+
+		Buffer b = full_q.front();
+		full_q.pop_front();
+		num_in_flight++;
+		lock.unlock();
+
+		write_fd( b.data, b.len );
+		b.len = 0;
+
+		lock.lock();
+		num_in_flight--;
+		free_q.push_back(b);
+		cond.notify_all();
+	}
+}
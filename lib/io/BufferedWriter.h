@@ -0,0 +1,112 @@
+/*
+	Think-Like-A-Vertex Framework, BufferedWriter.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Buffered file writer with an optional background thread.
+
+	Output is formatted into large buffers, and full buffers
+	are handed to a writer thread that issues large sequential
+	writes, so the caller never waits on the disk unless
+	every buffer is still in flight.
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <condition_variable>
+using std::string;
+
+class BufferedWriter {
+
+	public:
+		BufferedWriter();
+		~BufferedWriter();
+		bool open(string, bool async=true, size_t buffer_size=(4<<20), bool append=false);
+		void close();
+		bool is_open();
+		void flush();
+
+		void write(const void*, size_t);
+		void put(char);
+		void put_str(const char*);
+		void put_int(int);
+		void put_int32(int);
+		void put_float(float);
+		void put_float32(float);
+
+		static int format_int(char*, int);
+		static int format_long(char*, long long);
+		static int format_float(char*, float);
+
+	private:
+		struct Buffer {
+			char* data;
+			size_t len;
+		};
+
+		void submit();
+		void write_fd(const char*, size_t);
+		void writer_main();
+
+		int fd;
+		bool async;
+		bool stopping;
+		size_t buf_size;
+		Buffer cur;
+
+		// buffers waiting to be written, and buffers free to fill
+		std::deque<Buffer> full_q;
+		std::deque<Buffer> free_q;
+		int num_in_flight;
+		std::mutex mtx;
+		std::condition_variable cond;
+		std::thread writer;
+
+};
+
+/*
+	append a character, the common case inlined
+*/
+inline void BufferedWriter::put(char c) {
+	if( cur.len == buf_size ) submit();
+	cur.data[cur.len++] = c;
+}
+
+/*
+	append an integer as decimal text
+*/
+inline void BufferedWriter::put_int(int v) {
+	if( buf_size - cur.len < 12 ) submit();
+	cur.len += format_int( cur.data + cur.len, v );
+}
+
+/*
+	append an integer as 4 raw bytes
+*/
+inline void BufferedWriter::put_int32(int v) {
+	write( &v, sizeof(int) );
+}
+
+/*
+	append a float as decimal text, exact enough to read back
+*/
+inline void BufferedWriter::put_float(float v) {
+	if( buf_size - cur.len < 16 ) submit();
+	cur.len += format_float( cur.data + cur.len, v );
+}
+
+/*
+	append a float as 4 raw bytes
+*/
+inline void BufferedWriter::put_float32(float v) {
+	write( &v, sizeof(float) );
+}
+
+#endif
@@ -0,0 +1,300 @@
+/*
+	Think-Like-A-Vertex Framework, ResultWriter.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the result writer
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+#include "BufferedWriter.h"
+#include "ResultWriter.h"
+
+// bytes each thread formats before writing
+#define FORMAT_BUFFER (4<<20)
+
+// fewest vertices worth giving their own thread
+#define MIN_THREAD_VERTS (1<<16)
+
+// longest single write, writes larger than this are split
+#define MAX_WRITE (1<<30)
+
+/* the number of characters of an integer as decimal text */
+static inline int int_length(int v) {
+	unsigned int u = ( v < 0 ) ? 0u - (unsigned int)v : (unsigned int)v;
+	int len = ( v < 0 ) ? 1 : 0;
+	if( u < 10 ) return len + 1;
+	if( u < 100 ) return len + 2;
+	if( u < 1000 ) return len + 3;
+	if( u < 10000 ) return len + 4;
+	if( u < 100000 ) return len + 5;
+	if( u < 1000000 ) return len + 6;
+	if( u < 10000000 ) return len + 7;
+	if( u < 100000000 ) return len + 8;
+	if( u < 1000000000 ) return len + 9;
+	return len + 10;
+}
+
+/*
+	the text of a value, its length, and whether it is missing:
+	INT_MAX for the int programs, infinity for the float ones,
+	LLONG_MAX for the int64 ones
+*/
+static inline int format_value(char* out, int v) { return BufferedWriter::format_int(out, v); }
+static inline int format_value(char* out, float v) { return BufferedWriter::format_float(out, v); }
+static inline int format_value(char* out, long long v) { return BufferedWriter::format_long(out, v); }
+static inline int value_length(int v) { return int_length(v); }
+static inline int value_length(float v) { char tmp[32]; return BufferedWriter::format_float(tmp, v); }
+static inline int value_length(long long v) { char tmp[24]; return BufferedWriter::format_long(tmp, v); }
+static inline bool is_missing(int v) { return v == INT_MAX; }
+static inline bool is_missing(float v) { return isinf(v); }
+static inline bool is_missing(long long v) { return v == LLONG_MAX; }
+
+/* Constructor */
+ResultWriter::ResultWriter(int _num_threads) {
+	num_threads = ( _num_threads < 1 ) ? 1 : _num_threads;
+}
+
+/*
+	write the values as the named format, text or binary
+*/
+bool ResultWriter::write(string outfile, string format, string header,
+		const int* values, int num_verts, const char* missing) {
+
+	if( format == "binary" )
+		return write_binary(outfile, values, num_verts);
+	return write_text(outfile, header, values, num_verts, missing);
+}
+
+bool ResultWriter::write(string outfile, string format, string header,
+		const float* values, int num_verts, const char* missing) {
+
+	if( format == "binary" )
+		return write_binary(outfile, values, num_verts);
+	return write_text(outfile, header, values, num_verts, missing);
+}
+
+bool ResultWriter::write(string outfile, string format, string header,
+		const long long* values, int num_verts, const char* missing) {
+
+	if( format == "binary" )
+		return write_binary(outfile, values, num_verts);
+	return write_text(outfile, header, values, num_verts, missing);
+}
+
+/*
+	write a header line, then one line per vertex of
+	its id and value.  Missing values are written as
+	the missing string, unless it is NULL.
+*/
+bool ResultWriter::write_text(string outfile, string header,
+		const int* values, int num_verts, const char* missing) {
+	return write_text_values(outfile, header, values, num_verts, missing);
+}
+
+bool ResultWriter::write_text(string outfile, string header,
+		const float* values, int num_verts, const char* missing) {
+	return write_text_values(outfile, header, values, num_verts, missing);
+}
+
+bool ResultWriter::write_text(string outfile, string header,
+		const long long* values, int num_verts, const char* missing) {
+	return write_text_values(outfile, header, values, num_verts, missing);
+}
+
+/*
+	the text output of any value type: the length of each
+	thread's range first, then every range formatted in place
+*/
+template<typename V>
+bool ResultWriter::write_text_values(string outfile, string header,
+		const V* values, int num_verts, const char* missing) {
+
+	int threads = num_verts / MIN_THREAD_VERTS + 1;
+	if( threads > num_threads ) threads = num_threads;
+
+	// split the vertices evenly, then place each range by its length
+	std::vector<Range> ranges(threads);
+	long long offset = header.size() + 1;
+	for(int t=0; t<threads; t++) {
+		ranges[t].begin = (long long)num_verts * t / threads;
+		ranges[t].end = (long long)num_verts * (t+1) / threads;
+	}
+	std::vector<long long> lengths(threads);
+	if( threads == 1 ) {
+		lengths[0] = text_length(ranges[0].begin, ranges[0].end, values, missing);
+	} else {
+		std::vector<std::thread> pool;
+		for(int t=0; t<threads; t++)
+			pool.push_back( std::thread( [&, t]() {
+				lengths[t] = text_length(ranges[t].begin, ranges[t].end, values, missing);
+			} ) );
+		for(int t=0; t<threads; t++)
+			pool[t].join();
+	}
+	for(int t=0; t<threads; t++) {
+		ranges[t].offset = offset;
+		offset += lengths[t];
+	}
+
+	int fd = ::open( outfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 ) {
+		printf("error: cannot open %s: %s\n", outfile.c_str(), strerror(errno));
+		return false;
+	}
+	// size the file up front so every thread writes in place
+	if( ftruncate(fd, offset) != 0 ) {
+		printf("error: cannot size %s: %s\n", outfile.c_str(), strerror(errno));
+		::close(fd);
+		return false;
+	}
+
+	string line = header + "\n";
+	bool ok = pwrite_all(fd, line.c_str(), line.size(), 0);
+
+	if( threads == 1 ) {
+		ok = format_range(fd, ranges[0], values, missing) && ok;
+	} else {
+		std::vector<std::thread> pool;
+		std::vector<char> status(threads);
+		for(int t=0; t<threads; t++)
+			pool.push_back( std::thread( [&, t]() {
+				status[t] = format_range(fd, ranges[t], values, missing);
+			} ) );
+		for(int t=0; t<threads; t++) {
+			pool[t].join();
+			ok = status[t] && ok;
+		}
+	}
+
+	if( ::close(fd) != 0 ) ok = false;
+	if( !ok )
+		printf("error: writing %s: %s\n", outfile.c_str(), strerror(errno));
+	return ok;
+}
+
+/*
+	write the 8 byte magic, the int32 number of
+	vertices, and the raw int32 value of every vertex
+*/
+bool ResultWriter::write_binary(string outfile, const int* values, int num_verts) {
+	return write_binary_values(outfile, "TLAVRES1", values, num_verts, sizeof(int));
+}
+
+/* the same, of raw float values after the magic TLAVRESF */
+bool ResultWriter::write_binary(string outfile, const float* values, int num_verts) {
+	return write_binary_values(outfile, "TLAVRESF", values, num_verts, sizeof(float));
+}
+
+/* and of raw int64 values after the magic TLAVRESL */
+bool ResultWriter::write_binary(string outfile, const long long* values, int num_verts) {
+	return write_binary_values(outfile, "TLAVRESL", values, num_verts, sizeof(long long));
+}
+
+/*
+	write the magic, the number of vertices and the
+	values of value_size bytes
+*/
+bool ResultWriter::write_binary_values(string outfile, const char* magic, const void* values,
+		int num_verts, size_t value_size) {
+
+	int fd = ::open( outfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 ) {
+		printf("error: cannot open %s: %s\n", outfile.c_str(), strerror(errno));
+		return false;
+	}
+
+	char header[12];
+	memcpy(header, magic, 8);
+	memcpy(header + 8, &num_verts, sizeof(int));
+	bool ok = pwrite_all(fd, header, sizeof(header), 0);
+	ok = ok && pwrite_all(fd, (const char*)values, (size_t)num_verts * value_size, sizeof(header));
+
+	if( ::close(fd) != 0 ) ok = false;
+	if( !ok )
+		printf("error: writing %s: %s\n", outfile.c_str(), strerror(errno));
+	return ok;
+}
+
+/*
+	the number of characters of the lines of vertices [begin,end)
+*/
+template<typename V>
+long long ResultWriter::text_length(int begin, int end, const V* values, const char* missing) {
+
+	long long len = 0;
+	int missing_len = ( missing != NULL ) ? strlen(missing) : 0;
+	for(int i=begin; i<end; i++) {
+		V v = values[i];
+		len += int_length(i) + 2;
+		len += ( missing != NULL && is_missing(v) ) ? missing_len : value_length(v);
+	}
+	return len;
+}
+
+/*
+	format the lines of a range of vertices into a buffer,
+	writing the buffer to the range's place in the file as it fills
+*/
+template<typename V>
+bool ResultWriter::format_range(int fd, const Range& range, const V* values, const char* missing) {
+
+	std::vector<char> buffer(FORMAT_BUFFER);
+	char* buf = &buffer[0];
+	size_t len = 0;
+	long long offset = range.offset;
+	int missing_len = ( missing != NULL ) ? strlen(missing) : 0;
+
+	for(int i=range.begin; i<range.end; i++) {
+
+		// room for the longest line, an integer, a value and separators
+		if( FORMAT_BUFFER - len < (size_t)(40 + missing_len) ) {
+			if( !pwrite_all(fd, buf, len, offset) ) return false;
+			offset += len;
+			len = 0;
+		}
+
+		V v = values[i];
+		len += BufferedWriter::format_int( buf + len, i );
+		buf[len++] = '\t';
+		if( missing != NULL && is_missing(v) ) {
+			memcpy( buf + len, missing, missing_len );
+			len += missing_len;
+		} else {
+			len += format_value( buf + len, v );
+		}
+		buf[len++] = '\n';
+	}
+
+	return pwrite_all(fd, buf, len, offset);
+}
+
+/*
+	write all of data at offset, retrying short writes
+*/
+bool ResultWriter::pwrite_all(int fd, const char* data, size_t len, long long offset) {
+
+	while( len > 0 ) {
+		size_t chunk = ( len > MAX_WRITE ) ? MAX_WRITE : len;
+		ssize_t n = pwrite(fd, data, chunk, offset);
+		if( n < 0 ) {
+			if( errno == EINTR ) continue;
+			return false;
+		}
+		data += n;
+		len -= n;
+		offset += n;
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+/*
+	Think-Like-A-Vertex Framework, ResultWriter.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Writes a program's final vertex values, one per vertex id.
+
+	Text output is one "id<tab>value" line per vertex, formatted
+	by several threads at once.  The length of every line is
+	known up front, so each thread formats its own range of
+	vertices into a private buffer and writes it straight to
+	its offset in the file with large positioned writes.
+
+	Binary output is the 8 bytes TLAVRES1, the int32 number
+	of vertices, then one raw int32 value per vertex.  Float
+	values are written the same way after the 8 bytes TLAVRESF,
+	and int64 values after TLAVRESL.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef RESULTWRITER_H
+#define RESULTWRITER_H
+
+#include <string>
+using std::string;
+
+class ResultWriter {
+
+	public:
+		ResultWriter(int num_threads=1);
+
+		bool write(string, string, string, const int*, int, const char*);
+		bool write(string, string, string, const float*, int, const char*);
+		bool write(string, string, string, const long long*, int, const char*);
+		bool write_text(string, string, const int*, int, const char*);
+		bool write_text(string, string, const float*, int, const char*);
+		bool write_text(string, string, const long long*, int, const char*);
+		bool write_binary(string, const int*, int);
+		bool write_binary(string, const float*, int);
+		bool write_binary(string, const long long*, int);
+
+	private:
+		struct Range {
+			int begin;
+			int end;
+			long long offset;
+		};
+
+		template<typename V>
+		bool write_text_values(string, string, const V*, int, const char*);
+		template<typename V>
+		long long text_length(int, int, const V*, const char*);
+		template<typename V>
+		bool format_range(int, const Range&, const V*, const char*);
+		bool write_binary_values(string, const char*, const void*, int, size_t);
+		static bool pwrite_all(int, const char*, size_t, long long);
+
+		int num_threads;
+
+};
+
+#endif
@@ -0,0 +1,239 @@
+/*
+	Think-Like-A-Vertex Framework, CorePeeler.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the k-core decomposition engine
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <limits.h>
+#include <algorithm>
+#include <thread>
+
+#include "CorePeeler.h"
+
+/* Constructor, running on num_threads threads */
+CorePeeler::CorePeeler(int _num_threads) {
+	num_threads = ( _num_threads < 1 ) ? 1 : _num_threads;
+	num_verts = 0;
+	degree = NULL;
+	frontier = next = NULL;
+	window_lo = 0;
+	level = 0;
+	num_peeled = 0;
+	num_rounds = 0;
+}
+
+/*
+	find the coreness of the n vertices of the CSR arrays,
+	which hold every edge in both directions
+*/
+void CorePeeler::peel(int n, const int* _csr1, const int* _csr2) {
+
+	num_verts = n;
+	csr1 = _csr1;
+	csr2 = _csr2;
+	window_lo = 0;
+	level = 0;
+	num_peeled = 0;
+	num_rounds = 0;
+	if( n == 0 ) return;
+
+	int threads = num_threads;
+	if( threads > n ) threads = n;
+
+	// shares of roughly equal vertices plus edges
+	part_bounds.assign(threads+1, 0);
+	long long cost = (long long)csr1[n] + n;
+	for(int t=1; t<threads; t++) {
+		long long target = cost * t / threads;
+		int lo = part_bounds[t-1], hi = n;
+		while( lo < hi ) {
+			int mid = lo + (hi-lo)/2;
+			if( (long long)csr1[mid] + mid < target ) lo = mid+1;
+			else hi = mid;
+		}
+		part_bounds[t] = lo;
+	}
+	part_bounds[threads] = n;
+
+	arena.release();
+	arena.reserve( 3 * sizeof(int) * (size_t)n + 3 * 64 );
+	degree = arena.alloc_array<int>(n);
+	frontier = arena.alloc_array<int>(n);
+	next = arena.alloc_array<int>(n);
+
+	left.assign( threads, vector<int>() );
+	buckets.assign( threads, vector< vector<int> >(KC_WINDOW) );
+	part_min.assign( threads, INT_MAX );
+	frontier_size = 0;
+	next_size = 0;
+	next_chunk = 0;
+	sync.init(threads);
+
+	if( threads == 1 ) {
+		peel_share(0);
+		return;
+	}
+	vector<std::thread> pool;
+	for(int t=0; t<threads; t++)
+		pool.push_back( std::thread( &CorePeeler::peel_share, this, t ) );
+	for(int t=0; t<threads; t++)
+		pool[t].join();
+}
+
+/*
+	the peeling run by each thread: a level at a time, take
+	the level's buckets, then peel rounds of the vertices the
+	level brings down to it until none are, moving the window
+	once the levels pass it
+*/
+void CorePeeler::peel_share(int t) {
+
+	left[t].clear();
+	for(int v=part_bounds[t]; v<part_bounds[t+1]; v++) {
+		degree[v] = csr1[v+1] - csr1[v];
+		left[t].push_back(v);
+	}
+	sync.wait();
+
+	refill(t, 0);
+	int k = level;
+	while( k >= 0 ) {
+
+		// each round's vertices are gathered in next, then swapped in
+		take_bucket(t, k);
+		for(;;) {
+			if( sync.wait() ) {
+				num_peeled += frontier_size.load();
+				std::swap( frontier, next );
+				frontier_size = next_size.load();
+				next_size = 0;
+				next_chunk = 0;
+				if( frontier_size.load() > 0 ) num_rounds++;
+			}
+			sync.wait();
+			if( frontier_size.load() == 0 ) break;
+			peel_round(t, k);
+		}
+
+		if( num_peeled == num_verts ) break;
+		k++;
+		if( k == window_lo + KC_WINDOW ) {
+			refill(t, k);
+			k = level;
+		}
+	}
+}
+
+/*
+	move the window of buckets to the least degree left once
+	the levels below k are peeled.  Each thread drops its
+	peeled vertices from its list, and buckets the rest inside
+	the window.  Sets the level to the least degree, or -1
+	once no vertices are left
+*/
+void CorePeeler::refill(int t, int k) {
+
+	vector<int>& mine = left[t];
+	size_t kept = 0;
+	int least = INT_MAX;
+	for(size_t i=0; i<mine.size(); i++) {
+		int v = mine[i];
+		if( degree[v] < k ) continue;
+		least = std::min( least, degree[v] );
+		mine[kept++] = v;
+	}
+	mine.resize(kept);
+	part_min[t] = least;
+
+	if( sync.wait() ) {
+		least = *std::min_element( part_min.begin(), part_min.end() );
+		window_lo = least;
+		level = ( least == INT_MAX ) ? -1 : least;
+	}
+	sync.wait();
+	if( level < 0 ) return;
+
+	for(int b=0; b<KC_WINDOW; b++)
+		buckets[t][b].clear();
+	for(size_t i=0; i<mine.size(); i++) {
+		int d = degree[ mine[i] ];
+		if( d - window_lo < KC_WINDOW )
+			buckets[t][ d - window_lo ].push_back( mine[i] );
+	}
+}
+
+/*
+	add the thread's bucket of level k to the first round,
+	skipping vertices a later decrement took below it
+*/
+void CorePeeler::take_bucket(int t, int k) {
+
+	vector<int>& bucket = buckets[t][ k - window_lo ];
+	size_t kept = 0;
+	for(size_t i=0; i<bucket.size(); i++)
+		if( degree[ bucket[i] ] == k ) bucket[kept++] = bucket[i];
+	bucket.resize(kept);
+	append( bucket, next, next_size );
+}
+
+/*
+	peel chunks of the frontier at level k until none are
+	left: every neighbor above the level loses one degree,
+	joining the next round once at the level, or its bucket
+	in the window
+*/
+void CorePeeler::peel_round(int t, int k) {
+
+	int size = frontier_size.load();
+	vector<int> found;
+
+	for(;;) {
+		int lo = next_chunk.fetch_add(KC_CHUNK_VERTS);
+		if( lo >= size ) break;
+		int hi = std::min( lo + KC_CHUNK_VERTS, size );
+
+		for(int i=lo; i<hi; i++) {
+			int v = frontier[i];
+			for(int j=csr1[v]; j<csr1[v+1]; j++) {
+				int u = csr2[j];
+				int d = __atomic_load_n( &degree[u], __ATOMIC_RELAXED );
+				while( d > k && !__atomic_compare_exchange_n( &degree[u], &d, d-1,
+					true, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) );
+				if( d <= k ) continue;
+
+				// d-1 is the degree u was left with, reached only by this thread
+				if( d-1 == k ) found.push_back(u);
+				else if( d-1 - window_lo < KC_WINDOW ) buckets[t][ d-1 - window_lo ].push_back(u);
+			}
+		}
+	}
+	append( found, next, next_size );
+}
+
+/* copy a thread's vertices to the end of a shared list, and clear them */
+void CorePeeler::append(vector<int>& verts, int* list, std::atomic<int>& size) {
+
+	if( verts.empty() ) return;
+	int at = size.fetch_add( (int)verts.size() );
+	std::copy( verts.begin(), verts.end(), list + at );
+	verts.clear();
+}
+
+/* the coreness of each vertex of the last peel */
+int* CorePeeler::get_coreness() {
+	return degree;
+}
+
+/* the largest coreness of the last peel */
+int CorePeeler::get_max_core() {
+	return ( num_verts > 0 ) ? *std::max_element( degree, degree + num_verts ) : 0;
+}
+
+/* the number of rounds of peeling, over all levels */
+long long CorePeeler::get_num_rounds() {
+	return num_rounds;
+}
@@ -0,0 +1,94 @@
+/*
+	Think-Like-A-Vertex Framework, CorePeeler.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	A k-core decomposition engine over the CSR arrays, outside
+	the superstep model: the vertex-centric h-index formulation
+	takes many supersteps, each a message per edge.
+
+	Vertices are peeled level by level.  At level k every vertex
+	left with degree k has coreness k and is removed, which
+	lowers the degree of its neighbors by atomic decrements that
+	never take one below k; a neighbor brought down to k joins
+	the level, and the level is done once none are.
+
+	Vertices wait for their level in a window of KC_WINDOW
+	buckets, one per degree, each a list per thread.  A vertex
+	is added to a bucket whenever a decrement brings it into
+	the window, and entries left behind by a later decrement are
+	skipped when their bucket is taken.  Once the levels pass the
+	window, it moves to the least degree left, refilled from a
+	list of the vertices left that shrinks as they are peeled.
+	Each edge is decremented at most once from each side.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef COREPEELER_H
+#define COREPEELER_H
+
+#include <atomic>
+#include <vector>
+using std::vector;
+
+#include "Arena.h"
+#include "Barrier.h"
+
+// degrees in the window of buckets
+#define KC_WINDOW 128
+
+// vertices of a level per chunk of peeling work
+#define KC_CHUNK_VERTS 256
+
+class CorePeeler {
+
+	public:
+		CorePeeler(int num_threads=1);
+
+		void peel(int, const int*, const int*);
+		int* get_coreness();
+		int get_max_core();
+		long long get_num_rounds();
+
+	private:
+		void peel_share(int);
+		void refill(int, int);
+		void take_bucket(int, int);
+		void peel_round(int, int);
+		void append(vector<int>&, int*, std::atomic<int>&);
+
+		int num_threads;
+
+		// the graph, and the first vertex of each thread's share
+		int num_verts;
+		const int* csr1;
+		const int* csr2;
+		vector<int> part_bounds;
+
+		// the degree of each vertex left, its coreness once peeled
+		Arena arena;
+		int* degree;
+
+		// each thread's vertices left, and its buckets of the window
+		vector< vector<int> > left;
+		vector< vector< vector<int> > > buckets;
+		vector<int> part_min;
+
+		// the vertices of the level, and those it brings down to it
+		int* frontier;
+		int* next;
+		std::atomic<int> frontier_size;
+		std::atomic<int> next_size;
+		std::atomic<int> next_chunk;
+
+		// shared between threads, set by the last at a barrier
+		Barrier sync;
+		int window_lo;
+		int level;
+		int num_peeled;
+		long long num_rounds;
+
+};
+
+#endif
@@ -0,0 +1,408 @@
+/*
+	Think-Like-A-Vertex Framework, LandmarkIndex.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the landmark distance oracle
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+#include "CsrImage.h"
+#include "LandmarkIndex.h"
+
+typedef std::pair<int,int> KeyVert;
+
+/* Constructor, an empty index */
+LandmarkIndex::LandmarkIndex() {
+	num_verts = 0;
+	num_landmarks = 0;
+	select = SELECT_FARTHEST;
+	width = 16;
+	num_active = 0;
+	epoch = 0;
+	src = dst = -1;
+	found = -1;
+	settled = 0;
+}
+
+/*
+	start an index over n vertices, whose landmarks are then
+	picked by next_landmark and their distances given to
+	add_distances one at a time, up to k, before finish
+*/
+void LandmarkIndex::init(int n, int k, LandmarkSelect _select) {
+	num_verts = n;
+	num_landmarks = 0;
+	select = _select;
+	landmarks.clear();
+	landmarks.reserve(k);
+	raw.clear();
+	raw.reserve( (size_t)k * n );
+	nearest.assign(n, INT_MAX);
+}
+
+/*
+	the next landmark, given the CSR offsets: the vertex of
+	highest degree not yet taken, or farthest first the vertex
+	the landmarks so far reach that is farthest from them, by
+	degree among ties.  -1 once there is no vertex left
+*/
+int LandmarkIndex::next_landmark(const int* csr1) {
+
+	int pick = -1;
+	long long pick_far = -1;
+	int pick_degree = -1;
+	for(int v=0; v<num_verts; v++) {
+		if( std::find( landmarks.begin(), landmarks.end(), v ) != landmarks.end() ) continue;
+		if( select == SELECT_FARTHEST && num_landmarks > 0 && nearest[v] == INT_MAX ) continue;
+		long long far = ( select == SELECT_FARTHEST ) ? nearest[v] : 0;
+		int degree = csr1[v+1] - csr1[v];
+		if( far > pick_far || ( far == pick_far && degree > pick_degree ) ) {
+			pick = v;
+			pick_far = far;
+			pick_degree = degree;
+		}
+	}
+	return pick;
+}
+
+/* add landmark l with its distance to every vertex, INT_MAX if unreached */
+void LandmarkIndex::add_distances(int l, const int* d) {
+
+	landmarks.push_back(l);
+	num_landmarks++;
+	raw.insert( raw.end(), d, d + num_verts );
+	for(int v=0; v<num_verts; v++)
+		nearest[v] = std::min( nearest[v], d[v] );
+}
+
+/*
+	pack the distances vertex by vertex, in 16 bits if
+	the farthest reached vertex of every landmark fits
+*/
+void LandmarkIndex::finish() {
+
+	int far = 0;
+	for(size_t i=0; i<raw.size(); i++)
+		if( raw[i] != INT_MAX ) far = std::max( far, raw[i] );
+	width = ( far < 0xFFFF ) ? 16 : 32;
+
+	size_t cells = (size_t)num_verts * num_landmarks;
+	dists16.clear();
+	dists32.clear();
+	if( width == 16 ) dists16.resize(cells);
+	else dists32.resize(cells);
+	for(int i=0; i<num_landmarks; i++) {
+		const int* d = &raw[ (size_t)i * num_verts ];
+		for(int v=0; v<num_verts; v++) {
+			size_t at = (size_t)v * num_landmarks + i;
+			if( width == 16 ) dists16[at] = ( d[v] == INT_MAX ) ? 0xFFFF : d[v];
+			else dists32[at] = ( d[v] == INT_MAX ) ? 0xFFFFFFFFu : d[v];
+		}
+	}
+	vector<int>().swap(raw);
+	vector<int>().swap(nearest);
+
+	stamp.assign(num_verts, 0);
+	dist.assign(num_verts, 0);
+	parent.assign(num_verts, -1);
+	hval.assign(num_verts, 0);
+	epoch = 0;
+}
+
+/* write all of len bytes, false on an error */
+static bool write_all(int fd, const void* data, size_t len) {
+
+	const char* p = (const char*)data;
+	while( len > 0 ) {
+		ssize_t n = write( fd, p, len );
+		if( n <= 0 ) return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/* read len bytes at offset, false if the file is cut short */
+static bool read_at(int fd, int64_t offset, void* data, size_t len) {
+
+	char* p = (char*)data;
+	while( len > 0 ) {
+		ssize_t n = pread( fd, p, len, offset );
+		if( n <= 0 ) return false;
+		p += n;
+		offset += n;
+		len -= n;
+	}
+	return true;
+}
+
+/*
+	write the index to file, recording the hash of the graph
+	it was built from.  It is written to a temporary file and
+	renamed into place, so no reader sees half of it
+*/
+bool LandmarkIndex::save(string file, uint64_t graph_hash) {
+
+	char suffix[32];
+	snprintf( suffix, sizeof(suffix), ".tmp%d", (int)getpid() );
+	string tmp = file + suffix;
+	int fd = open( tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 ) return false;
+
+	LandmarkHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, ALT_MAGIC, ALT_MAGIC_LEN );
+	header.num_verts = num_verts;
+	header.num_landmarks = num_landmarks;
+	header.select = select;
+	header.width = width;
+	header.graph_hash = graph_hash;
+	header.landmarks_at = csr_next_section( 0, sizeof(header) / 4 );
+	header.dists_at = csr_next_section( header.landmarks_at, num_landmarks );
+
+	const char zeros[8] = {0};
+	size_t cells = (size_t)num_verts * num_landmarks;
+	const void* dists = ( width == 16 ) ? (const void*)dists16.data() : (const void*)dists32.data();
+
+	bool ok = write_all( fd, &header, sizeof(header) )
+		&& write_all( fd, zeros, header.landmarks_at - sizeof(header) )
+		&& write_all( fd, landmarks.data(), num_landmarks * sizeof(int) )
+		&& write_all( fd, zeros, header.dists_at - header.landmarks_at - num_landmarks * sizeof(int) )
+		&& write_all( fd, dists, cells * ( width / 8 ) );
+	if( close(fd) != 0 ) ok = false;
+	if( ok ) ok = rename( tmp.c_str(), file.c_str() ) == 0;
+	if( !ok ) unlink( tmp.c_str() );
+	return ok;
+}
+
+/*
+	read an index from file, false if there is none
+	or it was built from a graph of another hash
+*/
+bool LandmarkIndex::load(string file, uint64_t graph_hash) {
+
+	int fd = open( file.c_str(), O_RDONLY );
+	if( fd < 0 ) return false;
+
+	LandmarkHeader header;
+	bool ok = read_at( fd, 0, &header, sizeof(header) )
+		&& memcmp( header.magic, ALT_MAGIC, ALT_MAGIC_LEN ) == 0
+		&& header.graph_hash == graph_hash
+		&& header.num_verts >= 0 && header.num_verts < INT_MAX
+		&& header.num_landmarks >= 0 && header.num_landmarks <= ALT_MAX_LANDMARKS
+		&& ( header.width == 16 || header.width == 32 );
+	if( ok ) {
+		num_verts = header.num_verts;
+		num_landmarks = header.num_landmarks;
+		select = ( header.select == SELECT_DEGREE ) ? SELECT_DEGREE : SELECT_FARTHEST;
+		width = header.width;
+		landmarks.resize(num_landmarks);
+		size_t cells = (size_t)num_verts * num_landmarks;
+		dists16.clear();
+		dists32.clear();
+		void* dists;
+		if( width == 16 ) {
+			dists16.resize(cells);
+			dists = dists16.data();
+		} else {
+			dists32.resize(cells);
+			dists = dists32.data();
+		}
+		ok = read_at( fd, header.landmarks_at, landmarks.data(), num_landmarks * sizeof(int) )
+			&& read_at( fd, header.dists_at, dists, cells * ( width / 8 ) );
+	}
+	close(fd);
+	if( ok ) {
+		stamp.assign(num_verts, 0);
+		dist.assign(num_verts, 0);
+		parent.assign(num_verts, -1);
+		hval.assign(num_verts, 0);
+		epoch = 0;
+	}
+	return ok;
+}
+
+/* the distance from landmark i to v, INT_MAX if unreached */
+int LandmarkIndex::get_dist(int v, int i) {
+	size_t at = (size_t)v * num_landmarks + i;
+	if( width == 16 ) return ( dists16[at] == 0xFFFF ) ? INT_MAX : dists16[at];
+	return ( dists32[at] == 0xFFFFFFFFu ) ? INT_MAX : (int)dists32[at];
+}
+
+/*
+	the greatest lower bound on d(s,t) the landmarks give,
+	INT_MAX if a landmark reaches only one of s and t
+*/
+int LandmarkIndex::lower_bound(int s, int t) {
+
+	int bound = 0;
+	for(int i=0; i<num_landmarks; i++) {
+		int a = get_dist(s, i), b = get_dist(t, i);
+		if( a == INT_MAX && b == INT_MAX ) continue;
+		if( a == INT_MAX || b == INT_MAX ) return INT_MAX;
+		bound = std::max( bound, std::abs( a - b ) );
+	}
+	return bound;
+}
+
+/*
+	the least upper bound on d(s,t) the landmarks give,
+	INT_MAX if no landmark reaches both
+*/
+int LandmarkIndex::upper_bound(int s, int t) {
+
+	if( s == t ) return 0;
+	long long bound = INT_MAX;
+	for(int i=0; i<num_landmarks; i++) {
+		int a = get_dist(s, i), b = get_dist(t, i);
+		if( a == INT_MAX || b == INT_MAX ) continue;
+		bound = std::min( bound, (long long)a + b );
+	}
+	return (int)bound;
+}
+
+/*
+	the ALT_ACTIVE landmarks reaching both s and t whose lower
+	bounds on d(s,t) are greatest, to guide the search
+*/
+void LandmarkIndex::pick_active(int s, int t) {
+
+	vector<KeyVert> scores;
+	for(int i=0; i<num_landmarks; i++) {
+		int a = get_dist(s, i), b = get_dist(t, i);
+		if( a == INT_MAX || b == INT_MAX ) continue;
+		scores.push_back( KeyVert( -std::abs( a - b ), i ) );
+	}
+	std::sort( scores.begin(), scores.end() );
+	num_active = std::min( (int)scores.size(), ALT_ACTIVE );
+	for(int i=0; i<num_active; i++) {
+		active[i] = scores[i].second;
+		active_to_t[i] = get_dist( t, active[i] );
+	}
+}
+
+/*
+	the lower bound on the distance from v to the target by the
+	active landmarks, all of which reach v since it shares the
+	component of the source
+*/
+inline int LandmarkIndex::heuristic(int v) {
+	int h = 0;
+	for(int i=0; i<num_active; i++)
+		h = std::max( h, std::abs( active_to_t[i] - get_dist( v, active[i] ) ) );
+	return h;
+}
+
+/*
+	the distance from s to t over the CSR arrays, or -1 if t
+	cannot be reached: A* search from s, each step settling the
+	least distance plus lower bound to t, until t is settled.
+	The bound is consistent, so no vertex is settled twice
+*/
+int LandmarkIndex::query(int s, int t, const int* csr1, const int* csr2, const int* weights) {
+
+	src = s;
+	dst = t;
+	found = -1;
+	settled = 0;
+	if( ++epoch == 0 ) {
+		std::fill( stamp.begin(), stamp.end(), 0u );
+		epoch = 1;
+	}
+	if( lower_bound(s, t) == INT_MAX ) return found;
+	pick_active(s, t);
+
+	std::greater<KeyVert> later;
+	heap.clear();
+	stamp[s] = epoch;
+	dist[s] = 0;
+	parent[s] = -1;
+	hval[s] = heuristic(s);
+	heap.push_back( KeyVert( hval[s], s ) );
+
+	while( !heap.empty() ) {
+		int key = heap.front().first, u = heap.front().second;
+		std::pop_heap( heap.begin(), heap.end(), later );
+		heap.pop_back();
+		if( key > dist[u] + hval[u] ) continue;
+		settled++;
+		if( u == t ) {
+			found = dist[u];
+			break;
+		}
+
+		for(int j=csr1[u]; j<csr1[u+1]; j++) {
+			int x = csr2[j], nd = dist[u] + weights[j];
+			if( stamp[x] != epoch ) {
+				stamp[x] = epoch;
+				hval[x] = heuristic(x);
+			} else if( nd >= dist[x] ) {
+				continue;
+			}
+			dist[x] = nd;
+			parent[x] = u;
+			heap.push_back( KeyVert( nd + hval[x], x ) );
+			std::push_heap( heap.begin(), heap.end(), later );
+		}
+	}
+	return found;
+}
+
+/*
+	the vertices of a shortest path of the last query in order,
+	with the distance of each from the source.  Empty if the
+	target was not reached
+*/
+void LandmarkIndex::get_path(vector<int>& path, vector<int>& dists) {
+
+	path.clear();
+	dists.clear();
+	if( found < 0 ) return;
+	for(int v=dst; v!=-1; v=parent[v]) {
+		path.push_back(v);
+		dists.push_back( dist[v] );
+	}
+	std::reverse( path.begin(), path.end() );
+	std::reverse( dists.begin(), dists.end() );
+}
+
+/* the number of vertices of the index */
+int LandmarkIndex::get_num_verts() {
+	return num_verts;
+}
+
+/* the number of landmarks of the index */
+int LandmarkIndex::get_num_landmarks() {
+	return num_landmarks;
+}
+
+/* the vertex of landmark i */
+int LandmarkIndex::get_landmark(int i) {
+	return landmarks[i];
+}
+
+/* how the landmarks were chosen */
+LandmarkSelect LandmarkIndex::get_select() {
+	return select;
+}
+
+/* the bits of each stored distance */
+int LandmarkIndex::get_width() {
+	return width;
+}
+
+/* the vertices the last query settled */
+int LandmarkIndex::get_settled() {
+	return settled;
+}
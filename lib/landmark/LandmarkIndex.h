@@ -0,0 +1,137 @@
+/*
+	Think-Like-A-Vertex Framework, LandmarkIndex.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	A landmark distance oracle over an undirected graph with
+	non-negative weights: the distance from each of k landmarks
+	to every vertex, found by the caller with a Worker run from
+	each landmark in turn.
+
+	By the triangle inequality, for every landmark l
+
+		|d(l,s) - d(l,t)|  <=  d(s,t)  <=  d(l,s) + d(l,t)
+
+	so the index alone estimates a distance between bounds.
+	An exact query is an A* search from s whose heuristic is
+	the lower bound to t over the ALT_ACTIVE landmarks that
+	bound d(s,t) best, which is consistent, so the search
+	settles only vertices that lead toward t (ALT).
+
+	Landmarks are the highest degree vertices, or chosen
+	farthest first: the highest degree vertex, then each next
+	the vertex farthest from those already chosen among the
+	vertices they reach, so the landmarks spread around the
+	component of the first.  The distances are kept vertex by
+	vertex, the k of a vertex together, in 16 bits when they
+	all fit and 32 otherwise, the largest value of the width
+	marking a vertex the landmark cannot reach.  The index is
+	stored next to the graph file as
+
+		landmarks	int32[num_landmarks]
+		dists		uint16 or uint32[num_verts * num_landmarks]
+
+	along with the content hash of the CSR arrays it was built
+	from (ResultCache::hash_csr), since bounds from another graph
+	would make the A* heuristic inadmissible.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef LANDMARKINDEX_H
+#define LANDMARKINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#define ALT_MAGIC "TLAVLM02"
+#define ALT_MAGIC_LEN 8
+
+// the most landmarks an index holds
+#define ALT_MAX_LANDMARKS 64
+
+// landmarks whose bounds guide an exact query
+#define ALT_ACTIVE 4
+
+enum LandmarkSelect { SELECT_DEGREE, SELECT_FARTHEST };
+
+struct LandmarkHeader {
+	char magic[ALT_MAGIC_LEN];
+	int64_t num_verts;
+	int64_t num_landmarks;
+	int64_t select;
+	int64_t width;
+	uint64_t graph_hash;
+
+	// byte offsets of each section
+	int64_t landmarks_at;
+	int64_t dists_at;
+};
+
+class LandmarkIndex {
+
+	public:
+		LandmarkIndex();
+
+		void init(int, int, LandmarkSelect);
+		int next_landmark(const int*);
+		void add_distances(int, const int*);
+		void finish();
+		bool save(string, uint64_t);
+		bool load(string, uint64_t);
+
+		int get_dist(int, int);
+		int lower_bound(int, int);
+		int upper_bound(int, int);
+
+		int query(int, int, const int*, const int*, const int*);
+		void get_path(vector<int>&, vector<int>&);
+
+		int get_num_verts();
+		int get_num_landmarks();
+		int get_landmark(int);
+		LandmarkSelect get_select();
+		int get_width();
+		int get_settled();
+
+	private:
+		void pick_active(int, int);
+		int heuristic(int);
+
+		int num_verts;
+		int num_landmarks;
+		LandmarkSelect select;
+		vector<int> landmarks;
+
+		// the distances, vertex major, in one of the two widths
+		int width;
+		vector<uint16_t> dists16;
+		vector<uint32_t> dists32;
+
+		// while building: the distances so far, landmark major,
+		// and the least distance of each vertex to any landmark
+		vector<int> raw;
+		vector<int> nearest;
+
+		// the last query: the active landmarks and their
+		// distances to the target, and the search marks
+		int active[ALT_ACTIVE];
+		int active_to_t[ALT_ACTIVE];
+		int num_active;
+		vector<unsigned> stamp;
+		vector<int> dist;
+		vector<int> parent;
+		vector<int> hval;
+		vector< std::pair<int,int> > heap;
+		unsigned epoch;
+		int src;
+		int dst;
+		int found;
+		int settled;
+
+};
+
+#endif
@@ -0,0 +1,230 @@
+/*
+	Think-Like-A-Vertex Framework, Metrics.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the run metrics and their export
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <stdio.h>
+#include <time.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "Arena.h"
+#include "Metrics.h"
+
+/* Constructor, nothing measured yet */
+Metrics::Metrics() {
+	program = "";
+	num_verts = 0;
+	num_edges = 0;
+	num_threads = 1;
+	load_time = 0;
+	init_time = 0;
+	run_time = 0;
+	peak_heap = 0;
+}
+
+/* monotonic time in seconds */
+double Metrics::now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+	bytes currently allocated on the heap, including large
+	mmap'd blocks and the blocks mapped by arenas, or -1 if unknown
+*/
+long long Metrics::heap_bytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 mi = mallinfo2();
+	return (long long)mi.uordblks + (long long)mi.hblkhd + (long long)Arena::get_mapped_total();
+#else
+	return -1;
+#endif
+}
+
+void Metrics::set_program(string p) { program = p; }
+void Metrics::set_graph(int v, long long e) { num_verts = v; num_edges = e; }
+void Metrics::set_threads(int t) { num_threads = t; }
+void Metrics::set_load_time(double t) { load_time = t; }
+void Metrics::set_init_time(double t) { init_time = t; }
+void Metrics::set_run_time(double t) { run_time = t; }
+
+/* record a superstep */
+void Metrics::add_superstep(SuperstepStats& stats) {
+	supersteps.push_back(stats);
+	if( stats.heap_bytes > peak_heap )
+		peak_heap = stats.heap_bytes;
+}
+
+/* forget the supersteps of a previous run */
+void Metrics::clear_supersteps() {
+	supersteps.clear();
+	peak_heap = 0;
+}
+
+/*
+	name the hardware counters recorded in each superstep,
+	no names means none are recorded
+*/
+void Metrics::set_counter_names(vector<string>& names) {
+	counter_names = names;
+	if( counter_names.size() > METRICS_MAX_COUNTERS )
+		counter_names.resize(METRICS_MAX_COUNTERS);
+}
+
+int Metrics::get_num_counters() { return counter_names.size(); }
+
+/*
+	a counter of a phase summed over the run,
+	-1 if it was unavailable in any superstep
+*/
+long long Metrics::total_counter(int phase, int c) {
+	long long total=0;
+	for(size_t i=0; i<supersteps.size(); i++) {
+		if( supersteps[i].counters[phase][c] < 0 ) return -1;
+		total += supersteps[i].counters[phase][c];
+	}
+	return total;
+}
+
+/* add a named value to the run summary */
+void Metrics::add_field(string name, double value) {
+	field_names.push_back(name);
+	field_values.push_back(value);
+}
+
+int Metrics::get_num_supersteps() { return supersteps.size(); }
+SuperstepStats& Metrics::get_superstep(int i) { return supersteps[i]; }
+double Metrics::get_load_time() { return load_time; }
+double Metrics::get_run_time() { return run_time; }
+
+/* messages sent over the whole run */
+long long Metrics::get_total_messages() {
+	long long total=0;
+	for(size_t i=0; i<supersteps.size(); i++)
+		total += supersteps[i].messages;
+	return total;
+}
+
+/* edges traversed over the whole run */
+long long Metrics::get_total_edges() {
+	long long total=0;
+	for(size_t i=0; i<supersteps.size(); i++)
+		total += supersteps[i].edges;
+	return total;
+}
+
+/* traversed edges per second of run time */
+double Metrics::get_teps() {
+	if( run_time <= 0 ) return 0;
+	return get_total_edges() / run_time;
+}
+
+/*
+	write the metrics to a file, as "jsonl" (one object per
+	superstep, then a summary object) or "csv" (a table of
+	supersteps, a blank line, then a table of the summary)
+*/
+bool Metrics::write(string filename, string format) {
+
+	FILE* out = fopen( filename.c_str(), "w" );
+	if( out == NULL ) {
+		printf("error: cannot open metrics file %s\n", filename.c_str() );
+		return false;
+	}
+
+	if( format == "csv" )
+		write_csv(out);
+	else
+		write_jsonl(out);
+
+	fclose(out);
+	return true;
+}
+
+static const char* phase_names[METRICS_NUM_PHASES] = { "write", "deliver", "process" };
+
+/*
+	print a one line summary of the run,
+	and a line of counters per phase if recorded
+*/
+void Metrics::print_summary() {
+	printf("load %.3f s, run %.3f s, %d supersteps, %lld messages, %.3e TEPS\n",
+		load_time, run_time, (int)supersteps.size(), get_total_messages(), get_teps() );
+
+	for(int ph=0; ph<METRICS_NUM_PHASES && counter_names.size() > 0; ph++) {
+		printf("  %-8s", phase_names[ph]);
+		for(size_t c=0; c<counter_names.size(); c++) {
+			long long total = total_counter(ph, c);
+			if( total < 0 ) printf(" %s n/a", counter_names[c].c_str() );
+			else printf(" %s %lld", counter_names[c].c_str(), total );
+		}
+		// instructions per cycle when both are the first two counters
+		if( counter_names.size() > 1 && total_counter(ph, 0) > 0 && total_counter(ph, 1) >= 0 )
+			printf(" ipc %.2f", (double)total_counter(ph, 1) / total_counter(ph, 0) );
+		printf("\n");
+	}
+}
+
+/* supersteps and summary as JSON lines */
+void Metrics::write_jsonl(FILE* out) {
+
+	for(size_t i=0; i<supersteps.size(); i++) {
+		SuperstepStats& s = supersteps[i];
+		fprintf(out, "{\"type\":\"superstep\",\"superstep\":%d,\"write_s\":%.9f,\"deliver_s\":%.9f,"
+			"\"process_s\":%.9f,\"log_s\":%.9f,\"total_s\":%.9f,\"messages\":%lld,"
+			"\"active_verts\":%lld,\"edges\":%lld,\"heap_bytes\":%lld,\"pull\":%d,\"aggregate\":%.9g",
+			s.superstep, s.write_s, s.deliver_s, s.process_s, s.log_s, s.total_s,
+			s.messages, s.active_verts, s.edges, s.heap_bytes, s.pull, s.aggregate );
+		for(int ph=0; ph<METRICS_NUM_PHASES; ph++)
+			for(size_t c=0; c<counter_names.size(); c++)
+				fprintf(out, ",\"%s_%s\":%lld", phase_names[ph], counter_names[c].c_str(), s.counters[ph][c] );
+		fprintf(out, "}\n");
+	}
+
+	fprintf(out, "{\"type\":\"summary\",\"program\":\"%s\",\"num_verts\":%d,\"num_edges\":%lld,"
+		"\"threads\":%d,\"load_s\":%.9f,\"init_s\":%.9f,\"run_s\":%.9f,\"supersteps\":%d,"
+		"\"messages\":%lld,\"edges_traversed\":%lld,\"teps\":%.6e,\"peak_heap_bytes\":%lld",
+		program.c_str(), num_verts, num_edges, num_threads, load_time, init_time, run_time,
+		(int)supersteps.size(), get_total_messages(), get_total_edges(), get_teps(), peak_heap );
+	for(size_t i=0; i<field_names.size(); i++)
+		fprintf(out, ",\"%s\":%.9g", field_names[i].c_str(), field_values[i] );
+	fprintf(out, "}\n");
+}
+
+/* supersteps and summary as two CSV tables */
+void Metrics::write_csv(FILE* out) {
+
+	fprintf(out, "superstep,write_s,deliver_s,process_s,log_s,total_s,messages,active_verts,edges,heap_bytes,pull,aggregate");
+	for(int ph=0; ph<METRICS_NUM_PHASES; ph++)
+		for(size_t c=0; c<counter_names.size(); c++)
+			fprintf(out, ",%s_%s", phase_names[ph], counter_names[c].c_str() );
+	fprintf(out, "\n");
+	for(size_t i=0; i<supersteps.size(); i++) {
+		SuperstepStats& s = supersteps[i];
+		fprintf(out, "%d,%.9f,%.9f,%.9f,%.9f,%.9f,%lld,%lld,%lld,%lld,%d,%.9g",
+			s.superstep, s.write_s, s.deliver_s, s.process_s, s.log_s, s.total_s,
+			s.messages, s.active_verts, s.edges, s.heap_bytes, s.pull, s.aggregate );
+		for(int ph=0; ph<METRICS_NUM_PHASES; ph++)
+			for(size_t c=0; c<counter_names.size(); c++)
+				fprintf(out, ",%lld", s.counters[ph][c] );
+		fprintf(out, "\n");
+	}
+
+	fprintf(out, "\nprogram,num_verts,num_edges,threads,load_s,init_s,run_s,supersteps,messages,edges_traversed,teps,peak_heap_bytes");
+	for(size_t i=0; i<field_names.size(); i++)
+		fprintf(out, ",%s", field_names[i].c_str() );
+	fprintf(out, "\n%s,%d,%lld,%d,%.9f,%.9f,%.9f,%d,%lld,%lld,%.6e,%lld",
+		program.c_str(), num_verts, num_edges, num_threads, load_time, init_time, run_time,
+		(int)supersteps.size(), get_total_messages(), get_total_edges(), get_teps(), peak_heap );
+	for(size_t i=0; i<field_values.size(); i++)
+		fprintf(out, ",%.9g", field_values[i] );
+	fprintf(out, "\n");
+}
@@ -0,0 +1,106 @@
+/*
+	Think-Like-A-Vertex Framework, Metrics.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Performance metrics of a run: the time of each phase
+	of every superstep, the work it did, and a summary of
+	the whole run, exported as JSON lines or CSV
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// hardware counters recorded per phase
+#define METRICS_MAX_COUNTERS 8
+#define METRICS_NUM_PHASES 3
+
+/*
+	statistics of one superstep.  Phase times are those
+	of the slowest partition, total is the wall time
+	of the whole superstep including synchronization
+*/
+struct SuperstepStats {
+	int superstep;
+	double write_s;
+	double deliver_s;
+	double process_s;
+	double log_s;
+	double total_s;
+	long long messages;
+	long long active_verts;
+	long long edges;
+	long long heap_bytes;
+
+	// whether the values were pulled rather than sent
+	int pull;
+
+	// the program's aggregate over the vertices that sent
+	double aggregate;
+
+	// counters of the write, deliver and process phases,
+	// summed over partitions, -1 if unavailable
+	long long counters[METRICS_NUM_PHASES][METRICS_MAX_COUNTERS];
+};
+
+class Metrics {
+
+	public:
+		Metrics();
+		static double now();
+		static long long heap_bytes();
+
+		void set_program(string);
+		void set_graph(int, long long);
+		void set_threads(int);
+		void set_load_time(double);
+		void set_init_time(double);
+		void set_run_time(double);
+		void add_superstep(SuperstepStats&);
+		void clear_supersteps();
+		void add_field(string, double);
+		void set_counter_names(vector<string>&);
+		int get_num_counters();
+
+		int get_num_supersteps();
+		SuperstepStats& get_superstep(int);
+		long long get_total_messages();
+		long long get_total_edges();
+		double get_load_time();
+		double get_run_time();
+		double get_teps();
+
+		bool write(string, string);
+		void print_summary();
+
+	private:
+		void write_jsonl(FILE*);
+		void write_csv(FILE*);
+		long long total_counter(int, int);
+
+		string program;
+		int num_verts;
+		long long num_edges;
+		int num_threads;
+		double load_time;
+		double init_time;
+		double run_time;
+		long long peak_heap;
+		vector<SuperstepStats> supersteps;
+		vector<string> counter_names;
+
+		// extra summary fields added by other components
+		vector<string> field_names;
+		vector<double> field_values;
+
+};
+
+#endif
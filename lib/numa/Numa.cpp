@@ -0,0 +1,141 @@
+/*
+	Think-Like-A-Vertex Framework, Numa.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the NUMA topology and thread pinning
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sched.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+
+#include "Numa.h"
+
+/* Constructor, discover the topology */
+NumaTopology::NumaTopology() {
+	discover();
+}
+
+/* number of nodes with usable cpus */
+int NumaTopology::get_num_nodes() {
+	return node_cpus.size();
+}
+
+/* total number of usable cpus */
+int NumaTopology::get_num_cpus() {
+	int n=0;
+	for(size_t i=0; i<node_cpus.size(); i++)
+		n += node_cpus[i].size();
+	return n;
+}
+
+/* number of usable cpus on a node */
+int NumaTopology::get_num_cpus(int node) {
+	return node_cpus[node].size();
+}
+
+/* the i-th usable cpu of a node */
+int NumaTopology::get_cpu(int node, int i) {
+	return node_cpus[node][i];
+}
+
+/*
+	pin the calling thread to a single cpu,
+	returns false if the kernel refuses
+*/
+bool NumaTopology::pin_to_cpu(int cpu) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+/*
+	Read the cpus of every node from sysfs,
+	keeping only cpus in this process's affinity mask.
+	Without sysfs, treat the machine as a single node
+*/
+void NumaTopology::discover() {
+
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+
+	vector<int> node_ids;
+	DIR* dir = opendir("/sys/devices/system/node");
+	if( dir != NULL ) {
+		struct dirent* entry;
+		while( (entry = readdir(dir)) != NULL ) {
+			string name = entry->d_name;
+			if( name.compare(0, 4, "node") == 0 && name.size() > 4 && isdigit(name[4]) )
+				node_ids.push_back( atoi(name.c_str() + 4) );
+		}
+		closedir(dir);
+	}
+	sort( node_ids.begin(), node_ids.end() );
+
+	for(size_t i=0; i<node_ids.size(); i++) {
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node_ids[i]);
+		std::ifstream instream(path);
+		string line;
+		getline(instream, line);
+
+		vector<int> cpus, usable;
+		parse_cpulist(line, cpus);
+		for(size_t j=0; j<cpus.size(); j++) {
+			if( CPU_ISSET(cpus[j], &allowed) )
+				usable.push_back(cpus[j]);
+		}
+		if( usable.size() > 0 )
+			node_cpus.push_back(usable);
+	}
+
+	// no sysfs topology, one node with every allowed cpu
+	if( node_cpus.size() == 0 ) {
+		vector<int> cpus;
+		for(int c=0; c<CPU_SETSIZE; c++) {
+			if( CPU_ISSET(c, &allowed) )
+				cpus.push_back(c);
+		}
+		if( cpus.size() == 0 )
+			cpus.push_back(0);
+		node_cpus.push_back(cpus);
+	}
+
+	return;
+}
+
+/*
+	parse a sysfs cpulist, e.g. "0-3,8-11,16"
+*/
+void NumaTopology::parse_cpulist(string list, vector<int>& cpus) {
+
+	size_t pos=0;
+	while( pos < list.size() ) {
+		size_t end = list.find(',', pos);
+		if( end == string::npos ) end = list.size();
+		string range = list.substr(pos, end-pos);
+		size_t dash = range.find('-');
+		if( range.size() > 0 ) {
+			int lo = atoi( range.c_str() );
+			int hi = ( dash == string::npos ) ? lo : atoi( range.c_str() + dash + 1 );
+			for(int c=lo; c<=hi; c++)
+				cpus.push_back(c);
+		}
+		pos = end+1;
+	}
+
+	return;
+}
@@ -0,0 +1,45 @@
+/*
+	Think-Like-A-Vertex Framework, Numa.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	NUMA topology of the machine, read from
+	/sys/devices/system/node, and thread pinning.
+
+	Memory placement relies on the kernel's default
+	first-touch policy: a page lands on the node of the
+	thread that first writes it, so pinned threads that
+	initialize their own data get node-local memory
+	without depending on libnuma.
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+class NumaTopology {
+
+	public:
+		NumaTopology();
+		int get_num_nodes();
+		int get_num_cpus();
+		int get_num_cpus(int);
+		int get_cpu(int, int);
+		static bool pin_to_cpu(int);
+
+	private:
+		void discover();
+		void parse_cpulist(string, vector<int>&);
+
+		// usable cpus of each node, indexed by node
+		vector< vector<int> > node_cpus;
+
+};
+
+#endif
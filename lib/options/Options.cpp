@@ -0,0 +1,90 @@
+/*
+	Think-Like-A-Vertex Framework, Options.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the optional command line arguments
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <cstdlib>
+#include <ctype.h>
+#include <stdio.h>
+
+#include "Options.h"
+
+/* Constructor, no options set */
+Options::Options() { }
+
+/*
+	Construct from the command line,
+	where options begin at argv[first]
+*/
+Options::Options(int argc, char** argv, int first) {
+	parse(argc, argv, first);
+}
+
+/*
+	Parse "-name value" pairs and "-name" flags.
+	A flag followed by another option name, or by nothing,
+	is stored with the value "1"
+*/
+void Options::parse(int argc, char** argv, int first) {
+
+	string name;
+	for(int i=first; i<argc; i++) {
+		if( !is_option_name(argv[i]) ) {
+			printf("warning: ignoring unexpected argument %s\n", argv[i]);
+			continue;
+		}
+		name = argv[i] + 1;
+		if( i+1 < argc && !is_option_name(argv[i+1]) ) {
+			opts[name] = argv[i+1];
+			i++;
+		} else {
+			opts[name] = "1";
+		}
+	}
+
+	return;
+}
+
+/* was the option given */
+bool Options::has(string name) {
+	return opts.find(name) != opts.end();
+}
+
+/* the value of an option as a string, or the default if not given */
+string Options::get_string(string name, string def) {
+	map<string, string>::iterator itr = opts.find(name);
+	if( itr == opts.end() ) return def;
+	return itr->second;
+}
+
+/* the value of an option as an integer, or the default if not given */
+int Options::get_int(string name, int def) {
+	map<string, string>::iterator itr = opts.find(name);
+	if( itr == opts.end() ) return def;
+	return atoi( itr->second.c_str() );
+}
+
+/* the value of an option as a double, or the default if not given */
+double Options::get_double(string name, double def) {
+	map<string, string>::iterator itr = opts.find(name);
+	if( itr == opts.end() ) return def;
+	return atof( itr->second.c_str() );
+}
+
+/* set an option from within a program */
+void Options::set(string name, string value) {
+	opts[name] = value;
+}
+
+/*
+	an option name starts with a '-' followed by a letter,
+	so negative numbers are still read as values
+*/
+bool Options::is_option_name(const char* arg) {
+	return arg[0] == '-' && isalpha( (unsigned char)arg[1] );
+}
@@ -0,0 +1,45 @@
+/*
+	Think-Like-A-Vertex Framework, Options.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Optional command line arguments for the TLAV programs.
+
+	Programs take their required arguments positionally,
+	followed by any number of optional "-name value" pairs,
+	or "-name" flags, e.g.
+
+		./tlav_bfs graph.txt 0 out.txt -threads 8 -numa
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <map>
+#include <string>
+using std::map;
+using std::string;
+
+class Options {
+
+	public:
+		Options();
+		Options(int, char**, int);
+		void parse(int, char**, int);
+
+		bool has(string);
+		string get_string(string, string);
+		int get_int(string, int);
+		double get_double(string, double);
+		void set(string, string);
+
+	private:
+		bool is_option_name(const char*);
+
+		map<string, string> opts;
+
+};
+
+#endif
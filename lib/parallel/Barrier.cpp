@@ -0,0 +1,55 @@
+/*
+	Think-Like-A-Vertex Framework, Barrier.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of a reusable thread barrier
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "Barrier.h"
+
+/* Constructor, a barrier for a single thread */
+Barrier::Barrier() {
+	init(1);
+}
+
+/* Constructor, a barrier for n threads */
+Barrier::Barrier(int n) {
+	init(n);
+}
+
+/*
+	set the number of threads that must
+	arrive before the barrier is released
+*/
+void Barrier::init(int n) {
+	num_threads = n;
+	num_waiting = 0;
+	generation = 0;
+}
+
+/*
+	block until all threads arrive.
+	returns true for exactly one thread, the last to arrive
+*/
+bool Barrier::wait() {
+
+	if( num_threads == 1 ) return true;
+
+	std::unique_lock<std::mutex> lock(mtx);
+	unsigned long gen = generation;
+	num_waiting++;
+	if( num_waiting == num_threads ) {
+		num_waiting = 0;
+		generation++;
+		cond.notify_all();
+		return true;
+	}
+	while( gen == generation ) {
+		cond.wait(lock);
+	}
+
+	return false;
+}
@@ -0,0 +1,35 @@
+/*
+	Think-Like-A-Vertex Framework, Barrier.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	A reusable thread barrier, used by the Worker to
+	separate the phases of a superstep across partitions
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <mutex>
+#include <condition_variable>
+
+class Barrier {
+
+	public:
+		Barrier();
+		Barrier(int);
+		void init(int);
+		bool wait();
+
+	private:
+		std::mutex mtx;
+		std::condition_variable cond;
+		int num_threads;
+		int num_waiting;
+		unsigned long generation;
+
+};
+
+#endif
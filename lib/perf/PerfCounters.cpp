@@ -0,0 +1,177 @@
+/*
+	Think-Like-A-Vertex Framework, PerfCounters.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the hardware performance counters
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "PerfCounters.h"
+
+/* Constructor, nothing open */
+PerfCounters::PerfCounters() {
+	leader = -1;
+	for(int e=0; e<NUM_PERF_EVENTS; e++) {
+		fds[e] = -1;
+		ids[e] = 0;
+	}
+}
+
+/* Destructor, close the counters */
+PerfCounters::~PerfCounters() {
+	close();
+}
+
+/* short name of an event, used in the metrics output */
+const char* PerfCounters::event_name(int e) {
+	static const char* names[NUM_PERF_EVENTS] = {
+		"cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"
+	};
+	return names[e];
+}
+
+#ifdef __linux__
+
+/*
+	open one event of the calling thread, counting user space only,
+	as a member of the group led by group_fd (-1 to lead)
+*/
+int PerfCounters::open_event(int e, int group_fd) {
+
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.disabled = ( group_fd == -1 );
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+		PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	switch(e) {
+		case PERF_CYCLES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case PERF_INSTRUCTIONS:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case PERF_LLC_MISSES:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+				(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case PERF_DTLB_MISSES:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+				(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case PERF_BRANCH_MISSES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+	}
+
+	int fd = syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+
+	// not every cpu has an LLC read event, fall back to the generic cache misses
+	if( fd < 0 && e == PERF_LLC_MISSES ) {
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		fd = syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+	}
+
+	return fd;
+}
+
+/*
+	open the counters for the calling thread, led by cycles,
+	and start counting.  returns false if nothing can be counted
+*/
+bool PerfCounters::open() {
+
+	close();
+
+	leader = open_event(PERF_CYCLES, -1);
+	if( leader < 0 ) return false;
+	fds[PERF_CYCLES] = leader;
+
+	for(int e=0; e<NUM_PERF_EVENTS; e++) {
+		if( e != PERF_CYCLES )
+			fds[e] = open_event(e, leader);
+		if( fds[e] >= 0 )
+			ioctl(fds[e], PERF_EVENT_IOC_ID, &ids[e]);
+	}
+
+	ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+	return true;
+}
+
+/*
+	read the current count of every event, scaled for any
+	time the group was multiplexed off the counters.
+	unavailable events read as -1
+*/
+void PerfCounters::read(long long* values) {
+
+	for(int e=0; e<NUM_PERF_EVENTS; e++)
+		values[e] = -1;
+	if( leader < 0 ) return;
+
+	// nr, time_enabled, time_running, then (value, id) per event
+	unsigned long long buf[3 + 2*NUM_PERF_EVENTS];
+	if( ::read(leader, buf, sizeof(buf)) <= 0 ) return;
+
+	unsigned long long nr = buf[0], enabled = buf[1], running = buf[2];
+	double scale = ( running > 0 && running < enabled ) ? (double)enabled / running : 1.0;
+	for(unsigned long long i=0; i<nr && i<NUM_PERF_EVENTS; i++) {
+		unsigned long long value = buf[3+2*i], id = buf[4+2*i];
+		for(int e=0; e<NUM_PERF_EVENTS; e++) {
+			if( fds[e] >= 0 && ids[e] == id )
+				values[e] = (long long)(value * scale);
+		}
+	}
+}
+
+#else
+
+int PerfCounters::open_event(int e, int group_fd) { return -1; }
+bool PerfCounters::open() { return false; }
+void PerfCounters::read(long long* values) {
+	for(int e=0; e<NUM_PERF_EVENTS; e++)
+		values[e] = -1;
+}
+
+#endif
+
+/* close every counter */
+void PerfCounters::close() {
+	for(int e=0; e<NUM_PERF_EVENTS; e++) {
+		if( fds[e] >= 0 ) ::close(fds[e]);
+		fds[e] = -1;
+	}
+	leader = -1;
+}
+
+/* are any counters open */
+bool PerfCounters::is_available() {
+	return leader >= 0;
+}
+
+/* is one event being counted */
+bool PerfCounters::is_event_available(int e) {
+	return fds[e] >= 0;
+}
@@ -0,0 +1,51 @@
+/*
+	Think-Like-A-Vertex Framework, PerfCounters.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Hardware performance counters of the calling thread,
+	through Linux perf_event_open: cycles, instructions,
+	last-level cache misses, dTLB misses and branch misses.
+
+	The counters are opened as one group so they are read
+	together with a single system call.  Counters the machine
+	or kernel does not allow are reported as unavailable (-1),
+	and if none can be opened, nothing is counted
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+enum PerfEvent {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_LLC_MISSES,
+	PERF_DTLB_MISSES,
+	PERF_BRANCH_MISSES,
+	NUM_PERF_EVENTS
+};
+
+class PerfCounters {
+
+	public:
+		PerfCounters();
+		~PerfCounters();
+		bool open();
+		void close();
+		bool is_available();
+		bool is_event_available(int);
+		void read(long long*);
+		static const char* event_name(int);
+
+	private:
+		int open_event(int, int);
+
+		int fds[NUM_PERF_EVENTS];
+		unsigned long long ids[NUM_PERF_EVENTS];
+		int leader;
+
+};
+
+#endif
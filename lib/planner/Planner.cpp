@@ -0,0 +1,210 @@
+/*
+	Think-Like-A-Vertex Framework, Planner.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the execution planner
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "Metrics.h"
+#include "Planner.h"
+
+/* Constructor, with no graph surveyed */
+Planner::Planner() {
+	num_verts = 0;
+	num_edges = 0;
+	csr1 = csr2 = NULL;
+	avg_degree = 0;
+	max_degree = 0;
+	hub_share = 0;
+	diameter = 0;
+	survey_time = 0;
+	pull_above = PLAN_PULL_ABOVE;
+	push_below = PLAN_PUSH_BELOW;
+	last_share = 0;
+	last_pull = false;
+}
+
+/* take the statistics of the n vertices of the CSR arrays */
+void Planner::survey(int n, const int* _csr1, const int* _csr2) {
+
+	double start = Metrics::now();
+	num_verts = n;
+	csr1 = _csr1;
+	csr2 = _csr2;
+	num_edges = ( n > 0 ) ? csr1[n] : 0;
+	avg_degree = ( n > 0 ) ? (double)num_edges / n : 0;
+
+	int hub = -1;
+	max_degree = 0;
+	long long hub_edges = 0;
+	for(int v=0; v<n; v++) {
+		int degree = csr1[v+1] - csr1[v];
+		if( degree > max_degree ) {
+			max_degree = degree;
+			hub = v;
+		}
+		if( degree > PLAN_HUB_DEGREE * avg_degree ) hub_edges += degree;
+	}
+	hub_share = ( num_edges > 0 ) ? (double)hub_edges / num_edges : 0;
+
+	// each sweep from the farthest vertex of the last
+	diameter = 0;
+	if( hub >= 0 ) {
+		vector<int> level(n), queue;
+		queue.reserve(n);
+		int from = hub;
+		for(int i=0; i<PLAN_PROBES; i++) {
+			int depth = probe(from, level, queue);
+			diameter = std::max( diameter, depth );
+			from = queue.back();
+		}
+	}
+	survey_time = Metrics::now() - start;
+
+	note("graph: average degree %.1f, largest %d, %.0f%% of edges at hubs, diameter at least %d (surveyed in %.3f s)",
+		avg_degree, max_degree, 100 * hub_share, diameter, survey_time);
+
+	pull_above = PLAN_PULL_ABOVE;
+	push_below = PLAN_PUSH_BELOW;
+	if( hub_share >= PLAN_SKEWED_SHARE ) {
+		pull_above *= 2;
+		push_below *= 2;
+		note("direction: pull above 1/%d of the edges, push below 1/%d, as the hubs hold %.0f%% of them",
+			pull_above, push_below, 100 * hub_share);
+	}
+}
+
+/*
+	a breadth-first search from s, leaving the vertices in the
+	order reached in queue, so the last is among the farthest.
+	The depth of the search
+*/
+int Planner::probe(int s, vector<int>& level, vector<int>& queue) {
+
+	std::fill( level.begin(), level.end(), -1 );
+	queue.clear();
+	queue.push_back(s);
+	level[s] = 0;
+	for(size_t i=0; i<queue.size(); i++) {
+		int u = queue[i];
+		for(int j=csr1[u]; j<csr1[u+1]; j++) {
+			int v = csr2[j];
+			if( level[v] < 0 ) {
+				level[v] = level[u] + 1;
+				queue.push_back(v);
+			}
+		}
+	}
+	return level[ queue.back() ];
+}
+
+/*
+	whether to run on the semiring engine, given whether
+	the program has a semiring and whether it is logged
+*/
+bool Planner::choose_engine(bool has_semiring, bool logging) {
+
+	if( !has_semiring ) {
+		note("engine: vertex, the program does not combine with min");
+		return false;
+	}
+	if( logging ) {
+		note("engine: vertex, logging needs its messages");
+		return false;
+	}
+	note("engine: spmv, the program combines with min over a semiring");
+	return true;
+}
+
+/*
+	the threads to run on, of the cpus there are: as many as
+	the edges of an average superstep keep busy, and no more
+	than leave each partition as many edges as the largest vertex
+*/
+int Planner::choose_threads(int cpus) {
+
+	long long per_step = num_edges / std::max( diameter, 1 );
+	long long useful = std::max( 1LL, per_step / PLAN_EDGES_PER_THREAD );
+	long long balanced = std::max( 1LL, num_edges / std::max( max_degree, 1 ) );
+	int threads = (int)std::min( (long long)std::max( cpus, 1 ), std::min( useful, balanced ) );
+	if( threads < cpus && balanced < useful )
+		note("threads: %d of %d cpus, a vertex of degree %d would hold more than a partition's share",
+			threads, cpus, max_degree);
+	else if( threads < cpus )
+		note("threads: %d of %d cpus, an average superstep of %lld edges keeps no more busy",
+			threads, cpus, per_step);
+	else
+		note("threads: %d, one per cpu", threads);
+	return threads;
+}
+
+/*
+	whether the next superstep pulls, given the edges of its
+	frontier, those of the graph, and whether this one pulled
+*/
+bool Planner::frontier_pull(long long frontier_edges, long long total_edges, bool pulling) {
+	bool pull = pulling ? ( frontier_edges * push_below > total_edges )
+		: ( frontier_edges * pull_above > total_edges );
+	last_share = ( total_edges > 0 ) ? 100.0 * frontier_edges / total_edges : 0;
+	last_pull = pull;
+	return pull;
+}
+
+/* record the reason for a choice */
+void Planner::note(const char* format, ...) {
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf( line, sizeof(line), format, args );
+	va_end(args);
+	reasons.push_back(line);
+}
+
+/* the average degree of the graph */
+double Planner::get_avg_degree() {
+	return avg_degree;
+}
+
+/* the largest degree of the graph */
+int Planner::get_max_degree() {
+	return max_degree;
+}
+
+/* the share of the edges at the hubs */
+double Planner::get_hub_share() {
+	return hub_share;
+}
+
+/* the lower bound on the diameter the sweeps found */
+int Planner::get_diameter() {
+	return diameter;
+}
+
+/* the seconds the survey took */
+double Planner::get_survey_time() {
+	return survey_time;
+}
+
+/* the reasons for the choices so far, in order */
+vector<string>& Planner::get_reasons() {
+	return reasons;
+}
+
+/* why the last call of frontier_pull chose as it did */
+string Planner::get_switch_reason() {
+	char line[128];
+	if( last_pull )
+		snprintf( line, sizeof(line), "pull, the frontier holds %.1f%% of the edges, over 1/%d",
+			last_share, pull_above );
+	else
+		snprintf( line, sizeof(line), "push, the frontier holds %.1f%% of the edges, under 1/%d",
+			last_share, push_below );
+	return line;
+}
@@ -0,0 +1,114 @@
+/*
+	Think-Like-A-Vertex Framework, Planner.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Picks how a Worker runs a program on its graph, so the
+	fast path is taken by default without tuning options.
+
+	Once the graph is loaded, survey takes cheap statistics:
+	the average and largest degree, the share of the edges
+	held by the hubs (the vertices of more than
+	PLAN_HUB_DEGREE times the average degree), and a lower
+	bound on the diameter from PLAN_PROBES breadth-first
+	sweeps, each from the farthest vertex of the last, the
+	first from the vertex of largest degree.
+
+	From these and the program, the plan is:
+		engine		the semiring engine for programs that
+				combine with min, unless logging, since its
+				products skip the virtual call and message
+				of each edge
+		threads		one per cpu, but no more than the average
+				superstep, the edges over the diameter,
+				keeps busy at PLAN_EDGES_PER_THREAD each,
+				since a thread costs a barrier per superstep,
+				and no more than the edges over the largest
+				degree, as the partition holding that vertex
+				is at least that large
+		direction	chosen each superstep by frontier_pull:
+				pull once the frontier holds more than
+				1/PLAN_PULL_ABOVE of the edges, and push
+				again once it holds less than
+				1/PLAN_PUSH_BELOW, so a frontier near the
+				line does not flip every superstep.  When the
+				hubs hold PLAN_SKEWED_SHARE of the edges both
+				shares are halved: the frontier reaches the
+				hubs within a superstep or two, and a pulling
+				vertex then stops at its first hub neighbor
+
+	Every choice keeps its reason, for the Worker to report.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// breadth-first sweeps estimating the diameter
+#define PLAN_PROBES 2
+
+// degree, over the average, past which a vertex is a hub
+#define PLAN_HUB_DEGREE 8
+
+// edges a superstep needs per thread for another thread to pay
+#define PLAN_EDGES_PER_THREAD (1<<16)
+
+// the frontier's share of the edges to start and stop pulling
+#define PLAN_PULL_ABOVE 8
+#define PLAN_PUSH_BELOW 16
+
+// the hubs' share of the edges past which the graph is skewed
+#define PLAN_SKEWED_SHARE 0.25
+
+class Planner {
+
+	public:
+		Planner();
+
+		void survey(int, const int*, const int*);
+		bool choose_engine(bool, bool);
+		int choose_threads(int);
+		bool frontier_pull(long long, long long, bool);
+
+		double get_avg_degree();
+		int get_max_degree();
+		double get_hub_share();
+		int get_diameter();
+		double get_survey_time();
+		vector<string>& get_reasons();
+		string get_switch_reason();
+
+	private:
+		int probe(int, vector<int>&, vector<int>&);
+		void note(const char*, ...);
+
+		int num_verts;
+		long long num_edges;
+		const int* csr1;
+		const int* csr2;
+
+		// the statistics
+		double avg_degree;
+		int max_degree;
+		double hub_share;
+		int diameter;
+		double survey_time;
+
+		// the frontier's share of the edges to start and stop pulling
+		int pull_above;
+		int push_below;
+
+		// why each choice was made, and the last switch of direction
+		vector<string> reasons;
+		double last_share;
+		bool last_pull;
+
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+	Think-Like-A-Vertex Framework, BlockedCsr.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the column-blocked CSR arrays
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <algorithm>
+
+#include "BlockedCsr.h"
+
+/* Constructor, no blocks */
+BlockedCsr::BlockedCsr() {}
+
+/*
+	split the CSR arrays of n vertices into blocks of
+	block_cols columns: a pass to size each block,
+	then a pass to fill them.  Weights may be NULL
+*/
+void BlockedCsr::build(int n, const int* csr1, const int* csr2, const int* weights, int block_cols) {
+
+	blocks.clear();
+	arena.release();
+	if( block_cols < 1 ) block_cols = 1;
+	int num_blocks = ( n <= block_cols ) ? 1 : (int)( ( (long long)n + block_cols - 1 ) / block_cols );
+
+	if( num_blocks == 1 ) {
+		CsrBlock b;
+		b.num_rows = n;
+		b.rows = NULL;
+		b.ptr = csr1;
+		b.cols = csr2;
+		b.weights = weights;
+		blocks.push_back(b);
+		return;
+	}
+
+	// the rows and entries of each block
+	vector<long long> num_rows(num_blocks, 0), num_entries(num_blocks, 0);
+	vector<int> last_row(num_blocks, -1);
+	for(int v=0; v<n; v++) {
+		for(int j=csr1[v]; j<csr1[v+1]; j++) {
+			int b = csr2[j] / block_cols;
+			num_entries[b]++;
+			if( last_row[b] != v ) {
+				last_row[b] = v;
+				num_rows[b]++;
+			}
+		}
+	}
+
+	size_t bytes = 0;
+	for(int b=0; b<num_blocks; b++)
+		bytes += sizeof(int) * ( 2 * num_rows[b] + 1 + 2 * num_entries[b] ) + 4 * 64;
+	arena.reserve(bytes);
+
+	vector<int*> rows(num_blocks), ptr(num_blocks), cols(num_blocks), wts(num_blocks);
+	for(int b=0; b<num_blocks; b++) {
+		rows[b] = arena.alloc_array<int>( num_rows[b] );
+		ptr[b] = arena.alloc_array<int>( num_rows[b] + 1 );
+		cols[b] = arena.alloc_array<int>( num_entries[b] );
+		wts[b] = ( weights != NULL ) ? arena.alloc_array<int>( num_entries[b] ) : NULL;
+		ptr[b][0] = 0;
+		num_rows[b] = 0;
+		num_entries[b] = 0;
+		last_row[b] = -1;
+	}
+
+	for(int v=0; v<n; v++) {
+		for(int j=csr1[v]; j<csr1[v+1]; j++) {
+			int b = csr2[j] / block_cols;
+			if( last_row[b] != v ) {
+				last_row[b] = v;
+				rows[b][ num_rows[b]++ ] = v;
+			}
+			cols[b][ num_entries[b] ] = csr2[j];
+			if( weights != NULL ) wts[b][ num_entries[b] ] = weights[j];
+			num_entries[b]++;
+			ptr[b][ num_rows[b] ] = num_entries[b];
+		}
+	}
+
+	for(int b=0; b<num_blocks; b++) {
+		CsrBlock blk;
+		blk.num_rows = num_rows[b];
+		blk.rows = rows[b];
+		blk.ptr = ptr[b];
+		blk.cols = cols[b];
+		blk.weights = wts[b];
+		blocks.push_back(blk);
+	}
+}
+
+/* the number of blocks */
+int BlockedCsr::get_num_blocks() {
+	return blocks.size();
+}
+
+/* a block of columns */
+const CsrBlock& BlockedCsr::get_block(int b) {
+	return blocks[b];
+}
+
+/* the first row of block b whose vertex is not below v */
+int BlockedCsr::find_row(int b, int v) {
+	const CsrBlock& blk = blocks[b];
+	if( blk.rows == NULL ) return std::min( v, blk.num_rows );
+	return std::lower_bound( blk.rows, blk.rows + blk.num_rows, v ) - blk.rows;
+}
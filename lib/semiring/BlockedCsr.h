@@ -0,0 +1,55 @@
+/*
+	Think-Like-A-Vertex Framework, BlockedCsr.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	The CSR arrays split into blocks of columns, for a
+	cache-blocked sparse matrix-vector product: while a block
+	is multiplied, only its slice of the input vector is read,
+	and that slice fits in cache.
+
+	Each block holds the rows with an entry in its columns
+	(doubly compressed, so empty rows cost nothing), their row
+	pointers, and the columns and weights of the entries.
+	A graph of a single block uses the CSR arrays as they are.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef BLOCKEDCSR_H
+#define BLOCKEDCSR_H
+
+#include <vector>
+using std::vector;
+
+#include "Arena.h"
+
+/*
+	one block of columns.  Row r of the block is vertex rows[r],
+	or vertex r if rows is NULL, and its entries are
+	cols[ ptr[r] ... ptr[r+1] ) with their weights
+*/
+struct CsrBlock {
+	int num_rows;
+	const int* rows;
+	const int* ptr;
+	const int* cols;
+	const int* weights;
+};
+
+class BlockedCsr {
+
+	public:
+		BlockedCsr();
+		void build(int, const int*, const int*, const int*, int);
+		int get_num_blocks();
+		const CsrBlock& get_block(int);
+		int find_row(int, int);
+
+	private:
+		vector<CsrBlock> blocks;
+		Arena arena;
+
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+	Think-Like-A-Vertex Framework, Semiring.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Semirings over int values, and the sparse matrix-vector
+	product over them, for running programs as linear algebra
+	(Kepner & Gilbert, Graph Algorithms in the Language of
+	Linear Algebra).  One step of a program is y = A x over its
+	semiring, where A is the adjacency matrix:
+		bfs		the boolean semiring (or, and)
+		sssp	the (min, +) semiring
+		cc		the (min, select) semiring, keeping the value
+
+	A semiring gives the zero of its add, add and multiply,
+	whether multiply reads the edge weight, and whether a
+	sum is saturated, i.e. can grow no further, so a row
+	can stop early.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef SEMIRING_H
+#define SEMIRING_H
+
+#include <limits.h>
+
+#include "BlockedCsr.h"
+
+/* (or, and): whether a vertex has a neighbor on the frontier */
+struct BooleanSemiring {
+	static const bool weighted = false;
+	static int zero() { return 0; }
+	static int add(int a, int b) { return a | b; }
+	static int multiply(int x, int) { return x; }
+	static bool saturated(int a) { return a != 0; }
+};
+
+/* (min, +): the least distance through a neighbor */
+struct MinPlusSemiring {
+	static const bool weighted = true;
+	static int zero() { return INT_MAX; }
+	static int add(int a, int b) { return ( b < a ) ? b : a; }
+	static int multiply(int x, int w) { return ( x == INT_MAX ) ? INT_MAX : x + w; }
+	static bool saturated(int) { return false; }
+};
+
+/* (min, select): the least label of a neighbor */
+struct MinSelectSemiring {
+	static const bool weighted = false;
+	static int zero() { return INT_MAX; }
+	static int add(int a, int b) { return ( b < a ) ? b : a; }
+	static int multiply(int x, int) { return x; }
+	static bool saturated(int) { return false; }
+};
+
+/*
+	y = A x over semiring S for the rows [lo,hi), a block of
+	columns at a time.  With a mask, only the rows of unreached
+	vertices (mask value INT_MAX) are computed, the rest keep
+	zero.  Rows in [lo,hi) are written by no other thread, so
+	threads may share y over disjoint ranges.
+*/
+template<typename S>
+void spmv_rows(BlockedCsr& A, const int* x, int* y, const int* mask, int lo, int hi) {
+
+	for(int v=lo; v<hi; v++)
+		y[v] = S::zero();
+
+	for(int b=0; b<A.get_num_blocks(); b++) {
+		const CsrBlock& blk = A.get_block(b);
+		int r_hi = A.find_row(b, hi);
+		for(int r=A.find_row(b, lo); r<r_hi; r++) {
+			int v = ( blk.rows != NULL ) ? blk.rows[r] : r;
+			if( mask != NULL && mask[v] != INT_MAX ) continue;
+			int acc = y[v];
+			if( S::saturated(acc) ) continue;
+			for(int j=blk.ptr[r]; j<blk.ptr[r+1]; j++) {
+				acc = S::add( acc, S::multiply( x[ blk.cols[j] ], S::weighted ? blk.weights[j] : 1 ) );
+				if( S::saturated(acc) ) break;
+			}
+			y[v] = acc;
+		}
+	}
+}
+
+#endif
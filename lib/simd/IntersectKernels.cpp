@@ -0,0 +1,199 @@
+/*
+	Think-Like-A-Vertex Framework, IntersectKernels.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the sorted set intersection kernels.
+	The vector kernels are compiled for their instruction set
+	by target attributes, as the pull kernels are.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "IntersectKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define INTERSECT_X86
+#include <immintrin.h>
+#endif
+
+/*
+	merge the rest of two sets from a[i] and b[j], without
+	branches on the data: every element is written, and kept
+	by advancing past it only if both sets hold it
+*/
+static inline int merge_from( const int* a, int i, int na, const int* b, int j, int nb, int* out ) {
+
+	int n = 0;
+	while( i < na && j < nb ) {
+		int x = a[i], y = b[j];
+		out[n] = x;
+		n += ( x == y );
+		i += ( x <= y );
+		j += ( y <= x );
+	}
+	return n;
+}
+
+/* the scalar kernel, a merge, for any cpu */
+static int intersect_scalar( const int* a, int na, const int* b, int nb, int* out ) {
+	return merge_from( a, 0, na, b, 0, nb, out );
+}
+
+#ifdef INTERSECT_X86
+
+/*
+	for each 8 bit mask, the lanes of its set bits in order,
+	to pack the common elements of a block to the front
+*/
+struct CompressTable {
+	int lanes[256][8];
+	CompressTable() {
+		for(int m=0; m<256; m++) {
+			int k = 0;
+			for(int l=0; l<8; l++)
+				if( m & (1 << l) ) lanes[m][k++] = l;
+			for(; k<8; k++)
+				lanes[m][k] = 0;
+		}
+	}
+};
+static CompressTable compress_table;
+
+/* blocks of 8 against the 8 rotations of the other's block */
+__attribute__((target("avx2,popcnt")))
+static int intersect_avx2( const int* a, int na, const int* b, int nb, int* out ) {
+
+	const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+	int i = 0, j = 0, n = 0;
+	while( i+8 <= na && j+8 <= nb ) {
+		__m256i va = _mm256_loadu_si256( (const __m256i*)&a[i] );
+		__m256i vb = _mm256_loadu_si256( (const __m256i*)&b[j] );
+		__m256i eq = _mm256_cmpeq_epi32( va, vb );
+		for(int r=1; r<8; r++) {
+			vb = _mm256_permutevar8x32_epi32( vb, rotate );
+			eq = _mm256_or_si256( eq, _mm256_cmpeq_epi32( va, vb ) );
+		}
+		int mask = _mm256_movemask_ps( _mm256_castsi256_ps(eq) );
+		if( mask != 0 ) {
+			__m256i lanes = _mm256_loadu_si256( (const __m256i*)compress_table.lanes[mask] );
+			_mm256_storeu_si256( (__m256i*)&out[n], _mm256_permutevar8x32_epi32( va, lanes ) );
+			n += __builtin_popcount(mask);
+		}
+		int a_last = a[i+7], b_last = b[j+7];
+		if( a_last <= b_last ) i += 8;
+		if( b_last <= a_last ) j += 8;
+	}
+	return n + merge_from( a, i, na, b, j, nb, out + n );
+}
+
+// the undefined vectors of gcc 12's avx512 intrinsics read
+// themselves, which -Wall takes for uninitialized use
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/* blocks of 16, the common elements packed by a compressing store */
+__attribute__((target("avx512f,popcnt")))
+static int intersect_avx512( const int* a, int na, const int* b, int nb, int* out ) {
+
+	const __m512i rotate = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0);
+	int i = 0, j = 0, n = 0;
+	while( i+16 <= na && j+16 <= nb ) {
+		__m512i va = _mm512_loadu_si512( &a[i] );
+		__m512i vb = _mm512_loadu_si512( &b[j] );
+		__mmask16 eq = _mm512_cmpeq_epi32_mask( va, vb );
+		for(int r=1; r<16; r++) {
+			vb = _mm512_permutexvar_epi32( rotate, vb );
+			eq |= _mm512_cmpeq_epi32_mask( va, vb );
+		}
+		if( eq != 0 ) {
+			_mm512_mask_compressstoreu_epi32( &out[n], eq, va );
+			n += __builtin_popcount(eq);
+		}
+		int a_last = a[i+15], b_last = b[j+15];
+		if( a_last <= b_last ) i += 16;
+		if( b_last <= a_last ) j += 16;
+	}
+	return n + merge_from( a, i, na, b, j, nb, out + n );
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+/* Constructor, the widest kernel the cpu runs */
+IntersectKernels::IntersectKernels() {
+	select("auto");
+}
+
+/*
+	select a kernel by name: scalar, avx2, avx512,
+	or auto for the widest the cpu runs.
+	False, keeping the current kernel, if the cpu cannot run it
+*/
+bool IntersectKernels::select(string isa) {
+
+	if( isa == "auto" ) {
+		if( !select("avx512") && !select("avx2") ) select("scalar");
+		return true;
+	}
+	if( isa == "scalar" ) {
+		kernel = intersect_scalar;
+		name = isa;
+		return true;
+	}
+#ifdef INTERSECT_X86
+	__builtin_cpu_init();
+	if( isa == "avx2" && __builtin_cpu_supports("avx2") ) {
+		kernel = intersect_avx2;
+		name = isa;
+		return true;
+	}
+	if( isa == "avx512" && __builtin_cpu_supports("avx512f") ) {
+		kernel = intersect_avx512;
+		name = isa;
+		return true;
+	}
+#endif
+	return false;
+}
+
+/* the name of the selected kernel */
+string IntersectKernels::get_name() {
+	return name;
+}
+
+/*
+	the common elements of a short set a and a long set b:
+	each element of a is found in b by doubling the step
+	from where the last one was found, then a binary search
+*/
+int IntersectKernels::gallop( const int* a, int na, const int* b, int nb, int* out ) {
+
+	int n = 0, lo = 0;
+	for(int i=0; i<na; i++) {
+		int x = a[i];
+
+		// every b before lo is less than x, and b[hi] is not
+		int hi = lo, step = 1;
+		while( hi < nb && b[hi] < x ) {
+			lo = hi + 1;
+			hi += step;
+			step <<= 1;
+		}
+		if( hi > nb ) hi = nb;
+
+		while( lo < hi ) {
+			int mid = lo + (hi - lo) / 2;
+			if( b[mid] < x ) lo = mid + 1;
+			else hi = mid;
+		}
+		if( lo == nb ) break;
+		if( b[lo] == x ) out[n++] = x;
+	}
+	return n;
+}
@@ -0,0 +1,65 @@
+/*
+	Think-Like-A-Vertex Framework, IntersectKernels.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Vectorized intersection of sorted sets, such as the
+	neighbor rows of the CSR, for triangle counting.
+
+	A kernel writes the elements two sorted, duplicate-free
+	sets have in common to out, in order, and returns how
+	many there are.  The vector kernels compare a block of one
+	set against every rotation of a block of the other, then
+	advance past whichever block ends first, as in a merge.
+	When one set is much longer than the other, each element
+	of the shorter is instead found in the longer by galloping
+	(exponential then binary search).
+
+	The widest kernel the cpu runs is picked at runtime:
+	AVX-512, AVX2, or the scalar merge on any other cpu.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef INTERSECTKERNELS_H
+#define INTERSECTKERNELS_H
+
+#include <string>
+using std::string;
+
+// gallop once one set is this many times longer than the other
+#define GALLOP_RATIO 32
+
+// ints a kernel may write past the common elements
+#define INTERSECT_SLACK 16
+
+/*
+	the common elements of a[0,na) and b[0,nb) into out,
+	which has room for min(na,nb) + INTERSECT_SLACK ints
+*/
+typedef int (*IntersectKernel)( const int* a, int na, const int* b, int nb, int* out );
+
+class IntersectKernels {
+
+	public:
+		IntersectKernels();
+		bool select(string);
+		string get_name();
+
+		static int gallop( const int* a, int na, const int* b, int nb, int* out );
+
+		/* gallop from the shorter set, or run the selected kernel */
+		int intersect( const int* a, int na, const int* b, int nb, int* out ) {
+			if( na > nb ) return intersect( b, nb, a, na, out );
+			if( na == 0 ) return 0;
+			if( nb / na >= GALLOP_RATIO ) return gallop( a, na, b, nb, out );
+			return kernel( a, na, b, nb, out );
+		}
+
+	private:
+		IntersectKernel kernel;
+		string name;
+
+};
+
+#endif
@@ -0,0 +1,159 @@
+/*
+	Think-Like-A-Vertex Framework, PullKernels.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the gather-and-min kernels.
+	The vector kernels are compiled for their instruction set
+	by target attributes, so the rest of the program needs
+	no special flags and runs on any x86-64 cpu.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "PullKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PULL_X86
+#include <immintrin.h>
+#endif
+
+/* the scalar kernel, for any cpu */
+static void gather_min_scalar( const int* csr1, const int* csr2, const int* weights, int add,
+		const int* frontier, int lo, int hi, int* best ) {
+
+	for(int v=lo; v<hi; v++) {
+		int m = PULL_INF;
+		if( weights != NULL ) {
+			for(int j=csr1[v]; j<csr1[v+1]; j++) {
+				int f = frontier[ csr2[j] ];
+				if( f != PULL_INF && f + weights[j] < m )
+					m = f + weights[j];
+			}
+		} else {
+			for(int j=csr1[v]; j<csr1[v+1]; j++)
+				m = ( frontier[ csr2[j] ] < m ) ? frontier[ csr2[j] ] : m;
+			if( m != PULL_INF ) m += add;
+		}
+		best[v] = m;
+	}
+}
+
+#ifdef PULL_X86
+
+/* 8 neighbors at a time, the rest one by one */
+__attribute__((target("avx2")))
+static void gather_min_avx2( const int* csr1, const int* csr2, const int* weights, int add,
+		const int* frontier, int lo, int hi, int* best ) {
+
+	const __m256i inf = _mm256_set1_epi32(PULL_INF);
+	for(int v=lo; v<hi; v++) {
+		int j = csr1[v], end = csr1[v+1];
+		__m256i acc = inf;
+		for(; j+8<=end; j+=8) {
+			__m256i idx = _mm256_loadu_si256( (const __m256i*)&csr2[j] );
+			__m256i f = _mm256_i32gather_epi32( frontier, idx, 4 );
+			if( weights != NULL ) {
+				__m256i w = _mm256_loadu_si256( (const __m256i*)&weights[j] );
+				__m256i s = _mm256_add_epi32( f, w );
+				f = _mm256_blendv_epi8( s, inf, _mm256_cmpeq_epi32( f, inf ) );
+			}
+			acc = _mm256_min_epi32( acc, f );
+		}
+
+		// horizontal min of the 8 lanes
+		__m256i m = _mm256_min_epi32( acc, _mm256_permute2x128_si256( acc, acc, 1 ) );
+		m = _mm256_min_epi32( m, _mm256_shuffle_epi32( m, 0x4E ) );
+		m = _mm256_min_epi32( m, _mm256_shuffle_epi32( m, 0xB1 ) );
+		int r = _mm256_cvtsi256_si32(m);
+
+		for(; j<end; j++) {
+			int f = frontier[ csr2[j] ];
+			if( weights != NULL && f != PULL_INF ) f += weights[j];
+			r = ( f < r ) ? f : r;
+		}
+		if( weights == NULL && r != PULL_INF ) r += add;
+		best[v] = r;
+	}
+}
+
+// the undefined vectors of gcc 12's avx512 intrinsics read
+// themselves, which -Wall takes for uninitialized use
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/* 16 neighbors at a time, the last few under a mask */
+__attribute__((target("avx512f")))
+static void gather_min_avx512( const int* csr1, const int* csr2, const int* weights, int add,
+		const int* frontier, int lo, int hi, int* best ) {
+
+	const __m512i inf = _mm512_set1_epi32(PULL_INF);
+	for(int v=lo; v<hi; v++) {
+		int end = csr1[v+1];
+		__m512i acc = inf;
+		for(int j=csr1[v]; j<end; j+=16) {
+			__mmask16 k = ( end - j >= 16 ) ? (__mmask16)0xFFFF : (__mmask16)( (1u << (end - j)) - 1 );
+			__m512i idx = _mm512_maskz_loadu_epi32( k, &csr2[j] );
+			__m512i f = _mm512_mask_i32gather_epi32( inf, k, idx, frontier, 4 );
+			if( weights != NULL ) {
+				__m512i w = _mm512_maskz_loadu_epi32( k, &weights[j] );
+				__mmask16 on = _mm512_cmpneq_epi32_mask( f, inf );
+				f = _mm512_mask_add_epi32( inf, on, f, w );
+			}
+			acc = _mm512_min_epi32( acc, f );
+		}
+		int r = _mm512_reduce_min_epi32(acc);
+		if( weights == NULL && r != PULL_INF ) r += add;
+		best[v] = r;
+	}
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+/* Constructor, the widest kernel the cpu runs */
+PullKernels::PullKernels() {
+	select("auto");
+}
+
+/*
+	select a kernel by name: scalar, avx2, avx512,
+	or auto for the widest the cpu runs.
+	False, keeping the current kernel, if the cpu cannot run it
+*/
+bool PullKernels::select(string isa) {
+
+	if( isa == "auto" ) {
+		if( !select("avx512") && !select("avx2") ) select("scalar");
+		return true;
+	}
+	if( isa == "scalar" ) {
+		kernel = gather_min_scalar;
+		name = isa;
+		return true;
+	}
+#ifdef PULL_X86
+	__builtin_cpu_init();
+	if( isa == "avx2" && __builtin_cpu_supports("avx2") ) {
+		kernel = gather_min_avx2;
+		name = isa;
+		return true;
+	}
+	if( isa == "avx512" && __builtin_cpu_supports("avx512f") ) {
+		kernel = gather_min_avx512;
+		name = isa;
+		return true;
+	}
+#endif
+	return false;
+}
+
+/* the name of the selected kernel */
+string PullKernels::get_name() {
+	return name;
+}
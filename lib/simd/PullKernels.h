@@ -0,0 +1,59 @@
+/*
+	Think-Like-A-Vertex Framework, PullKernels.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Vectorized gather-and-min kernels for the pull supersteps
+	of programs that combine messages with min, such as
+	bfs, cc and sssp.
+
+	For each vertex v of a range, a kernel finds the least
+	frontier[u] + w over the neighbors u of v, where w is the
+	weight of the edge or a constant.  Neighbors off the frontier
+	hold PULL_INF and never count, so a vertex with no frontier
+	neighbor gets PULL_INF.
+
+	The widest kernel the cpu runs is picked at runtime:
+	AVX-512, AVX2, or the scalar loop on any other cpu.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef PULLKERNELS_H
+#define PULLKERNELS_H
+
+#include <limits.h>
+#include <string>
+using std::string;
+
+// the value of a vertex off the frontier
+#define PULL_INF INT_MAX
+
+/*
+	best[v] for each v in [lo,hi), from the CSR arrays,
+	the edge weights (or NULL, to add a constant) and
+	the frontier values
+*/
+typedef void (*PullKernel)( const int* csr1, const int* csr2, const int* weights, int add,
+	const int* frontier, int lo, int hi, int* best );
+
+class PullKernels {
+
+	public:
+		PullKernels();
+		bool select(string);
+		string get_name();
+
+		/* run the selected kernel */
+		void gather_min( const int* csr1, const int* csr2, const int* weights, int add,
+				const int* frontier, int lo, int hi, int* best ) {
+			kernel( csr1, csr2, weights, add, frontier, lo, hi, best );
+		}
+
+	private:
+		PullKernel kernel;
+		string name;
+
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*
+	Think-Like-A-Vertex Framework, TriangleCounter.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the triangle counting engine
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <algorithm>
+#include <thread>
+
+#include "TriangleCounter.h"
+
+/* Constructor, running on num_threads threads */
+TriangleCounter::TriangleCounter(int _num_threads) {
+	num_threads = ( _num_threads < 1 ) ? 1 : _num_threads;
+	num_verts = 0;
+	out1 = out2 = NULL;
+	counts = NULL;
+	max_out = 0;
+	total = 0;
+	num_chunks = 0;
+}
+
+/*
+	select the intersection kernel by name, as
+	IntersectKernels::select, false if the cpu cannot run it
+*/
+bool TriangleCounter::select(string isa) {
+	return kernels.select(isa);
+}
+
+/* the name of the selected intersection kernel */
+string TriangleCounter::get_kernel_name() {
+	return kernels.get_name();
+}
+
+/*
+	count the triangles of the n vertices of the CSR arrays,
+	which hold every edge in both directions: orient the
+	edges, then count over the oriented rows
+*/
+void TriangleCounter::count(int n, const int* _csr1, const int* _csr2) {
+
+	num_verts = n;
+	csr1 = _csr1;
+	csr2 = _csr2;
+	total = 0;
+
+	int threads = num_threads;
+	if( threads > n ) threads = ( n > 0 ) ? n : 1;
+
+	// shares of roughly equal vertices plus edges
+	part_bounds.assign(threads+1, 0);
+	long long cost = (long long)csr1[n] + n;
+	for(int t=1; t<threads; t++) {
+		long long target = cost * t / threads;
+		int lo = part_bounds[t-1], hi = n;
+		while( lo < hi ) {
+			int mid = lo + (hi-lo)/2;
+			if( (long long)csr1[mid] + mid < target ) lo = mid+1;
+			else hi = mid;
+		}
+		part_bounds[t] = lo;
+	}
+	part_bounds[threads] = n;
+	part_totals.assign(threads, 0);
+
+	// the oriented rows hold at most every edge
+	arena.release();
+	arena.reserve( sizeof(int) * ( (size_t)n + 1 + (size_t)csr1[n] ) + sizeof(long long) * (size_t)n + 3 * 64 );
+	out1 = arena.alloc_array<int>( (size_t)n + 1 );
+	counts = arena.alloc_array<long long>(n);
+
+	out1[0] = 0;
+	run_threads( &TriangleCounter::orient_degrees );
+	max_out = 0;
+	for(int v=0; v<n; v++) {
+		max_out = std::max( max_out, out1[v+1] );
+		out1[v+1] += out1[v];
+	}
+	out2 = arena.alloc_array<int>( out1[n] );
+	run_threads( &TriangleCounter::orient_rows );
+
+	num_chunks = (int)( ( (long long)out1[n] + TC_CHUNK_EDGES - 1 ) / TC_CHUNK_EDGES );
+	next_chunk = 0;
+	run_threads( &TriangleCounter::count_chunks );
+
+	for(int t=0; t<threads; t++)
+		total += part_totals[t];
+
+	return;
+}
+
+/* whether u comes before v in the orientation: lower degree, then lower id */
+inline bool TriangleCounter::before(int u, int v) {
+	int du = csr1[u+1] - csr1[u], dv = csr1[v+1] - csr1[v];
+	return du < dv || ( du == dv && u < v );
+}
+
+/*
+	run a function on every share, each in its own
+	thread, or inline for a single share
+*/
+void TriangleCounter::run_threads( void (TriangleCounter::*fn)(int) ) {
+
+	int threads = part_bounds.size() - 1;
+	if( threads == 1 ) {
+		(this->*fn)(0);
+		return;
+	}
+	vector<std::thread> pool;
+	for(int t=0; t<threads; t++)
+		pool.push_back( std::thread( fn, this, t ) );
+	for(int t=0; t<threads; t++)
+		pool[t].join();
+}
+
+/*
+	the oriented degree of each vertex of a share,
+	stored one place on for the prefix sum
+*/
+void TriangleCounter::orient_degrees(int t) {
+
+	for(int v=part_bounds[t]; v<part_bounds[t+1]; v++) {
+		int d = 0;
+		for(int j=csr1[v]; j<csr1[v+1]; j++)
+			if( before(v, csr2[j]) ) d++;
+		out1[v+1] = d;
+		counts[v] = 0;
+	}
+}
+
+/*
+	copy the neighbors each vertex of a share comes before,
+	sorting the rows of an input that was not sorted
+*/
+void TriangleCounter::orient_rows(int t) {
+
+	for(int v=part_bounds[t]; v<part_bounds[t+1]; v++) {
+		int* row = &out2[ out1[v] ];
+		int d = 0;
+		bool sorted = true;
+		for(int j=csr1[v]; j<csr1[v+1]; j++) {
+			int u = csr2[j];
+			if( !before(v, u) ) continue;
+			if( d > 0 && row[d-1] > u ) sorted = false;
+			row[d++] = u;
+		}
+		if( !sorted ) std::sort( row, row + d );
+	}
+}
+
+/*
+	take chunks of oriented edges until none are left.  Chunk c
+	holds the vertices whose rows start in its range of edges.
+	The triangles on each oriented edge (u,v) are the common
+	out-neighbors w of u and v, and add one to u, v and each w
+*/
+void TriangleCounter::count_chunks(int t) {
+
+	vector<int> common( max_out + INTERSECT_SLACK );
+	long long found = 0;
+
+	for(;;) {
+		int c = next_chunk.fetch_add(1);
+		if( c >= num_chunks ) break;
+		int lo = std::lower_bound( out1, out1 + num_verts, (long long)c * TC_CHUNK_EDGES ) - out1;
+		int hi = ( c == num_chunks-1 ) ? num_verts :
+			std::lower_bound( out1, out1 + num_verts, (long long)(c+1) * TC_CHUNK_EDGES ) - out1;
+
+		for(int u=lo; u<hi; u++) {
+			const int* row_u = &out2[ out1[u] ];
+			int n_u = out1[u+1] - out1[u];
+			long long count_u = 0;
+			for(int k=0; k<n_u; k++) {
+				int v = row_u[k];
+				int n = kernels.intersect( row_u, n_u, &out2[ out1[v] ], out1[v+1] - out1[v], &common[0] );
+				if( n == 0 ) continue;
+				count_u += n;
+				__atomic_fetch_add( &counts[v], (long long)n, __ATOMIC_RELAXED );
+				for(int i=0; i<n; i++)
+					__atomic_fetch_add( &counts[ common[i] ], 1LL, __ATOMIC_RELAXED );
+			}
+			if( count_u > 0 )
+				__atomic_fetch_add( &counts[u], count_u, __ATOMIC_RELAXED );
+			found += count_u;
+		}
+	}
+	part_totals[t] = found;
+}
+
+/* the number of triangles of the last count */
+long long TriangleCounter::get_total() {
+	return total;
+}
+
+/* the triangles of each vertex of the last count */
+long long* TriangleCounter::get_counts() {
+	return counts;
+}
+
+/* the number of oriented edges, each undirected edge once */
+long long TriangleCounter::get_oriented_edges() {
+	return ( out1 != NULL ) ? out1[num_verts] : 0;
+}
@@ -0,0 +1,80 @@
+/*
+	Think-Like-A-Vertex Framework, TriangleCounter.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	A triangle counting engine over the CSR arrays, outside
+	the superstep model: sending every vertex's neighbors to
+	each neighbor would take O(sum deg^2) messages.
+
+	The edges are first oriented from the vertex of lower degree
+	to the higher (ties by id), which leaves every vertex at most
+	O(sqrt m) out-neighbors and each triangle one lowest vertex.
+	The oriented rows keep their sorted order, and the triangles
+	on each oriented edge (u,v) are the common elements of the
+	rows of u and v, found by the intersection kernels.
+
+	Threads take chunks of a balanced number of oriented edges
+	from a shared counter.  Every triangle adds one to the count
+	of each of its vertices, and one to the total.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef TRIANGLECOUNTER_H
+#define TRIANGLECOUNTER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "Arena.h"
+#include "IntersectKernels.h"
+
+// oriented edges per chunk of counting work
+#define TC_CHUNK_EDGES (1<<14)
+
+class TriangleCounter {
+
+	public:
+		TriangleCounter(int num_threads=1);
+		bool select(string);
+		string get_kernel_name();
+
+		void count(int, const int*, const int*);
+		long long get_total();
+		long long* get_counts();
+		long long get_oriented_edges();
+
+	private:
+		bool before(int, int);
+		void run_threads( void (TriangleCounter::*)(int) );
+		void orient_degrees(int);
+		void orient_rows(int);
+		void count_chunks(int);
+
+		int num_threads;
+		IntersectKernels kernels;
+
+		// the graph, and the first vertex of each thread's share
+		int num_verts;
+		const int* csr1;
+		const int* csr2;
+		vector<int> part_bounds;
+
+		// the oriented rows, the counts of each vertex, and the total
+		Arena arena;
+		int* out1;
+		int* out2;
+		int max_out;
+		long long* counts;
+		vector<long long> part_totals;
+		long long total;
+		std::atomic<int> next_chunk;
+		int num_chunks;
+
+};
+
+#endif
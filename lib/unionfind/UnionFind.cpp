@@ -0,0 +1,213 @@
+/*
+	Think-Like-A-Vertex Framework, UnionFind.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the union-find connected components engine
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <map>
+#include <random>
+#include <thread>
+
+#include "UnionFind.h"
+
+/* Constructor, running on num_threads threads */
+UnionFind::UnionFind(int _num_threads) {
+	num_threads = ( _num_threads < 1 ) ? 1 : _num_threads;
+	num_verts = 0;
+	comp = NULL;
+	round = 0;
+	skipped_root = -1;
+	skipped_edges = 0;
+}
+
+/*
+	find the component of each of the n vertices of the CSR
+	arrays, which hold every edge in both directions: link the
+	first edges of every vertex, then the rest of the edges of
+	the vertices outside the most frequent component
+*/
+void UnionFind::find_components(int n, const int* _csr1, const int* _csr2) {
+
+	num_verts = n;
+	csr1 = _csr1;
+	csr2 = _csr2;
+	skipped_root = -1;
+	skipped_edges = 0;
+
+	int threads = num_threads;
+	if( threads > n ) threads = ( n > 0 ) ? n : 1;
+
+	// shares of roughly equal vertices plus edges
+	part_bounds.assign(threads+1, 0);
+	long long cost = (long long)csr1[n] + n;
+	for(int t=1; t<threads; t++) {
+		long long target = cost * t / threads;
+		int lo = part_bounds[t-1], hi = n;
+		while( lo < hi ) {
+			int mid = lo + (hi-lo)/2;
+			if( (long long)csr1[mid] + mid < target ) lo = mid+1;
+			else hi = mid;
+		}
+		part_bounds[t] = lo;
+	}
+	part_bounds[threads] = n;
+	part_skipped.assign(threads, 0);
+
+	arena.release();
+	arena.reserve( sizeof(int) * (size_t)n + 64 );
+	comp = arena.alloc_array<int>(n);
+	run_threads( &UnionFind::init_share );
+	if( n == 0 ) return;
+
+	for(round=0; round<UF_SAMPLE_ROUNDS; round++) {
+		run_threads( &UnionFind::link_round );
+		run_threads( &UnionFind::compress );
+	}
+
+	skipped_root = sample_root();
+	run_threads( &UnionFind::link_rest );
+	run_threads( &UnionFind::compress );
+
+	for(size_t t=0; t<part_skipped.size(); t++)
+		skipped_edges += part_skipped[t];
+}
+
+/*
+	run a function on every share, each in its own
+	thread, or inline for a single share
+*/
+void UnionFind::run_threads( void (UnionFind::*fn)(int) ) {
+
+	int threads = part_bounds.size() - 1;
+	if( threads == 1 ) {
+		(this->*fn)(0);
+		return;
+	}
+	vector<std::thread> pool;
+	for(int t=0; t<threads; t++)
+		pool.push_back( std::thread( fn, this, t ) );
+	for(int t=0; t<threads; t++)
+		pool[t].join();
+}
+
+/*
+	join the trees of u and v: hook the root of greater id under
+	the lesser, retrying from the new parents if another thread
+	hooked either root first
+*/
+void UnionFind::link(int u, int v) {
+
+	int p1 = __atomic_load_n( &comp[u], __ATOMIC_RELAXED );
+	int p2 = __atomic_load_n( &comp[v], __ATOMIC_RELAXED );
+	while( p1 != p2 ) {
+		int high = ( p1 > p2 ) ? p1 : p2;
+		int low = p1 + p2 - high;
+		int p_high = __atomic_load_n( &comp[high], __ATOMIC_RELAXED );
+
+		// already hooked to low, or hooked here as a root
+		if( p_high == low ) break;
+		if( p_high == high && __atomic_compare_exchange_n( &comp[high], &p_high, low,
+			false, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+			break;
+
+		p1 = __atomic_load_n( &comp[ __atomic_load_n( &comp[high], __ATOMIC_RELAXED ) ], __ATOMIC_RELAXED );
+		p2 = __atomic_load_n( &comp[low], __ATOMIC_RELAXED );
+	}
+}
+
+/* every vertex of a share its own tree */
+void UnionFind::init_share(int t) {
+	for(int v=part_bounds[t]; v<part_bounds[t+1]; v++)
+		comp[v] = v;
+}
+
+/* link each vertex of a share along its edge of this round */
+void UnionFind::link_round(int t) {
+
+	for(int v=part_bounds[t]; v<part_bounds[t+1]; v++) {
+		int j = csr1[v] + round;
+		if( j < csr1[v+1] ) link( v, csr2[j] );
+	}
+}
+
+/*
+	link each vertex of a share outside the skipped
+	component along the edges after the sampled rounds
+*/
+void UnionFind::link_rest(int t) {
+
+	long long skipped = 0;
+	for(int v=part_bounds[t]; v<part_bounds[t+1]; v++) {
+		int first = csr1[v] + UF_SAMPLE_ROUNDS;
+		if( first >= csr1[v+1] ) continue;
+		if( __atomic_load_n( &comp[v], __ATOMIC_RELAXED ) == skipped_root ) {
+			skipped += csr1[v+1] - first;
+			continue;
+		}
+		for(int j=first; j<csr1[v+1]; j++)
+			link( v, csr2[j] );
+	}
+	part_skipped[t] = skipped;
+}
+
+/* point each vertex of a share at its root, by pointer jumping */
+void UnionFind::compress(int t) {
+
+	for(int v=part_bounds[t]; v<part_bounds[t+1]; v++) {
+		int p = __atomic_load_n( &comp[v], __ATOMIC_RELAXED );
+		int gp = __atomic_load_n( &comp[p], __ATOMIC_RELAXED );
+		while( p != gp ) {
+			__atomic_store_n( &comp[v], gp, __ATOMIC_RELAXED );
+			p = gp;
+			gp = __atomic_load_n( &comp[p], __ATOMIC_RELAXED );
+		}
+	}
+}
+
+/*
+	the most frequent root among a fixed random sample of
+	vertices, very likely that of the largest component
+*/
+int UnionFind::sample_root() {
+
+	std::mt19937 gen(27491095);
+	std::uniform_int_distribution<int> pick(0, num_verts-1);
+	std::map<int, int> seen;
+	int best = comp[0], best_count = 0;
+	for(int i=0; i<UF_SAMPLE_VERTS; i++) {
+		int root = comp[ pick(gen) ];
+		int count = ++seen[root];
+		if( count > best_count ) {
+			best = root;
+			best_count = count;
+		}
+	}
+	return best;
+}
+
+/* the component of each vertex of the last run, the least id in it */
+int* UnionFind::get_components() {
+	return comp;
+}
+
+/* the number of components of the last run */
+int UnionFind::get_num_components() {
+	int count = 0;
+	for(int v=0; v<num_verts; v++)
+		if( comp[v] == v ) count++;
+	return count;
+}
+
+/* the root of the component whose remaining edges were skipped */
+int UnionFind::get_skipped_root() {
+	return skipped_root;
+}
+
+/* the directed edges left unlinked inside the skipped component */
+long long UnionFind::get_skipped_edges() {
+	return skipped_edges;
+}
@@ -0,0 +1,81 @@
+/*
+	Think-Like-A-Vertex Framework, UnionFind.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	A connected components engine over the CSR arrays by
+	concurrent union-find, after Afforest (Sutton et al., 2018),
+	outside the superstep model: label propagation takes as many
+	supersteps as the diameter, resending on every changed vertex.
+
+	Each vertex starts as its own tree.  Linking the trees of an
+	edge hooks the root of greater id under the lesser by a
+	compare-and-swap, so every vertex points to a lesser or equal
+	id and each root is the least id of its component, the label
+	of the vertex engine.  Trees are flattened by pointer jumping.
+
+	Every vertex first links along only its first UF_SAMPLE_ROUNDS
+	edges, which on most graphs already joins the giant component.
+	The most frequent root of UF_SAMPLE_VERTS sampled vertices is
+	taken for it, and only the vertices outside it link along the
+	rest of their edges; since the graph is undirected, every edge
+	leaving the giant component is still linked from its far end.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef UNIONFIND_H
+#define UNIONFIND_H
+
+#include <vector>
+using std::vector;
+
+#include "Arena.h"
+
+// edges of each vertex linked before sampling
+#define UF_SAMPLE_ROUNDS 2
+
+// vertices sampled for the most frequent root
+#define UF_SAMPLE_VERTS 1024
+
+class UnionFind {
+
+	public:
+		UnionFind(int num_threads=1);
+
+		void find_components(int, const int*, const int*);
+		int* get_components();
+		int get_num_components();
+		int get_skipped_root();
+		long long get_skipped_edges();
+
+	private:
+		void run_threads( void (UnionFind::*)(int) );
+		void link(int, int);
+		void init_share(int);
+		void link_round(int);
+		void link_rest(int);
+		void compress(int);
+		int sample_root();
+
+		int num_threads;
+
+		// the graph, and the first vertex of each thread's share
+		int num_verts;
+		const int* csr1;
+		const int* csr2;
+		vector<int> part_bounds;
+
+		// the parent of each vertex, its component once flattened
+		Arena arena;
+		int* comp;
+
+		// the edge linked this round, and the root of the skipped component
+		int round;
+		int skipped_root;
+		vector<long long> part_skipped;
+		long long skipped_edges;
+
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*
+	Think-Like-A-Vertex Framework, VertexPR.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation file for vertices in the delta PageRank program.
+	Implements the virtual functions inherited by the VertexPR.h base class
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "gpregellib.h"
+#include "VertexPR.h"
+
+float VertexPR::damping = 0.85f;
+float VertexPR::tolerance = 0;
+
+VertexPR::VertexPR():VertexBase<float>() {
+	residual = 0;
+	outgoing = 0;
+}
+
+/*
+	How to update the vertex's internal value
+	based on the message received.  For delta PageRank,
+	the message is the rank its neighbors gained last
+	superstep, which is added to the residual.  Once the
+	residual passes the tolerance, a fraction of the rank, it is
+	added to the rank and passed on, which changes the value
+	and activates the vertex; smaller residuals wait for more
+*/
+void VertexPR::process_message( Message<float>* msg ) {
+
+	residual += (*msg).get_value();
+
+	if( residual > tolerance * get_value() ) {
+		set_value( get_value() + residual );
+		outgoing = get_active() ? outgoing + residual : residual;
+		residual = 0;
+	}
+
+	return;
+}
+
+/*
+	How to compute the value to send out to neighbors.
+	For PageRank, an even share of the damped rank
+	the vertex gained
+*/
+void VertexPR::send_message( Message<float>* messages_out, int num_messages, int dest_id, int ) {
+
+	Message<float> msg;
+	msg.set_dest_id(dest_id);
+	msg.set_value( damping * outgoing / get_degree() );
+	messages_out[num_messages] = msg;
+
+	return;
+}
+
+/* the rank a sending vertex passes on, totalled as the residual */
+double VertexPR::get_aggregate() { return outgoing; }
+
+/* the rank to pass on when first active */
+void VertexPR::set_outgoing(float o) { outgoing = o; }
@@ -0,0 +1,46 @@
+/*
+	Think-Like-A-Vertex Framework, VertexPR.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Header class for vertices in the delta PageRank program.
+	Inherits the virtual functions from the base class Vertex.h,
+	with float values and messages
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef VERTEXPR_H
+#define VERTEXPR_H
+
+#include "Vertex.h"
+
+class VertexPR: public VertexBase<float> {
+
+	public:
+
+		VertexPR();
+
+		// a vertex processes the sum of its messages
+		static const Combiner combiner = COMBINE_SUM;
+
+		virtual void process_message( Message<float>* );
+		virtual void send_message( Message<float>*, int, int, int );
+
+		double get_aggregate();
+		void set_outgoing(float);
+
+		/*
+			the damping factor, and the fraction of its rank
+			the residual of a vertex must pass to be sent on
+		*/
+		static float damping;
+		static float tolerance;
+
+	private:
+		float residual;
+		float outgoing;
+
+};
+
+#endif
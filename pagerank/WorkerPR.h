@@ -0,0 +1,138 @@
+/*
+	Think-Like-A-Vertex Framework, WorkerPR.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Worker class for delta PageRank
+	Inherits base Worker class functions
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef WORKERPR_H
+#define WORKERPR_H
+
+#include "Worker.h"
+#include "gpregellib.h"
+
+// defaults of the damping factor, the tolerance relative to a rank, and the residual
+#define PR_DAMPING 0.85
+#define PR_TOLERANCE 1e-3
+#define PR_RESIDUAL 1e-4
+
+template <typename T>
+class WorkerPR: public Worker<T> {
+
+	public:
+		WorkerPR(string);
+		WorkerPR(string, Options);
+		void init_args(int, ...);
+		void run();
+		void write_output(string);
+
+	private:
+		void spread_dangling();
+
+		double damping;
+		double tolerance;
+		double residual;
+
+};
+
+/* Constructor */
+template<typename T>
+WorkerPR<T>::WorkerPR(string infile):WorkerPR<T>(infile, Options()) {}
+
+/*
+	Constructor with optional arguments:
+		-damping d		the damping factor (default 0.85)
+		-tolerance t	a vertex passes on its residual once it is more
+						than t times its rank (default 0.001)
+		-residual r		halt once the rank passed on in a superstep
+						totals less than r (default 0.0001)
+*/
+template<typename T>
+WorkerPR<T>::WorkerPR(string infile, Options opts):Worker<T>(infile, opts) {
+	damping = opts.get_double("damping", PR_DAMPING);
+	tolerance = opts.get_double("tolerance", PR_TOLERANCE);
+	residual = opts.get_double("residual", PR_RESIDUAL);
+	this->set_halt_aggregate(residual);
+}
+
+/*
+	Initialize the ranks, which sum to one.  Every
+	vertex starts with the teleport share (1-d)/n,
+	and is active to pass it on to its neighbors
+*/
+template<typename T>
+void WorkerPR<T>::init_args(int, ...) {
+
+	T* vert_cont = this->get_vert_cont();
+	int num_verts = this->get_num_verts();
+	float base = (float)( (1 - damping) / num_verts );
+
+	T::damping = (float)damping;
+	T::tolerance = (float)tolerance;
+
+	T* vert;
+	for(int i=0; i<num_verts; i++) {
+		vert = &vert_cont[i];
+		vert->set_value(base);
+		vert->set_outgoing(base);
+		vert->set_active(true);
+	}
+	this->set_vert_cont(vert_cont);
+
+	return;
+}
+
+/*
+	Run until the ranks settle, then spread the damped rank of
+	the vertices without neighbors, which has nowhere to go,
+	evenly over every vertex, as PageRank does.  Residuals still
+	held back at the halt stay out of the ranks
+*/
+template<typename T>
+void WorkerPR<T>::run() {
+
+	Worker<T>::run();
+	spread_dangling();
+}
+
+/*
+	spread the rank of the dangling vertices, as if sent evenly to
+	every vertex and passed on from there until it settles.  Sent
+	evenly, it joins the teleport share, so every rank grows by the
+	same factor c, which must cover the larger dangling rank too:
+	c (1-d) = (1-d) + d c D for the dangling rank D, so
+	c = (1-d) / (1-d - d D)
+*/
+template<typename T>
+void WorkerPR<T>::spread_dangling() {
+
+	T* vert_cont = this->get_vert_cont();
+	int num_verts = this->get_num_verts();
+
+	double dangling = 0;
+	for(int i=0; i<num_verts; i++)
+		if( vert_cont[i].get_degree() == 0 )
+			dangling += vert_cont[i].get_value();
+	double kept = ( 1 - damping ) - damping * dangling;
+	if( dangling == 0 || kept <= 0 ) return;
+
+	float c = (float)( ( 1 - damping ) / kept );
+	for(int i=0; i<num_verts; i++)
+		vert_cont[i].set_value( vert_cont[i].get_value() * c );
+
+	return;
+}
+
+/*
+	write to a file each node and its rank
+*/
+template<typename T>
+void WorkerPR<T>::write_output(string outfile) {
+	this->write_values(outfile, "v_id\trank", NULL);
+}
+
+#endif
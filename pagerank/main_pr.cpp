@@ -0,0 +1,50 @@
+/*
+	Think-Like-A-Vertex Framework, main_pr.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Driver program for vertex-centric delta PageRank
+	
+	Takes in an edgelist and outputs the PageRank
+	of each vertex.  Only the vertices whose rank
+	changed by more than a tolerance pass the change on,
+	so the vertices go quiet as their ranks settle.
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "gpregellib.h"
+#include "WorkerPR.h"
+#include "VertexPR.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+
+	//arguments include edgelist in and the string of the file to be outputted
+	if( argc < 3 ) {
+		printf("usage: ./tlav_pr  edgelist_in  outfile  [-damping d] [-tolerance t] [-residual r] [-threads n] [-numa]\n");
+		return -1;
+	}
+
+	string graphfile = argv[1];
+	string outfile = argv[2];
+	Options opts(argc, argv, 3);
+	opts.set("program", "pagerank");
+
+	printf("Loading graph %s\n", argv[1]);
+	
+	// initialize the graph structure in the worker
+	WorkerPR<VertexPR> worker(graphfile, opts);
+	
+	// no input arguments required
+	int n_args = 0;
+
+	worker.init_args(n_args);
+	worker.run();
+	worker.write_output(outfile);
+
+	printf("Complete\n");
+
+	return 0;
+}
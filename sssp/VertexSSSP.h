@@ -19,6 +19,9 @@ class VertexSSSP: public Vertex {
 
 		VertexSSSP();
 		
+		// keeps the least value, sends its value plus the edge weight
+		static const PullSemantics pull_semantics = PULL_MIN_PLUS_WEIGHT;
+
 		virtual void process_message( Message<int>* );
 		virtual void send_message( Message<int>*, int, int, int );
 
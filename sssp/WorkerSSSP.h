@@ -19,6 +19,7 @@ class WorkerSSSP: public Worker<T> {
 
 	public:
 		WorkerSSSP(string);
+		WorkerSSSP(string, Options);
 		void init_args(int, ...);
 		void write_output(string);
 
@@ -28,6 +29,10 @@ class WorkerSSSP: public Worker<T> {
 template<typename T>
 WorkerSSSP<T>::WorkerSSSP(string infile):Worker<T>(infile) {}
 
+/* Constructor with optional arguments */
+template<typename T>
+WorkerSSSP<T>::WorkerSSSP(string infile, Options opts):Worker<T>(infile, opts) {}
+
 /*
 	Initialization for SSSP Workers
 	source vertex provided as input,
@@ -46,6 +51,7 @@ void WorkerSSSP<T>::init_args(int num_args, ...) {
 		cout << "error: src out of range" << endl;
 		exit(-1);
 	}
+	this->set_cache_key( "src=" + to_string(src) );
 
 	T* vert_cont = this->get_vert_cont();
 	int num_verts = this->get_num_verts();
@@ -72,31 +78,7 @@ void WorkerSSSP<T>::init_args(int num_args, ...) {
 */
 template<typename T>
 void WorkerSSSP<T>::write_output(string outfile) {
-
-	ofstream outstream;
-	outstream.open( outfile.c_str() );
-
-	T vert, *vert_cont;
-	int value, id;
-	outstream << "v_id\tdist" << endl;
-	for(int i=0; i<this->get_num_verts(); i++) {
-		
-		vert_cont = this->get_vert_cont();
-		vert = vert_cont[i];
-		value = vert.get_value();
-		id = vert.get_id();
-		if( value == INT_MAX ) {
-			outstream << id << "\t" << "inf" << endl;
-		}	else {	
-			outstream << id << "\t" << value << endl;
-		}
-
-	}
-
-	outstream.close();
-
-	return;
-
+	this->write_values(outfile, "v_id\tdist", "inf");
 }
 
 #endif
@@ -6,7 +6,10 @@
 	Utilizes SSPS worker and vertex classes
 	
 	Input a weighted edgelist and source vertex, and output the 
-	distance of each vertex from the source
+	distance of each vertex from the source.  With -target t,
+	only the distance from the source to t is found, by a query
+	of the contraction hierarchy stored next to the graph file,
+	or with -landmarks k by A* over a landmark index
 
 	This software is distributed under 
 	the modified Berkeley Software Distribution (BSD) License.
@@ -15,26 +18,302 @@
 #include "gpregellib.h"
 #include "WorkerSSSP.h"
 #include "VertexSSSP.h"
+#include "ContractionHierarchy.h"
+#include "LandmarkIndex.h"
 
 using namespace std;
 
+/*
+	the distance from src to the target by a contraction
+	hierarchy query, written as the dist of the target, or with
+	-path the dist of every vertex on a shortest path in order.
+	The hierarchy is read from the graph file's name with .ch
+	added, and built and stored there first if it is missing
+	or was built from another graph, told by the hash of the
+	loaded CSR arrays
+*/
+int run_point_to_point(string graphfile, int src, string outfile, Options& opts) {
+
+	Metrics metrics;
+	metrics.set_program("sssp");
+
+	struct stat info;
+	if( stat( graphfile.c_str(), &info ) != 0 ) {
+		cout << "error: cannot open " << graphfile << endl;
+		return -1;
+	}
+	string chfile = graphfile + ".ch";
+
+	double start = Metrics::now();
+	Graph g;
+	g.set_reader( opts.get_string("reader", "auto") );
+	g.init_from_edgelist(graphfile);
+	printf("loaded %d nodes and %d edges\n", g.get_num_verts(), g.get_num_dir_edges());
+	uint64_t graph_hash = ResultCache::hash_csr( g.get_num_verts(), g.get_csr1(), g.get_csr2(), g.get_weights() );
+	ContractionHierarchy ch;
+	if( !ch.load( chfile, graph_hash ) ) {
+		double build_start = Metrics::now();
+		ch.build( g.get_num_verts(), g.get_csr1(), g.get_csr2(), g.get_weights() );
+		printf("built contraction hierarchy in %.3f s, %lld upward edges, %lld shortcuts, %d core vertices\n",
+			Metrics::now() - build_start, ch.get_num_arcs(), ch.get_num_shortcuts(), ch.get_num_core() );
+		if( !ch.save( chfile, graph_hash ) )
+			cout << "error: could not write " << chfile << endl;
+	}
+	metrics.set_load_time( Metrics::now() - start );
+	metrics.set_graph( ch.get_num_verts(), 0 );
+
+	int num_verts = ch.get_num_verts();
+	int dst = opts.get_int("target", -1);
+	if( src < 0 || src >= num_verts || dst < 0 || dst >= num_verts ) {
+		cout << "error: src or target out of range" << endl;
+		return -1;
+	}
+
+	start = Metrics::now();
+	int dist = ch.query(src, dst);
+	metrics.set_run_time( Metrics::now() - start );
+	metrics.add_field( "dist", dist );
+	metrics.add_field( "settled", ch.get_settled() );
+
+	if( dist < 0 ) printf("dist: inf\n");
+	else printf("dist: %d\n", dist);
+	if( !opts.has("quiet") )
+		printf("load %.3f s, query %.1f us, %d vertices settled\n", metrics.get_load_time(),
+			metrics.get_run_time() * 1e6, ch.get_settled() );
+	if( opts.has("metrics") )
+		metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
+
+	vector<int> path, dists;
+	if( opts.has("path") ) {
+		ch.get_path(path, dists);
+	} else if( dist >= 0 ) {
+		path.push_back(dst);
+		dists.push_back(dist);
+	}
+
+	BufferedWriter out;
+	if( !out.open(outfile, false) ) {
+		cout << "error: could not write output to " << outfile << endl;
+		return -1;
+	}
+	out.put_str("v_id\tdist\n");
+	for(size_t i=0; i<path.size(); i++) {
+		out.put_int( path[i] );
+		out.put('\t');
+		out.put_int( dists[i] );
+		out.put('\n');
+	}
+	if( dist < 0 ) {
+		out.put_int(dst);
+		out.put_str("\tinf\n");
+	}
+	out.close();
+
+	cout << "sssp execution complete" << endl;
+
+	return 0;
+}
+
+/*
+	the distance from src to the target by the landmark index
+	read from the graph file's name with .alt added, built and
+	stored there first by a Worker run from each landmark if it
+	is missing, has other landmarks or was built from another
+	graph, told by the hash of the loaded CSR arrays.  With
+	-estimate only the bounds the index gives are written;
+	otherwise the exact distance, found by A*, as for the
+	contraction hierarchy
+*/
+int run_landmarks(string graphfile, int src, string outfile, Options& opts) {
+
+	Metrics metrics;
+	metrics.set_program("sssp");
+
+	struct stat info;
+	if( stat( graphfile.c_str(), &info ) != 0 ) {
+		cout << "error: cannot open " << graphfile << endl;
+		return -1;
+	}
+	int k = opts.get_int("landmarks", 16);
+	if( k < 1 || k > ALT_MAX_LANDMARKS ) {
+		printf("error: -landmarks must be from 1 to %d\n", ALT_MAX_LANDMARKS);
+		return -1;
+	}
+	string sel = opts.get_string("select", "farthest");
+	if( sel != "degree" && sel != "farthest" ) {
+		printf("error: unknown landmark selection %s, use degree or farthest\n", sel.c_str() );
+		return -1;
+	}
+	LandmarkSelect select = ( sel == "degree" ) ? SELECT_DEGREE : SELECT_FARTHEST;
+	string altfile = graphfile + ".alt";
+	bool estimate = opts.has("estimate");
+
+	// only a stored index needs the graph alone, to check its hash;
+	// otherwise the worker building the index loads it once
+	double start = Metrics::now();
+	LandmarkIndex index;
+	WorkerSSSP<VertexSSSP>* worker = NULL;
+	Graph* g = NULL;
+	bool stored = false;
+	if( stat( altfile.c_str(), &info ) == 0 ) {
+		g = new Graph;
+		g->set_reader( opts.get_string("reader", "auto") );
+		g->init_from_edgelist(graphfile);
+		uint64_t graph_hash = ResultCache::hash_csr( g->get_num_verts(), g->get_csr1(), g->get_csr2(), g->get_weights() );
+		stored = index.load( altfile, graph_hash )
+			&& index.get_select() == select
+			&& ( index.get_num_landmarks() == k || index.get_num_landmarks() == index.get_num_verts() );
+		if( !stored ) {
+			delete g;
+			g = NULL;
+		}
+	}
+	if( !stored ) {
+		worker = new WorkerSSSP<VertexSSSP>(graphfile, opts);
+		Graph& wg = worker->get_graph();
+		int n = wg.get_num_verts();
+		uint64_t graph_hash = ResultCache::hash_csr( n, wg.get_csr1(), wg.get_csr2(), wg.get_weights() );
+		vector<int> values(n);
+		double build_start = Metrics::now();
+		index.init(n, k, select);
+		for(int i=0; i<k; i++) {
+			int l = index.next_landmark( wg.get_csr1() );
+			if( l < 0 ) break;
+			worker->init_args(1, l);
+			worker->run();
+			worker->get_values( &values[0] );
+			index.add_distances( l, &values[0] );
+		}
+		index.finish();
+		printf("built %d landmarks in %.3f s, %d-bit distances\n",
+			index.get_num_landmarks(), Metrics::now() - build_start, index.get_width() );
+		if( !index.save( altfile, graph_hash ) )
+			cout << "error: could not write " << altfile << endl;
+	}
+	Graph& graph = worker ? worker->get_graph() : *g;
+	metrics.set_load_time( Metrics::now() - start );
+	metrics.set_graph( index.get_num_verts(), 0 );
+
+	int num_verts = index.get_num_verts();
+	int dst = opts.get_int("target", -1);
+	if( src < 0 || src >= num_verts || dst < 0 || dst >= num_verts ) {
+		cout << "error: src or target out of range" << endl;
+		delete worker;
+		delete g;
+		return -1;
+	}
+
+	BufferedWriter out;
+	if( estimate ) {
+		start = Metrics::now();
+		int lower = index.lower_bound(src, dst);
+		int upper = index.upper_bound(src, dst);
+		metrics.set_run_time( Metrics::now() - start );
+		metrics.add_field( "lower", lower == INT_MAX ? -1 : lower );
+		metrics.add_field( "upper", upper == INT_MAX ? -1 : upper );
+
+		if( lower == INT_MAX ) printf("lower: inf, upper: inf\n");
+		else if( upper == INT_MAX ) printf("lower: %d, upper: inf\n", lower);
+		else printf("lower: %d, upper: %d\n", lower, upper);
+		if( !opts.has("quiet") )
+			printf("load %.3f s, estimate %.2f us\n", metrics.get_load_time(), metrics.get_run_time() * 1e6 );
+		if( opts.has("metrics") )
+			metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
+
+		if( !out.open(outfile, false) ) {
+			cout << "error: could not write output to " << outfile << endl;
+			delete worker;
+			delete g;
+			return -1;
+		}
+		out.put_str("v_id\tlower\tupper\n");
+		out.put_int(dst);
+		int bounds[2] = { lower, upper };
+		for(int b=0; b<2; b++) {
+			out.put('\t');
+			if( bounds[b] == INT_MAX ) out.put_str("inf");
+			else out.put_int( bounds[b] );
+		}
+		out.put('\n');
+		out.close();
+		delete worker;
+		delete g;
+		cout << "sssp execution complete" << endl;
+		return 0;
+	}
+
+	start = Metrics::now();
+	int dist = index.query( src, dst, graph.get_csr1(), graph.get_csr2(), graph.get_weights() );
+	metrics.set_run_time( Metrics::now() - start );
+	metrics.add_field( "dist", dist );
+	metrics.add_field( "settled", index.get_settled() );
+
+	if( dist < 0 ) printf("dist: inf\n");
+	else printf("dist: %d\n", dist);
+	if( !opts.has("quiet") )
+		printf("load %.3f s, query %.1f us, %d vertices settled\n", metrics.get_load_time(),
+			metrics.get_run_time() * 1e6, index.get_settled() );
+	if( opts.has("metrics") )
+		metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
+
+	vector<int> path, dists;
+	if( opts.has("path") ) {
+		index.get_path(path, dists);
+	} else if( dist >= 0 ) {
+		path.push_back(dst);
+		dists.push_back(dist);
+	}
+
+	if( !out.open(outfile, false) ) {
+		cout << "error: could not write output to " << outfile << endl;
+		delete worker;
+		delete g;
+		return -1;
+	}
+	out.put_str("v_id\tdist\n");
+	for(size_t i=0; i<path.size(); i++) {
+		out.put_int( path[i] );
+		out.put('\t');
+		out.put_int( dists[i] );
+		out.put('\n');
+	}
+	if( dist < 0 ) {
+		out.put_int(dst);
+		out.put_str("\tinf\n");
+	}
+	out.close();
+	delete worker;
+	delete g;
+
+	cout << "sssp execution complete" << endl;
+
+	return 0;
+}
+
 int main(int argc, char* argv[]) {
 
 	// arguments include an input and output file, along with a source vertex
-	if( argc != 4 ) {
-		printf("usage: ./pregel_sssp edgelist_in  src  outfile\n");
+	if( argc < 4 ) {
+		printf("usage: ./pregel_sssp edgelist_in  src  outfile  [-threads n] [-numa] [-target t [-path] [-landmarks k [-select degree|farthest] [-estimate]]]\n");
 		return -1;
 	}
 
 	string graphfile = argv[1];
 	int src = atoi(argv[2]);
 	string outfile = argv[3];
+	Options opts(argc, argv, 4);
+	opts.set("program", "sssp");
 
 	printf("Hello World\n");
 	printf("Loading graph %s\n", argv[1]);
+
+	if( opts.has("target") && opts.has("landmarks") )
+		return run_landmarks(graphfile, src, outfile, opts);
+	if( opts.has("target") )
+		return run_point_to_point(graphfile, src, outfile, opts);
 	
 	// initialize the worker with a graph
-	WorkerSSSP<VertexSSSP> worker(graphfile);
+	WorkerSSSP<VertexSSSP> worker(graphfile, opts);
 
 	// only argument required by worker is the source vert
 	int n_args = 1;
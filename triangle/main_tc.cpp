@@ -0,0 +1,94 @@
+/*
+	Think-Like-A-Vertex Framework, main_tc.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Driver program for triangle counting.
+	Utilizes the triangle counting engine over the graph's CSR
+	arrays, rather than a Worker, since a vertex-centric program
+	would message every neighbor's neighbors
+
+	Input an edgelist, and output the number of triangles
+	of every vertex, or with -clustering its local clustering
+	coefficient, and print the total
+
+	This software is distributed under 
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include "gpregellib.h"
+#include "TriangleCounter.h"
+
+using namespace std;
+
+/*
+	main driver program
+*/
+int main(int argc, char* argv[]) {
+
+	//inputs
+	if( argc < 3 ) {
+		printf("usage: ./tlav_tc  edgelist_in  outfile  [-threads n] [-simd isa] [-clustering]\n");
+		return -1;
+	}
+
+	// arguments to variables
+	string graphfile = argv[1];
+	string outfile = argv[2];
+	Options opts(argc, argv, 3);
+
+	Metrics metrics;
+	metrics.set_program("tc");
+
+	printf("Loading graph %s\n", argv[1]);
+
+	double start = Metrics::now();
+	Graph g;
+	g.set_reader( opts.get_string("reader", "auto") );
+	g.init_from_edgelist(graphfile);
+	int num_verts = g.get_num_verts();
+	metrics.set_load_time( Metrics::now() - start );
+	metrics.set_graph( num_verts, g.get_num_dir_edges() );
+	printf("loaded %d nodes and %d edges\n", num_verts, g.get_num_dir_edges());
+
+	int threads = opts.get_int("threads", 1);
+	TriangleCounter counter(threads);
+	if( opts.has("simd") && !counter.select( opts.get_string("simd", "auto") ) ) {
+		printf("error: the cpu cannot run %s intersection kernels\n", opts.get_string("simd", "auto").c_str() );
+		return -1;
+	}
+	metrics.set_threads( threads );
+
+	start = Metrics::now();
+	counter.count( num_verts, g.get_csr1(), g.get_csr2() );
+	metrics.set_run_time( Metrics::now() - start );
+	metrics.add_field( "triangles", counter.get_total() );
+
+	printf("triangles: %lld\n", counter.get_total());
+	if( !opts.has("quiet") )
+		printf("load %.3f s, count %.3f s, %lld oriented edges, %s kernels\n", metrics.get_load_time(),
+			metrics.get_run_time(), counter.get_oriented_edges(), counter.get_kernel_name().c_str() );
+	if( opts.has("metrics") )
+		metrics.write( opts.get_string("metrics", ""), opts.get_string("metricsformat", "jsonl") );
+
+	// each vertex's triangles, or the fraction of its neighbor pairs they close
+	ResultWriter writer(threads);
+	string format = opts.get_string("outformat", "text");
+	bool ok;
+	if( opts.has("clustering") ) {
+		vector<float> coeff(num_verts);
+		long long* counts = counter.get_counts();
+		for(int v=0; v<num_verts; v++) {
+			long long d = g.get_degree(v);
+			coeff[v] = ( d < 2 ) ? 0 : (float)( 2.0 * counts[v] / ( d * (d-1) ) );
+		}
+		ok = writer.write(outfile, format, "v_id\tclustering", &coeff[0], num_verts, NULL);
+	} else {
+		ok = writer.write(outfile, format, "v_id\ttriangles", counter.get_counts(), num_verts, NULL);
+	}
+	if( !ok )
+		cout << "error: could not write output to " << outfile << endl;
+
+	printf("Complete\n");
+
+	return 0;
+}
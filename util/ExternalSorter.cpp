@@ -0,0 +1,337 @@
+/*
+	Think-Like-A-Vertex Framework, ExternalSorter.cpp
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Implementation of the spill files and the external sorter
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ExternalSorter.h"
+#include "ParallelSort.h"
+
+using namespace std;
+
+// largest buffer of a run being written
+#define SPILL_BUFFER (4<<20)
+
+// smallest read buffer of a run being merged
+#define MIN_MERGE_BUFFER (64<<10)
+
+// most runs merged at once, more are merged in groups first
+#define MAX_FAN_IN 256
+
+/* Constructor, not yet created */
+SpillFile::SpillFile() {
+	fd = -1;
+	writing = true;
+	pos = 0;
+	len = 0;
+	size = 0;
+}
+
+/* Destructor, the file was already unlinked */
+SpillFile::~SpillFile() {
+	if( fd >= 0 ) close(fd);
+}
+
+/*
+	create the file, unlinking it at once,
+	and buffer writes in buffer_bytes
+*/
+bool SpillFile::create(string path, size_t buffer_bytes) {
+	fd = open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600 );
+	if( fd < 0 ) {
+		cout << "error: cannot create temporary file " << path << ": " << strerror(errno) << endl;
+		return false;
+	}
+	unlink( path.c_str() );
+	buf.resize( max( buffer_bytes / 16, (size_t)1 ) * 2 );
+	pos = 0;
+	size = 0;
+	return true;
+}
+
+/* append a record */
+void SpillFile::write(uint64_t key, uint64_t val) {
+	buf[pos++] = key;
+	buf[pos++] = val;
+	size++;
+	if( pos == buf.size() ) flush();
+}
+
+/*
+	write out the buffer, exiting if the disk is full,
+	since the preprocessing cannot go on without it
+*/
+void SpillFile::flush() {
+	const char* p = (const char*)&buf[0];
+	size_t n = pos * sizeof(uint64_t);
+	while( n > 0 ) {
+		ssize_t w = ::write(fd, p, n);
+		if( w < 0 && errno == EINTR ) continue;
+		if( w <= 0 ) {
+			cout << "error: writing temporary file: " << strerror(errno) << endl;
+			exit(-1);
+		}
+		p += w;
+		n -= w;
+	}
+	pos = 0;
+}
+
+/*
+	finish writing, releasing the buffer until reading
+*/
+void SpillFile::end_write() {
+	if( writing ) flush();
+	writing = false;
+	vector<uint64_t>().swap(buf);
+}
+
+/*
+	finish writing and start reading from the first record,
+	buffering reads in buffer_bytes
+*/
+void SpillFile::rewind(size_t buffer_bytes) {
+	if( writing ) flush();
+	writing = false;
+	lseek(fd, 0, SEEK_SET);
+	vector<uint64_t>( max( buffer_bytes / 16, (size_t)1 ) * 2 ).swap(buf);
+	pos = 0;
+	len = 0;
+}
+
+/* refill the buffer from the file */
+void SpillFile::fill() {
+	char* p = (char*)&buf[0];
+	size_t want = buf.size() * sizeof(uint64_t), got = 0;
+	while( got < want ) {
+		ssize_t r = ::read(fd, p + got, want - got);
+		if( r < 0 && errno == EINTR ) continue;
+		if( r < 0 ) {
+			cout << "error: reading temporary file: " << strerror(errno) << endl;
+			exit(-1);
+		}
+		if( r == 0 ) break;
+		got += r;
+	}
+	pos = 0;
+	len = got / sizeof(uint64_t);
+}
+
+/* read the next record, false at the end */
+bool SpillFile::read(uint64_t& key, uint64_t& val) {
+	if( pos + 2 > len ) {
+		fill();
+		if( len < 2 ) return false;
+	}
+	key = buf[pos++];
+	val = buf[pos++];
+	return true;
+}
+
+/* the number of records written */
+uint64_t SpillFile::get_size() {
+	return size;
+}
+
+/*
+	Constructor, spilling runs to files named prefix.N,
+	within a memory budget in bytes
+*/
+ExternalSorter::ExternalSorter(string _prefix, size_t _budget, int _num_threads, bool _unique) {
+	prefix = _prefix;
+	budget = _budget;
+	num_threads = _num_threads;
+	unique = _unique;
+
+	// the keys and values, and as much again to radix sort them
+	capacity = max( budget / (4 * sizeof(uint64_t)), (size_t)4096 );
+	mem_pos = 0;
+	next_file = 0;
+	has_last = false;
+	last_key = 0;
+}
+
+/* Destructor */
+ExternalSorter::~ExternalSorter() {
+	for(size_t r=0; r<runs.size(); r++)
+		delete runs[r];
+}
+
+/* add a record, spilling a run if the buffer is full */
+void ExternalSorter::add(uint64_t key, uint64_t val) {
+	// grow the buffer by doubling, but never past the budget
+	if( keys.size() == keys.capacity() ) {
+		size_t grown = min( max( 2 * keys.size(), (size_t)4096 ), capacity );
+		keys.reserve(grown);
+		vals.reserve(grown);
+	}
+	keys.push_back(key);
+	vals.push_back(val);
+	if( keys.size() >= capacity ) spill();
+}
+
+/*
+	sort the buffered records and write them out as a run,
+	keeping only the first of equal keys if unique
+*/
+void ExternalSorter::spill() {
+
+	radix_sort<uint64_t>(keys, &vals, num_threads);
+
+	SpillFile* run = new SpillFile();
+	if( !run->create( prefix + "." + to_string(next_file++), min( budget / 8, (size_t)SPILL_BUFFER ) ) ) exit(-1);
+	for(size_t i=0; i<keys.size(); i++) {
+		if( unique && i > 0 && keys[i] == keys[i-1] ) continue;
+		run->write( keys[i], vals[i] );
+	}
+	run->end_write();
+	runs.push_back(run);
+
+	keys.clear();
+	vals.clear();
+}
+
+/*
+	done adding: sort in memory if nothing was spilled,
+	else spill the rest and merge down to at most MAX_FAN_IN
+	runs, so the final merge can start
+*/
+void ExternalSorter::finish() {
+
+	if( runs.empty() ) {
+		radix_sort<uint64_t>(keys, &vals, num_threads);
+		mem_pos = 0;
+		return;
+	}
+
+	if( !keys.empty() ) spill();
+	vector<uint64_t>().swap(keys);
+	vector<uint64_t>().swap(vals);
+
+	// the merged group replaces the oldest runs, keeping equal keys in order
+	while( runs.size() > MAX_FAN_IN ) {
+		SpillFile* merged = new SpillFile();
+		if( !merged->create( prefix + "." + to_string(next_file++), min( budget / 8, (size_t)SPILL_BUFFER ) ) ) exit(-1);
+		merge_runs(MAX_FAN_IN, merged);
+		merged->end_write();
+		runs.insert(runs.begin(), merged);
+	}
+
+	start_merge( runs.size() );
+}
+
+/*
+	merge the first k runs into out, then drop them
+*/
+void ExternalSorter::merge_runs(int k, SpillFile* out) {
+	uint64_t key, val;
+	start_merge(k);
+	while( next_merged(key, val) )
+		out->write(key, val);
+	for(int r=0; r<k; r++)
+		delete runs[r];
+	runs.erase(runs.begin(), runs.begin() + k);
+}
+
+/*
+	start merging the first k runs, splitting
+	half the budget among their read buffers
+*/
+void ExternalSorter::start_merge(int k) {
+	size_t buffer = max( budget / (2 * k), (size_t)MIN_MERGE_BUFFER );
+	heap.clear();
+	has_last = false;
+	for(int r=0; r<k; r++) {
+		runs[r]->rewind(buffer);
+		push_head(r);
+	}
+}
+
+/* whether head a comes after head b, equal keys in run order */
+bool ExternalSorter::head_after(const Head& a, const Head& b) {
+	return a.key > b.key || ( a.key == b.key && a.run > b.run );
+}
+
+/* put the next record of a run on the heap */
+void ExternalSorter::push_head(int r) {
+	Head h;
+	if( !runs[r]->read(h.key, h.val) ) return;
+	h.run = r;
+	heap.push_back(h);
+	push_heap(heap.begin(), heap.end(), head_after);
+}
+
+/* take the smallest record off the heap */
+bool ExternalSorter::pop_head(uint64_t& key, uint64_t& val) {
+	if( heap.empty() ) return false;
+	pop_heap(heap.begin(), heap.end(), head_after);
+	Head h = heap.back();
+	heap.pop_back();
+	key = h.key;
+	val = h.val;
+	push_head(h.run);
+	return true;
+}
+
+/* the next record of the merge, skipping equal keys if unique */
+bool ExternalSorter::next_merged(uint64_t& key, uint64_t& val) {
+	while( pop_head(key, val) ) {
+		if( unique && has_last && key == last_key ) continue;
+		has_last = true;
+		last_key = key;
+		return true;
+	}
+	return false;
+}
+
+/*
+	the next record in sorted order, false at the end.
+	Only valid after finish().
+*/
+bool ExternalSorter::next(uint64_t& key, uint64_t& val) {
+
+	if( !runs.empty() ) {
+		if( next_merged(key, val) ) return true;
+		release();
+		return false;
+	}
+
+	while( mem_pos < keys.size() ) {
+		key = keys[mem_pos];
+		val = vals[mem_pos];
+		mem_pos++;
+		if( unique && has_last && key == last_key ) continue;
+		has_last = true;
+		last_key = key;
+		return true;
+	}
+	release();
+	return false;
+}
+
+/* free the records and runs once they have all been read */
+void ExternalSorter::release() {
+	for(size_t r=0; r<runs.size(); r++)
+		delete runs[r];
+	runs.clear();
+	vector<uint64_t>().swap(keys);
+	vector<uint64_t>().swap(vals);
+	mem_pos = 0;
+}
+
+/* the number of runs spilled to disk */
+int ExternalSorter::get_num_runs() {
+	return next_file;
+}
@@ -0,0 +1,107 @@
+/*
+	Think-Like-A-Vertex Framework, ExternalSorter.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Sorting of more (key, value) records than fit in memory,
+	for preprocessing edgelists larger than RAM.
+
+	A SpillFile is a temporary file of records written and
+	then read back in order, through a buffer.
+
+	An ExternalSorter collects records into a buffer of at most
+	its memory budget.  Each full buffer is radix sorted and
+	spilled to a SpillFile as a sorted run, then the runs are
+	merged by a k-way merge as the records are read back.
+	Records with equal keys come back in the order they were
+	added, and with unique set, only the first of them does.
+	If every record fits in the budget nothing is spilled.
+
+	Temporary files are unlinked as soon as they are created,
+	so they never outlive the program.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef EXTERNALSORTER_H
+#define EXTERNALSORTER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+using std::string;
+using std::vector;
+
+class SpillFile {
+
+	public:
+		SpillFile();
+		~SpillFile();
+		bool create(string, size_t);
+		void write(uint64_t, uint64_t);
+		void end_write();
+		void rewind(size_t);
+		bool read(uint64_t&, uint64_t&);
+		uint64_t get_size();
+
+	private:
+		void flush();
+		void fill();
+
+		int fd;
+		bool writing;
+		vector<uint64_t> buf;
+		size_t pos;
+		size_t len;
+		uint64_t size;
+
+};
+
+class ExternalSorter {
+
+	public:
+		ExternalSorter(string, size_t, int, bool unique=false);
+		~ExternalSorter();
+		void add(uint64_t, uint64_t);
+		void finish();
+		bool next(uint64_t&, uint64_t&);
+		int get_num_runs();
+
+	private:
+		struct Head {
+			uint64_t key;
+			uint64_t val;
+			int run;
+		};
+
+		void spill();
+		void release();
+		void merge_runs(int, SpillFile*);
+		void start_merge(int);
+		bool next_merged(uint64_t&, uint64_t&);
+		bool pop_head(uint64_t&, uint64_t&);
+		void push_head(int);
+		static bool head_after(const Head&, const Head&);
+
+		string prefix;
+		size_t budget;
+		int num_threads;
+		bool unique;
+
+		// records not yet spilled
+		vector<uint64_t> keys;
+		vector<uint64_t> vals;
+		size_t capacity;
+		size_t mem_pos;
+
+		// spilled runs, and the merge heap over them
+		vector<SpillFile*> runs;
+		vector<Head> heap;
+		int next_file;
+
+		bool has_last;
+		uint64_t last_key;
+
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*
+	Think-Like-A-Vertex Framework, ParallelSort.h
+	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
+
+	Parallel helpers for the edgelist preprocessing:
+	running a function on several threads, and a parallel
+	radix sort of 64-bit keys with optional values.
+
+	This software is distributed under
+	the modified Berkeley Software Distribution (BSD) License.
+*/
+
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+/* the first index of part t of n split into num_parts */
+inline size_t part_begin(size_t n, int t, int num_parts) {
+	return (size_t)( (unsigned long long)n * t / num_parts );
+}
+
+/*
+	run fn(t, num_threads, arg) on num_threads threads,
+	inline when there is only one
+*/
+inline void parallel_for(int num_threads, void (*fn)(int, int, void*), void* arg) {
+
+	if( num_threads == 1 ) {
+		fn(0, 1, arg);
+		return;
+	}
+	std::vector<std::thread> pool;
+	for(int t=0; t<num_threads; t++)
+		pool.push_back( std::thread(fn, t, num_threads, arg) );
+	for(int t=0; t<num_threads; t++)
+		pool[t].join();
+}
+
+/* one pass of a radix sort, by the byte at shift */
+template<typename V>
+struct RadixJob {
+	uint64_t* src;
+	uint64_t* dst;
+	V* src_vals;
+	V* dst_vals;
+	size_t n;
+	int shift;
+	std::vector<size_t> hist;
+};
+
+template<typename V>
+void radix_histogram(int t, int num_threads, void* arg) {
+	RadixJob<V>* job = (RadixJob<V>*)arg;
+	size_t* hist = &job->hist[t*256];
+	for(int d=0; d<256; d++) hist[d] = 0;
+	size_t end = part_begin(job->n, t+1, num_threads);
+	for(size_t i=part_begin(job->n, t, num_threads); i<end; i++)
+		hist[ (job->src[i] >> job->shift) & 0xff ]++;
+}
+
+template<typename V>
+void radix_scatter(int t, int num_threads, void* arg) {
+	RadixJob<V>* job = (RadixJob<V>*)arg;
+	size_t* pos = &job->hist[t*256];
+	size_t end = part_begin(job->n, t+1, num_threads);
+	for(size_t i=part_begin(job->n, t, num_threads); i<end; i++) {
+		size_t j = pos[ (job->src[i] >> job->shift) & 0xff ]++;
+		job->dst[j] = job->src[i];
+		if( job->src_vals != NULL ) job->dst_vals[j] = job->src_vals[i];
+	}
+}
+
+/*
+	stable parallel LSD radix sort of the keys, a byte at a time,
+	moving the values (if any) along with their keys.  Bytes that
+	are the same in every key are skipped.
+*/
+template<typename V>
+void radix_sort(std::vector<uint64_t>& keys, std::vector<V>* vals, int num_threads) {
+
+	RadixJob<V> job;
+	job.n = keys.size();
+	if( job.n < 2 ) return;
+	if( job.n < (size_t)num_threads * 4096 ) num_threads = 1;
+
+	std::vector<uint64_t> tmp(job.n);
+	std::vector<V> tmp_vals( vals != NULL ? job.n : 0 );
+	job.src = &keys[0];
+	job.dst = &tmp[0];
+	job.src_vals = ( vals != NULL ) ? &(*vals)[0] : NULL;
+	job.dst_vals = ( vals != NULL ) ? &tmp_vals[0] : NULL;
+	job.hist.resize(256 * num_threads);
+
+	for(job.shift=0; job.shift<64; job.shift+=8) {
+
+		parallel_for(num_threads, radix_histogram<V>, &job);
+
+		// skip the pass if every key has the same byte
+		bool trivial = false;
+		for(int d=0; d<256 && !trivial; d++) {
+			size_t total = 0;
+			for(int t=0; t<num_threads; t++) total += job.hist[t*256+d];
+			if( total == job.n ) trivial = true;
+			else if( total > 0 ) break;
+		}
+		if( trivial ) continue;
+
+		// each thread's first position for each byte
+		size_t pos = 0;
+		for(int d=0; d<256; d++) {
+			for(int t=0; t<num_threads; t++) {
+				size_t c = job.hist[t*256+d];
+				job.hist[t*256+d] = pos;
+				pos += c;
+			}
+		}
+
+		parallel_for(num_threads, radix_scatter<V>, &job);
+		std::swap(job.src, job.dst);
+		std::swap(job.src_vals, job.dst_vals);
+	}
+
+	if( job.src != &keys[0] ) {
+		keys.swap(tmp);
+		if( vals != NULL ) vals->swap(tmp_vals);
+	}
+}
+
+#endif
@@ -1,63 +1,113 @@
 /*
 	Think-Like-A-Vertex Framework, edgelist_preprocessing.cpp
 	Copyright 2024, Ryan McCune	<robertryanmccune@gmail.com>
-	
+
 	Processes edgelists for use in the TLAV system.
-	
+
 	Example edgeslists can be those generated by the SNAP package.
 	This program processes these edgeslists to work
 	with the TLAV system.
-	
-	Edgelists from generators are not immediately ready for 
+
+	Edgelists from generators are not immediately ready for
 	use here with TLAV.  For example, they may have self-loops
 	or non-contiguous labels.  This preprocessing program
-	makes sure the edgelists will work  with TLAV functions.  
-		
+	makes sure the edgelists will work  with TLAV functions.
+
 	Also, while edges from generators are typically unweighted, this program
 	offers to add random weights between 1 and 100 if wanted,
 	for example to use with single source shortest path.
 
-	This software is distributed under 
+	Edges are held as flat arrays of 64-bit keys, the source
+	in the high half and the target in the low half, so that
+	sorting the keys sorts the edges.  Every step (parsing,
+	sorting, removing duplicates, self loops and reverse edges,
+	relabeling and writing) runs over these arrays with one
+	thread per cpu, or -threads n.
+
+	This software is distributed under
 	the modified Berkeley Software Distribution (BSD) License.
 */
 
 #include <algorithm>
 #include <iostream>
 #include <cstdlib>
-#include <fstream>
+#include <ctime>
 #include <string>
+#include <thread>
 #include <vector>
-#include <map>
-#include <set>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "Options.h"
+#include "BufferedWriter.h"
+#include "CsrImage.h"
+#include "ParallelSort.h"
+#include "ExternalSorter.h"
 
 using namespace std;
 
+// edges formatted per thread between writes
+#define WRITE_BLOCK (1<<20)
+
+/*
+	an open-addressing hash map of original vertex ids
+	to new labels, for relabeling vertices
+*/
+class IdMap {
+
+	public:
+		IdMap(size_t);
+		int find(int) const;
+		int insert(int, int);
+
+	private:
+		size_t slot(int) const;
+		void grow();
+
+		vector<int> ids;
+		vector<int> labels;
+		size_t mask;
+		size_t size;
+
+};
+
 /* function prototypes */
-void read_edgelist(string, std::vector<pair<int, int> >&);
-pair<int,int> parse_edge(string);
-void edgelist_remove_duplicates(vector<pair<int, int> >&);
-void edgelist_remove_self_loops(vector<pair<int, int> >&);
-void convert_edgelist_to_adjlist(vector<pair<int, int> >&, map<int,vector<int> >&);
-void adjlist_remove_reverse_edges(map<int,vector<int> >&);
-void adjlist_sort_rows( map<int, vector<int> >& );
-void convert_adjlist_map_to_vec( map<int, vector<int> >&, vector<pair<int, vector<int> > >& );
-void adjlist_relabel_verts_index_0( vector<pair<int, vector<int> > >& );
-void convert_adjlist_to_edgelist( vector< pair<int, vector<int> > >&, vector< pair<int,int> >&);
-void add_weights_to_edgelist( vector< pair<int,int> >&, vector< tuple<int,int,int> >& );
-void make_edgelist_undirected(vector<pair<int, int> >&);
-void make_wedgelist_undirected( vector< tuple<int,int,int> >&);
-void print_edges( vector<pair<int, vector<int> > >& );
-void write_edgelist( vector<pair<int, vector<int> > >&, int*, int, string);
-void write_wedgelist( vector<tuple<int,int,int> >&, string);
-void write_unweighted_edgelist( vector< pair<int,int> >&, string);
+bool read_file(string, vector<char>&);
+size_t parse_edgelist(const char*, size_t, vector<uint64_t>&, int);
+int parse_int(const char*, const char*);
+void edgelist_remove_duplicates_and_self_loops(vector<uint64_t>&, int);
+void edgelist_sources(vector<uint64_t>&, vector<int>&);
+void edgelist_remove_reverse_edges(vector<uint64_t>&, int);
+int edgelist_relabel_verts_index_0(vector<uint64_t>&, vector<int>&, vector<int>&, int);
+void add_weights_to_edgelist(vector<uint64_t>&, vector<int>&);
+void make_edgelist_undirected(vector<uint64_t>&, vector<int>*);
+bool write_edgelist(vector<uint64_t>&, vector<int>*, string, int);
+bool write_csr_image(vector<uint64_t>&, vector<int>*, vector<int>&, string);
+bool write_all(int, const void*, size_t);
+int preprocess_external(string, string, bool, bool, size_t, string, int);
+
+/* an edge as a sortable key, and back */
+static inline uint64_t edge_key(int v1, int v2) {
+	return ( (uint64_t)((uint32_t)v1 ^ 0x80000000u) << 32 ) | ((uint32_t)v2 ^ 0x80000000u);
+}
+static inline int key_src(uint64_t key) {
+	return (int)( (uint32_t)(key >> 32) ^ 0x80000000u );
+}
+static inline int key_dst(uint64_t key) {
+	return (int)( (uint32_t)key ^ 0x80000000u );
+}
 
 /*
 	Edgelist preprocessing main program
 */
 int main(int argc, char* argv[]) {
 
-	if(argc !=4) {
-		cout << "usage:  ./edge_to_edge   edgelist_in   edgelist_out   weighted" << endl;
+	if(argc < 4) {
+		cout << "usage:  ./edge_to_edge   edgelist_in   edgelist_out   weighted   [-threads n] [-format text|csr] [-mem mb] [-tmpdir dir]" << endl;
 		return -1;
 	}
 
@@ -68,475 +118,1008 @@ int main(int argc, char* argv[]) {
 		cout << "error: weighted parameter must be 0 or 1" << endl;
 		return -1;
 	}
-	
+
+	Options opts(argc, argv, 4);
+	int threads = opts.get_int("threads", std::thread::hardware_concurrency());
+	if( threads < 1 ) threads = 1;
+	bool csr = ( opts.get_string("format", "text") == "csr" );
+
 	/*
-		initialize an edgelist and two adjacency list
-		graph representations.  Some formats are easier
-		to preprocess than others, depending on the operations
-	*/
-	vector<pair<int, int> > edges;
-	map<int, vector<int> > adjlist1;
-	vector<pair<int, vector<int> > > adjlist2;
-
-	/* read in the edgelist into an edge vector */
-	read_edgelist(filename, edges);
-	
-	/* remove duplicate edges and self loops */
-	edgelist_remove_duplicates(edges);
-	edgelist_remove_self_loops(edges);
-	
-	/* 
-		convert to an adjacency list and
-		remove all reverse edges
+		with a memory budget, sort through temporary files
+		next to the output, or in -tmpdir
 	*/
-	convert_edgelist_to_adjlist(edges, adjlist1);
-	adjlist_remove_reverse_edges(adjlist1);
+	if( opts.has("mem") ) {
+		size_t budget = (size_t)max( opts.get_int("mem", 1024), 16 ) << 20;
+		size_t slash = outfile.find_last_of('/');
+		string tmpdir = opts.get_string("tmpdir", slash == string::npos ? "." : outfile.substr(0, slash));
+		return preprocess_external(filename, outfile, weighted, csr, budget, tmpdir, threads);
+	}
+
+	/* read in the edgelist into an array of edge keys */
+	vector<uint64_t> edges;
+	{
+		vector<char> text;
+		if( !read_file(filename, text) ) {
+			cout << "error: cannot read " << filename << endl;
+			return -1;
+		}
+		size_t lines = parse_edgelist(text.empty() ? NULL : &text[0], text.size(), edges, threads);
+		cout << "read " << lines << " lines" << endl;
+		cout << edges.size() << " edges" << endl;
+	}
 
 	/*
-		sort the rows of the adjacency list
-		then relabel the vertices to make
-		sure the vert_ids are continuous
+		sort the edges, then remove duplicate edges,
+		self loops, and the reverse of any edge whose
+		source is the smaller vertex
 	*/
-	adjlist_sort_rows(adjlist1);
-	convert_adjlist_map_to_vec(adjlist1, adjlist2);
-	adjlist_relabel_verts_index_0(adjlist2);
-	
+	vector<int> sources;
+	radix_sort<int>(edges, NULL, threads);
+	edgelist_remove_duplicates_and_self_loops(edges, threads);
+	edgelist_sources(edges, sources);
+	edgelist_remove_reverse_edges(edges, threads);
+
 	/*
-		convert the adjacency list to an edgelist
+		relabel the vertices to make sure
+		the vert_ids are continuous
 	*/
-	convert_adjlist_to_edgelist( adjlist2, edges);
-	
-	
+	vector<int> ids;
+	edgelist_relabel_verts_index_0(edges, sources, ids, threads);
+
 	/*
 		it the user opts to not add edgeweights
 		make edges go both ways, sort them,
 		then write to a file
 	*/
 	if(weighted==0) {
-		make_edgelist_undirected(edges);
-		sort(edges.begin(), edges.end() );
-		write_unweighted_edgelist(edges, outfile);
+		make_edgelist_undirected(edges, NULL);
+		radix_sort<int>(edges, NULL, threads);
+		if( csr ) {
+			if( !write_csr_image(edges, NULL, ids, outfile) ) return -1;
+		} else if( !write_edgelist(edges, NULL, outfile, threads) ) return -1;
 		return 0;
 	}
-	
-	/* 
-		if weighted is wanted, then
-		create a collection of weighted edgeweights (3 datums),
-		generate random weights for each edges, 
-		then add reverse edges, sort, and 
+
+	/*
+		if weighted is wanted, then sort the edges,
+		generate random weights for each edge in order,
+		then add reverse edges, sort, and
 		write to an outputted edgelist
 	*/
-	vector< tuple<int,int,int> > wedges;
-	add_weights_to_edgelist( edges, wedges );
-	make_wedgelist_undirected( wedges );
-	sort(wedges.begin(), wedges.end());
-	write_wedgelist( wedges, outfile);
+	vector<int> weights;
+	radix_sort<int>(edges, NULL, threads);
+	add_weights_to_edgelist( edges, weights );
+	make_edgelist_undirected( edges, &weights );
+	radix_sort( edges, &weights, threads );
+	if( csr ) {
+		if( !write_csr_image( edges, &weights, ids, outfile) ) return -1;
+	} else if( !write_edgelist( edges, &weights, outfile, threads) ) return -1;
 
 	return 0;
 
 }
 
+/*
+	read a whole file into memory with large reads
+*/
+bool read_file(string filename, vector<char>& text) {
+
+	int fd = open( filename.c_str(), O_RDONLY );
+	if( fd < 0 ) return false;
+
+	struct stat st;
+	if( fstat(fd, &st) != 0 ) {
+		close(fd);
+		return false;
+	}
+	text.resize( st.st_size );
+
+	size_t done = 0;
+	while( done < text.size() ) {
+		size_t chunk = min( text.size() - done, (size_t)(1<<30) );
+		ssize_t n = read( fd, &text[done], chunk );
+		if( n < 0 && errno == EINTR ) continue;
+		if( n <= 0 ) break;
+		done += n;
+	}
+	close(fd);
+	text.resize(done);
+	return true;
+}
 
 /*
-	reads an edgelist from file into a vector of integer pairs
+	parse an integer from [p,end) as atoi would:
+	leading whitespace, an optional sign, then digits
 */
-void read_edgelist(string filename, std::vector<pair<int, int> >& edge_vec) {
+int parse_int(const char* p, const char* end) {
 
-	std::ifstream edgelist;
-	edgelist.open(filename.c_str());
-	string line;
+	while( p < end && ( *p == ' ' || (*p >= '\t' && *p <= '\r') ) ) p++;
+	bool neg = false;
+	if( p < end && ( *p == '-' || *p == '+' ) ) {
+		neg = ( *p == '-' );
+		p++;
+	}
+	unsigned int v = 0;
+	while( p < end && *p >= '0' && *p <= '9' ) {
+		v = v*10 + (*p - '0');
+		p++;
+	}
+	return neg ? (int)(0u - v) : (int)v;
+}
 
-	pair<int,int> edge;
+/* the text split into per-thread chunks of whole lines */
+struct ParseJob {
+	const char* text;
+	size_t size;
+	vector<size_t> bounds;
+	vector<size_t> lines;
+	vector<size_t> counts;
+	vector<size_t> offsets;
+	uint64_t* keys;
+	bool write;
+};
 
-	int count=0;
-	while( getline(edgelist, line) ) {
-		count++;
-		if(line[0]=='#') { //ignore comments at top of graphs from SNAP
-			continue;
+/*
+	count, or parse, the lines of one chunk.  Each line up to
+	its first tab is the source, the rest is the target, and
+	lines starting with # are comments (from SNAP).  A line
+	without a tab parses as a self loop, as it always has.
+*/
+static void parse_chunk(int t, int, void* arg) {
+
+	ParseJob* job = (ParseJob*)arg;
+	const char* p = job->text + job->bounds[t];
+	const char* end = job->text + job->bounds[t+1];
+	size_t lines = 0, count = 0;
+	uint64_t* out = job->write ? job->keys + job->offsets[t] : NULL;
+
+	while( p < end ) {
+		const char* eol = (const char*)memchr(p, '\n', end - p);
+		if( eol == NULL ) eol = end;
+		lines++;
+		if( *p != '#' ) {
+			if( out != NULL ) {
+				const char* tab = (const char*)memchr(p, '\t', eol - p);
+				int v1, v2;
+				if( tab == NULL ) {
+					v1 = v2 = parse_int(p, eol);
+				} else {
+					v1 = parse_int(p, tab);
+					v2 = parse_int(tab+1, eol);
+				}
+				out[count] = edge_key(v1, v2);
+			}
+			count++;
 		}
-		edge=parse_edge(line);
-		edge_vec.push_back(edge);
+		p = eol + 1;
 	}
-
-	edgelist.close();
-	cout << "read " << count << " lines" << endl;
-	cout << edge_vec.size() << " edges" << endl;
-	return;
+	job->lines[t] = lines;
+	job->counts[t] = count;
 }
 
 /*
-	Sub-program used by read_edgelist() for parsing row of edgelist.
-	Assumes tab-delimitation.
+	parses the text of an edgelist into edge keys, in two passes:
+	the first counts each chunk's edges, the second parses them
+	into place.  Returns the number of lines.
 */
-pair<int,int> parse_edge(string edge_str) {
+size_t parse_edgelist(const char* text, size_t size, vector<uint64_t>& edges, int num_threads) {
+
+	ParseJob job;
+	job.text = text;
+	job.size = size;
+	job.bounds.resize(num_threads + 1);
+	job.lines.resize(num_threads);
+	job.counts.resize(num_threads);
+	job.offsets.resize(num_threads);
+
+	// start each chunk after a newline
+	job.bounds[0] = 0;
+	for(int t=1; t<num_threads; t++) {
+		size_t b = max( part_begin(job.size, t, num_threads), job.bounds[t-1] );
+		while( b < job.size && b > 0 && text[b-1] != '\n' ) b++;
+		job.bounds[t] = b;
+	}
+	job.bounds[num_threads] = job.size;
+
+	job.write = false;
+	parallel_for(num_threads, parse_chunk, &job);
 
-	pair<int,int> edge;
-	int v1,v2;
-	int pos=edge_str.find("\t");
-	v1=atoi( edge_str.substr(0,pos).c_str() );
-	v2=atoi( edge_str.substr(pos+1,edge_str.length()).c_str() );
-	edge= make_pair(v1,v2);
+	size_t total = 0, lines = 0;
+	for(int t=0; t<num_threads; t++) {
+		job.offsets[t] = total;
+		total += job.counts[t];
+		lines += job.lines[t];
+	}
+	edges.resize(total);
+	job.keys = edges.empty() ? NULL : &edges[0];
+	job.write = true;
+	parallel_for(num_threads, parse_chunk, &job);
 
-	return edge;
+	return lines;
 }
 
+/* a compaction of sorted edges that keeps edges by a rule */
+struct CompactJob {
+	const uint64_t* in;
+	uint64_t* out;
+	size_t n;
+	int rule;
+	const uint64_t* rev;
+	size_t num_rev;
+	vector<size_t> counts;
+	bool write;
+};
+
+// rules for which edges to keep
+#define KEEP_UNIQUE 0
+#define KEEP_NO_SELF_LOOP 1
+#define KEEP_NO_REVERSE 2
 
 /*
-	add each edge from the edgelist into a *set* of edges
-	the set can only contain each edge once,
-	so edges cannot be duplicated
+	whether to keep edge i.  For reverse edges, rev holds
+	the sorted reverses of the edges (u,v) with u < v, and
+	the cursor walks it alongside the sorted edges.
 */
-void edgelist_remove_duplicates(vector<pair<int, int> >& edgelist) {
-	set<pair<int, int> > edgelist_sans_duplicates;
-	pair< set<pair<int, int> >::const_iterator, bool> result_pair;
-	int num_duplicates=0;
-
-	vector<pair<int, int> >::iterator edge_itr;
-	
-	for(edge_itr=edgelist.begin(); edge_itr!=edgelist.end(); ++edge_itr) {
-		result_pair = edgelist_sans_duplicates.insert( *edge_itr );
-		if(!result_pair.second) num_duplicates++;
-	}	
-
-	set<pair<int, int> >::iterator set_itr;
-	edgelist.clear();
-	for(set_itr=edgelist_sans_duplicates.begin(); set_itr!=edgelist_sans_duplicates.end(); ++set_itr)
-		edgelist.push_back(*set_itr);
-
-	cout << num_duplicates << " duplicate edges removed" << endl;
-	return; 
+static inline bool keep_edge(const CompactJob* job, size_t i, const uint64_t*& cursor) {
+	uint64_t key = job->in[i];
+	if( job->rule == KEEP_UNIQUE )
+		return i == 0 || job->in[i-1] != key;
+	if( job->rule == KEEP_NO_SELF_LOOP )
+		return key_src(key) != key_dst(key);
+
+	// drop (u,v) when u > v and (v,u) exists
+	if( key_src(key) < key_dst(key) ) return true;
+	const uint64_t* rev_end = job->rev + job->num_rev;
+	while( cursor < rev_end && *cursor < key ) cursor++;
+	return cursor == rev_end || *cursor != key;
 }
 
-/*
-	Remove self-loops from an edgelist.  Iterates through edgelist
-	to find edge with equal first and second node.
-*/	
-void edgelist_remove_self_loops(vector<pair<int, int> >& edgelist) { 
-	int num_self_loops=0;
-	vector<pair<int, int> >::iterator edge_itr;
-	vector<pair<int, int> > edgelist_no_loops;
-
-	for(edge_itr= edgelist.begin(); edge_itr!= edgelist.end(); ++edge_itr) {
-		if ( (*edge_itr).first == (*edge_itr).second )
-			num_self_loops++;
-		else
-			edgelist_no_loops.push_back( (*edge_itr) );
+static void compact_chunk(int t, int num_threads, void* arg) {
+	CompactJob* job = (CompactJob*)arg;
+	size_t begin = part_begin(job->n, t, num_threads);
+	size_t end = part_begin(job->n, t+1, num_threads);
+	size_t count = 0;
+	const uint64_t* cursor = job->rev;
+	if( job->rule == KEEP_NO_REVERSE && begin < end )
+		cursor = lower_bound(job->rev, job->rev + job->num_rev, job->in[begin]);
+	if( job->write ) {
+		uint64_t* out = job->out + job->counts[t];
+		for(size_t i=begin; i<end; i++)
+			if( keep_edge(job, i, cursor) ) out[count++] = job->in[i];
+	} else {
+		for(size_t i=begin; i<end; i++)
+			if( keep_edge(job, i, cursor) ) count++;
+		job->counts[t] = count;
 	}
-	
-	edgelist=edgelist_no_loops;
-	cout << num_self_loops << " self loops removed" << endl;
 }
 
 /*
-	Converts an edgelist into an adjacency list, by
-	taking edge's first and second node, seeing if the
-	adjlist contains an entry row for the first node...	
-	if not, create a new row, add the second node, add the row;
-	if so, add the second node (b/c no duplicates assumed in edgelist)
+	keep the edges that pass a rule, in order,
+	returning the number removed
 */
-void convert_edgelist_to_adjlist(vector<pair<int, int> >& edgelist, map<int,vector<int> >& adjlist) {
-
-	vector<pair<int, int> >::iterator edge_itr;
-	int v1,v2;
-	int count=0;
-	for(edge_itr=edgelist.begin(); edge_itr!=edgelist.end(); ++edge_itr) {
-		v1=(*edge_itr).first;
-		v2=(*edge_itr).second;
-		if( adjlist.find(v1) == adjlist.end() ) {
-			vector<int> row;
-			row.push_back(v2);
-			adjlist.insert( make_pair(v1, row) );
-		} else {
-			vector<int> row=(*(adjlist.find(v1))).second;
-			row.push_back(v2);
-			adjlist.erase(v1);
-			adjlist.insert( make_pair(v1,row) );
-		}
-		count ++;
-		//if(count%1000==0) cout << count << endl;
+static size_t compact_edges(vector<uint64_t>& edges, int rule, int num_threads,
+		const vector<uint64_t>* rev=NULL) {
+
+	CompactJob job;
+	job.n = edges.size();
+	if( job.n == 0 ) return 0;
+	job.in = &edges[0];
+	job.rule = rule;
+	job.rev = ( rev != NULL && !rev->empty() ) ? &(*rev)[0] : NULL;
+	job.num_rev = ( rev != NULL ) ? rev->size() : 0;
+	job.counts.resize(num_threads);
+
+	job.write = false;
+	parallel_for(num_threads, compact_chunk, &job);
+	size_t total = 0;
+	for(int t=0; t<num_threads; t++) {
+		size_t c = job.counts[t];
+		job.counts[t] = total;
+		total += c;
 	}
-	edgelist.clear();
 
-	cout << count << " edges converted to adjlist" << endl;
+	vector<uint64_t> kept(total);
+	job.out = kept.empty() ? NULL : &kept[0];
+	job.write = true;
+	parallel_for(num_threads, compact_chunk, &job);
 
-	return;
+	size_t removed = job.n - total;
+	edges.swap(kept);
+	return removed;
 }
 
 /*
-	for each edge, find if a reverse exists
-	if so, remove the reverse, and keep the "first" edge found
+	remove duplicate edges, then self loops,
+	from an edgelist sorted by edge
 */
-void adjlist_remove_reverse_edges(map<int, vector<int> >& adjlist) { 
-
-	int num_reverse_edges_removed=0;
-	map<int,vector<int> >::iterator adj_itr;
-	for(adj_itr=adjlist.begin(); adj_itr!=adjlist.end(); ++adj_itr) {
-		int v=(*adj_itr).first;
-		vector<int> v_adj= adjlist[v];
-		vector<int>::iterator v_row_itr;
-		for(v_row_itr=v_adj.begin(); v_row_itr!=v_adj.end(); ++v_row_itr) {
-			int u=*v_row_itr;
-			if( adjlist.find(u) == adjlist.end() ) continue;
-			else {
-				vector<int> u_adj = adjlist[u];
-				vector<int>::iterator u_row_itr;
-				for(u_row_itr=u_adj.begin(); u_row_itr!=u_adj.end(); ++u_row_itr) {
-					if(*u_row_itr == v) {
-						num_reverse_edges_removed++;
-						vector<int> row_with_v = adjlist[u];
-						row_with_v.erase( find(row_with_v.begin(), row_with_v.end(), v) );
-						vector<int> row_without_v = row_with_v;
-						adjlist.erase(u);
-						adjlist.insert( make_pair( u, row_without_v) );
-					}
-				}
-			}
-		}
-	}
+void edgelist_remove_duplicates_and_self_loops(vector<uint64_t>& edges, int num_threads) {
 
-	cout << num_reverse_edges_removed << " reverse edges removed" << endl;
-	return;
+	size_t num_duplicates = compact_edges(edges, KEEP_UNIQUE, num_threads);
+	cout << num_duplicates << " duplicate edges removed" << endl;
+
+	size_t num_self_loops = compact_edges(edges, KEEP_NO_SELF_LOOP, num_threads);
+	cout << num_self_loops << " self loops removed" << endl;
 }
 
 /*
-	sort each row in an adjacency list. uses stl sort
+	the distinct sources of an edgelist sorted by edge,
+	in increasing order
 */
-void adjlist_sort_rows( map<int, vector<int> >& adjlist) {
-	int num_rows_sorted=0;
-	for( map<int, vector<int> >::iterator adj_itr = adjlist.begin(); adj_itr!= adjlist.end(); ++adj_itr) {
-		sort( ((*adj_itr).second).begin(), ((*adj_itr).second).end() );
-		num_rows_sorted++;
-	}
-	cout << num_rows_sorted << " rows of adjlist sorted" << endl;
-	return;
+void edgelist_sources(vector<uint64_t>& edges, vector<int>& sources) {
+
+	sources.clear();
+	for(size_t i=0; i<edges.size(); i++)
+		if( i == 0 || key_src(edges[i]) != key_src(edges[i-1]) )
+			sources.push_back( key_src(edges[i]) );
+
+	cout << edges.size() << " edges converted to adjlist" << endl;
 }
 
 /*
-	Convert and adjacency list that uses a map
-	to an adjacency list that uses a vector.
-	Makes some operations easier.
+	for each pair of edges (u,v) and (v,u), keep the edge
+	leaving the smaller vertex and remove its reverse,
+	found by merging the sorted edges with the sorted
+	reverses of the edges leaving smaller vertices
 */
-void convert_adjlist_map_to_vec( map<int, vector<int> >& adjlist, vector<pair<int, vector<int> > >& adjlist_vec) {
-	for( map<int, vector<int> >::iterator adj_itr=adjlist.begin(); adj_itr!= adjlist.end(); ++adj_itr) {
-		adjlist_vec.push_back( make_pair( (*adj_itr).first, (*adj_itr).second) );
-	}
-	adjlist.clear();
-	cout << adjlist_vec.size() << " verts in new adjlist" << endl;
-	return;
+void edgelist_remove_reverse_edges(vector<uint64_t>& edges, int num_threads) {
+
+	vector<uint64_t> rev;
+	for(size_t i=0; i<edges.size(); i++)
+		if( key_src(edges[i]) < key_dst(edges[i]) )
+			rev.push_back( edge_key( key_dst(edges[i]), key_src(edges[i]) ) );
+	radix_sort<int>(rev, NULL, num_threads);
+
+	size_t num_reverse_edges_removed = compact_edges(edges, KEEP_NO_REVERSE, num_threads, &rev);
+	cout << num_reverse_edges_removed << " reverse edges removed" << endl;
 }
 
-/*
-	relabel an adjacency list so vertex labels are sequential from 0
-*/
-void adjlist_relabel_verts_index_0( vector<pair<int, vector<int> > >& adjlist) {
-
-	map<int, int> relabels;
-	int relabel_count =0;
-	int	total_verts_relabeled =0;
-	
-	vector<pair<int, vector<int> > >::iterator itr;
-	int n1, n2;
-	vector<int> row;
-	for( itr = adjlist.begin(); itr != adjlist.end(); ++itr) {
-		n1 = (*itr).first;
-		if( relabels.find(n1) == relabels.end() ) {
-			relabels.insert( make_pair( n1, relabel_count ) );
-			relabel_count++;
-		}	
-	}
+/* Constructor, room for num_ids before growing */
+IdMap::IdMap(size_t num_ids) {
+	size_t cap = 16;
+	while( cap < 2*num_ids ) cap <<= 1;
+	ids.resize(cap);
+	labels.assign(cap, -1);
+	mask = cap - 1;
+	size = 0;
+}
 
-	for( itr = adjlist.begin(); itr != adjlist.end(); ++itr) {
-		row = (*itr).second;
-		for(int i=0; i<row.size(); i++) {
-			n2 = row[i];
-			if( relabels.find(n2) == relabels.end() ) {
-				relabels.insert( make_pair( n2, relabel_count ) );		
-				relabel_count++;
-			}
-		}		
+/* double the table, keeping it at most half full */
+void IdMap::grow() {
+	vector<int> old_ids, old_labels;
+	old_ids.swap(ids);
+	old_labels.swap(labels);
+	ids.resize( 2*old_ids.size() );
+	labels.assign( 2*old_ids.size(), -1 );
+	mask = ids.size() - 1;
+	for(size_t s=0; s<old_ids.size(); s++) {
+		if( old_labels[s] < 0 ) continue;
+		size_t t = slot( old_ids[s] );
+		while( labels[t] >= 0 ) t = (t+1) & mask;
+		ids[t] = old_ids[s];
+		labels[t] = old_labels[s];
 	}
+}
 
+/* the first slot to probe for an id */
+inline size_t IdMap::slot(int id) const {
+	return (size_t)( ( (uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull ) >> 32 ) & mask;
+}
 
-	// relabel all verts
-	for( int i=0;  i<adjlist.size(); i++) {		
-		adjlist[i].first = relabels[ adjlist[i].first ];
-		total_verts_relabeled++;
-		for( int j=0; j< (adjlist[i].second).size(); j++ ) {
-			(adjlist[i].second)[j] = relabels[ (adjlist[i].second)[j] ];
-			total_verts_relabeled++;
+/* the label of an id, -1 if it has none */
+inline int IdMap::find(int id) const {
+	for(size_t s=slot(id); ; s=(s+1)&mask) {
+		if( labels[s] < 0 ) return -1;
+		if( ids[s] == id ) return labels[s];
+	}
+}
+
+/* give an id a label unless it has one, returning its label */
+inline int IdMap::insert(int id, int label) {
+	if( 2*(size+1) > ids.size() ) grow();
+	for(size_t s=slot(id); ; s=(s+1)&mask) {
+		if( labels[s] < 0 ) {
+			size++;
+			ids[s] = id;
+			labels[s] = label;
+			return label;
 		}
-		sort( (adjlist[i].second).begin(), (adjlist[i].second).end() );
+		if( ids[s] == id ) return labels[s];
 	}
+}
 
-	cout << "relabeled " << total_verts_relabeled << " verts" << endl;
-	return;
+/* edges relabeled, or marked if their target is still unlabeled */
+struct RelabelJob {
+	uint64_t* edges;
+	size_t n;
+	IdMap* map;
+	vector<char>* unlabeled;
+};
+
+static void mark_unlabeled(int t, int num_threads, void* arg) {
+	RelabelJob* job = (RelabelJob*)arg;
+	size_t end = part_begin(job->n, t+1, num_threads);
+	for(size_t i=part_begin(job->n, t, num_threads); i<end; i++)
+		(*job->unlabeled)[i] = ( job->map->find( key_dst(job->edges[i]) ) < 0 );
 }
 
-/* 
-	convert a vector-based adjacency list to a vector of edges
+static void relabel_chunk(int t, int num_threads, void* arg) {
+	RelabelJob* job = (RelabelJob*)arg;
+	size_t end = part_begin(job->n, t+1, num_threads);
+	for(size_t i=part_begin(job->n, t, num_threads); i<end; i++) {
+		uint64_t key = job->edges[i];
+		job->edges[i] = ( (uint64_t)job->map->find( key_src(key) ) << 32 )
+			| (uint32_t)job->map->find( key_dst(key) );
+	}
+}
+
+/*
+	relabel the vertices of an edgelist sorted by edge
+	so vertex labels are sequential from 0: first every
+	source, in increasing order, then every other target
+	in order of first appearance.  Sources are those from
+	before reverse edges were removed.  Relabeled edges are
+	plain (source << 32 | target) keys.  ids gets the
+	original id of each label.  Returns the number of vertices.
 */
-void convert_adjlist_to_edgelist( vector<pair<int, vector<int> > >& adjlist, vector< pair<int,int> >& edgelist) {
-	
-	edgelist.clear();
-	int edges_processed=0;
-
-	vector< pair<int, vector<int> > >::iterator adj_itr;
-	vector<int>::iterator row_itr;
-
-	for(adj_itr=adjlist.begin(); adj_itr!=adjlist.end(); ++adj_itr) {
-		for(row_itr=((*adj_itr).second).begin(); row_itr!=((*adj_itr).second).end(); ++row_itr) {
-			edgelist.push_back( make_pair( (*adj_itr).first, *row_itr) );
-			edges_processed++;
+int edgelist_relabel_verts_index_0(vector<uint64_t>& edges, vector<int>& sources,
+		vector<int>& ids, int num_threads) {
+
+	size_t n = edges.size();
+	cout << sources.size() << " rows of adjlist sorted" << endl;
+	cout << sources.size() << " verts in new adjlist" << endl;
+
+	IdMap map( sources.size() );
+	int relabel_count = 0;
+	ids = sources;
+	for(size_t i=0; i<sources.size(); i++)
+		map.insert( sources[i], relabel_count++ );
+
+	RelabelJob job;
+	job.edges = n ? &edges[0] : NULL;
+	job.n = n;
+	job.map = &map;
+	vector<char> unlabeled(n);
+	job.unlabeled = &unlabeled;
+	parallel_for(num_threads, mark_unlabeled, &job);
+	for(size_t i=0; i<n; i++)
+		if( unlabeled[i] && map.insert( key_dst(edges[i]), relabel_count ) == relabel_count ) {
+			ids.push_back( key_dst(edges[i]) );
+			relabel_count++;
 		}
-	}
 
-	adjlist.clear();
-	cout << edges_processed << " edges coverted to edgelist" << endl;
-	return;
+	parallel_for(num_threads, relabel_chunk, &job);
+
+	cout << "relabeled " << sources.size() + n << " verts" << endl;
+	cout << n << " edges coverted to edgelist" << endl;
+	return relabel_count;
 }
 
-/* 
-	from a vector of edges create a vector of weighted edges
-	with random edge weights
+/*
+	from the relabeled edges, sorted, generate a
+	random weight for each edge in order
 */
-void add_weights_to_edgelist( vector< pair<int,int> >& edges, vector< tuple<int,int,int> >& wedges) {
+void add_weights_to_edgelist( vector<uint64_t>& edges, vector<int>& weights ) {
 
-	vector< pair<int,int> >::iterator edge_itr;
-	int v1, v2, weight;
 	srand( (unsigned)time(NULL) );
-	
-	for(edge_itr = edges.begin(); edge_itr != edges.end(); ++edge_itr) {
-		v1 = (*edge_itr).first;
-		v2 = (*edge_itr).second;
-		weight = rand() % 100;
-		tuple<int,int,int> wedge(v1,v2,weight);
-		wedges.push_back(wedge);
-	}
-
-	return;
+	weights.resize( edges.size() );
+	for(size_t i=0; i<edges.size(); i++)
+		weights[i] = rand() % 100;
 }
 
 /*
-	make edgelists "undirected", meaning that in the 
+	make edgelists "undirected", meaning that in the
 	graph representation, whether an adjacency list or edgelist,
 	if an edge (u,v) exists then there is also an edge (v,u).
-	Kind of similar to a directed graph where edges always
-	exist in both directions between 2 nodes
+	Reverse edges keep the weight of their edge, if weighted.
 */
-void make_edgelist_undirected(vector<pair<int, int> >& edges) {
-
-	vector< pair<int,int> >::iterator edge_itr;
-	vector< pair<int,int> > reverse_edges;
-	pair<int,int> edge, reverse_edge;
-	int v1, v2;
-	
-	for( edge_itr = edges.begin(); edge_itr != edges.end(); ++edge_itr) {
-		edge=*edge_itr;
-		v1=edge.first;
-		v2=edge.second;
-		reverse_edge=make_pair(v2, v1);
-		reverse_edges.push_back(reverse_edge);		
-	}
-	
-	for(edge_itr=reverse_edges.begin(); edge_itr != reverse_edges.end(); ++edge_itr) {
-		edges.push_back(*edge_itr);
-	}
-
-	return;
-}	
-
-/* 
-  make a vector of weighted edges undirected by 
-  adding the reveres edge with the same edgeweight
+void make_edgelist_undirected( vector<uint64_t>& edges, vector<int>* weights ) {
+
+	size_t n = edges.size();
+	edges.resize(2*n);
+	for(size_t i=0; i<n; i++)
+		edges[n+i] = ( edges[i] << 32 ) | ( edges[i] >> 32 );
+
+	if( weights != NULL ) {
+		weights->resize(2*n);
+		for(size_t i=0; i<n; i++)
+			(*weights)[n+i] = (*weights)[i];
+		cout << n << " edges added, " << 2*n << " total weighted edges" << endl;
+	}
+}
+
+/* one round of formatting edges into per-thread buffers */
+struct WriteJob {
+	const uint64_t* edges;
+	const int* weights;
+	size_t begin;
+	size_t end;
+	vector< vector<char> > bufs;
+	vector<size_t> lens;
+};
+
+static void format_chunk(int t, int num_threads, void* arg) {
+
+	WriteJob* job = (WriteJob*)arg;
+	size_t n = job->end - job->begin;
+	size_t begin = job->begin + part_begin(n, t, num_threads);
+	size_t end = job->begin + part_begin(n, t+1, num_threads);
+
+	// the longest line is three integers and separators
+	vector<char>& buf = job->bufs[t];
+	if( buf.size() < (end - begin) * 36 ) buf.resize( (end - begin) * 36 );
+	char* out = buf.empty() ? NULL : &buf[0];
+	size_t len = 0;
+	for(size_t i=begin; i<end; i++) {
+		len += BufferedWriter::format_int( out + len, (int)(job->edges[i] >> 32) );
+		out[len++] = '\t';
+		len += BufferedWriter::format_int( out + len, (int)(uint32_t)job->edges[i] );
+		if( job->weights != NULL ) {
+			out[len++] = '\t';
+			len += BufferedWriter::format_int( out + len, job->weights[i] );
+		}
+		out[len++] = '\n';
+	}
+	job->lens[t] = len;
+}
+
+/*
+	write all of data, retrying short writes
 */
-void make_wedgelist_undirected( vector< tuple<int,int,int> >& wedgelist) {
+bool write_all(int fd, const void* data, size_t len) {
+	const char* p = (const char*)data;
+	while( len > 0 ) {
+		ssize_t w = write(fd, p, min(len, (size_t)(1<<30)));
+		if( w < 0 && errno == EINTR ) continue;
+		if( w <= 0 ) return false;
+		p += w;
+		len -= w;
+	}
+	return true;
+}
 
+/*
+	Write an edgelist, weighted if weights is not NULL, one
+	edge per line.  Threads format blocks of edges into their
+	own buffers, and the buffers are written in order.
+*/
+bool write_edgelist( vector<uint64_t>& edges, vector<int>* weights, string outfile, int num_threads ) {
 
-	vector< tuple<int,int,int> >::iterator wedge_itr;
-	vector< tuple<int,int,int> > reverse_wedges;
-	tuple<int,int,int> wedge, wedge_reverse;
-	int v1, v2, weight;
-	for( wedge_itr=wedgelist.begin(); wedge_itr != wedgelist.end(); ++wedge_itr) {
-		wedge=*wedge_itr;
-		v1 = get<0>(wedge);
-		v2 = get<1>(wedge);
-		weight = get<2>(wedge);
-		wedge_reverse = make_tuple(v2,v1,weight);
-		reverse_wedges.push_back(wedge_reverse);
+	int fd = open( outfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 ) {
+		cout << "error: cannot open " << outfile << endl;
+		return false;
 	}
-	for( wedge_itr=reverse_wedges.begin(); wedge_itr != reverse_wedges.end(); ++wedge_itr) {
-		wedgelist.push_back( *wedge_itr );
+
+	WriteJob job;
+	job.edges = edges.empty() ? NULL : &edges[0];
+	job.weights = ( weights != NULL && !weights->empty() ) ? &(*weights)[0] : NULL;
+	job.bufs.resize(num_threads);
+	job.lens.resize(num_threads);
+
+	bool ok = true;
+	size_t block = (size_t)WRITE_BLOCK * num_threads;
+	for(job.begin=0; job.begin<edges.size() && ok; job.begin=job.end) {
+		job.end = min( edges.size(), job.begin + block );
+		parallel_for(num_threads, format_chunk, &job);
+		for(int t=0; t<num_threads && ok; t++)
+			if( job.lens[t] > 0 ) ok = write_all(fd, &job.bufs[t][0], job.lens[t]);
 	}
 
-	cout << reverse_wedges.size() << " edges added, " << wedgelist.size() << " total weighted edges" << endl;
-	return;
+	if( close(fd) != 0 ) ok = false;
+	if( !ok ) cout << "error: writing " << outfile << endl;
+	return ok;
 }
 
 /*
-	Print to stdout each edge in an adjacency list
+	Write the undirected, sorted edges as a binary CSR
+	image (see CsrImage.h): the row offsets, the neighbors,
+	the weights if weighted, and the original id of each
+	vertex, so the engine loads it without parsing
 */
-void print_edges( vector<pair<int, vector<int> > >& adjlist) {
-
-	int n1, n2;
-	vector<int> row;
-	vector<pair<int, vector<int> > >::iterator vitr;
-	for(vitr = adjlist.begin(); vitr != adjlist.end(); ++vitr) {
-		n1 = (*vitr).first;
-		row = (*vitr).second;
-		for(int i=0; i<row.size(); i++) {
-			n2 = row[i];
-			cout << "edge " << n1 << " " << n2 << endl;
-		}
+bool write_csr_image( vector<uint64_t>& edges, vector<int>* weights, vector<int>& ids, string outfile ) {
+
+	int fd = open( outfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 ) {
+		cout << "error: cannot open " << outfile << endl;
+		return false;
+	}
+
+	CsrHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, CSR_MAGIC, CSR_MAGIC_LEN );
+	header.num_verts = ids.size();
+	header.num_edges = edges.size();
+	header.flags = CSR_ID_MAP | ( weights != NULL ? CSR_WEIGHTED : 0 );
+	header.offsets_at = csr_next_section( 0, sizeof(header) / 4 );
+	header.neighbors_at = csr_next_section( header.offsets_at, header.num_verts + 1 );
+	int64_t next = csr_next_section( header.neighbors_at, header.num_edges );
+	if( weights != NULL ) {
+		header.weights_at = next;
+		next = csr_next_section( header.weights_at, header.num_edges );
+	}
+	header.ids_at = next;
+
+	// row offsets, counted from the sorted sources
+	vector<int> offsets( ids.size() + 1, 0 );
+	for(size_t i=0; i<edges.size(); i++)
+		offsets[ (edges[i] >> 32) + 1 ]++;
+	for(size_t v=0; v<ids.size(); v++)
+		offsets[v+1] += offsets[v];
+
+	const char zeros[8] = {0};
+	int64_t at = 0;
+	bool ok = write_all( fd, &header, sizeof(header) );
+	at += sizeof(header);
+
+	ok = ok && write_all( fd, zeros, header.offsets_at - at );
+	ok = ok && write_all( fd, &offsets[0], offsets.size() * sizeof(int) );
+	at = header.offsets_at + offsets.size() * sizeof(int);
+
+	// neighbors, the low half of each edge, a block at a time
+	ok = ok && write_all( fd, zeros, header.neighbors_at - at );
+	vector<int> block( min( edges.size(), (size_t)WRITE_BLOCK ) );
+	for(size_t i=0; i<edges.size() && ok; i+=block.size()) {
+		size_t n = min( block.size(), edges.size() - i );
+		for(size_t j=0; j<n; j++)
+			block[j] = (int)(uint32_t)edges[i+j];
+		ok = write_all( fd, &block[0], n * sizeof(int) );
+	}
+	at = header.neighbors_at + edges.size() * sizeof(int);
+
+	if( weights != NULL ) {
+		ok = ok && write_all( fd, zeros, header.weights_at - at );
+		if( !weights->empty() )
+			ok = ok && write_all( fd, &(*weights)[0], weights->size() * sizeof(int) );
+		at = header.weights_at + weights->size() * sizeof(int);
 	}
 
-	return;
+	ok = ok && write_all( fd, zeros, header.ids_at - at );
+	if( !ids.empty() )
+		ok = ok && write_all( fd, &ids[0], ids.size() * sizeof(int) );
+
+	if( close(fd) != 0 ) ok = false;
+	if( !ok ) cout << "error: writing " << outfile << endl;
+	else cout << "wrote CSR image of " << ids.size() << " verts and " << edges.size() << " edges" << endl;
+	return ok;
+}
+
+/***** external memory preprocessing *****/
+
+/* an id as a key that sorts as the id does, and back */
+static inline uint64_t id_key(int id) {
+	return (uint32_t)id ^ 0x80000000u;
+}
+static inline int key_id(uint64_t key) {
+	return (int)( (uint32_t)key ^ 0x80000000u );
 }
 
 /*
-	Write an unweighted edgelist to a file as an edge list
+	read the edgelist in blocks of the budget, parsing each
+	block of whole lines into edges added to the sorter
 */
-void write_unweighted_edgelist( vector< pair<int,int> >& edges, string outfile) {
+static bool read_edgelist_blocks(string filename, ExternalSorter& sorter, size_t block,
+		int num_threads, size_t& lines, size_t& num_edges) {
+
+	int fd = open( filename.c_str(), O_RDONLY );
+	if( fd < 0 ) return false;
+
+	vector<char> text;
+	vector<uint64_t> edges;
+	size_t len = 0;
+	bool eof = false;
+	lines = 0;
+	num_edges = 0;
+
+	while( !eof ) {
+		if( text.size() < len + block ) text.resize( len + block );
+		ssize_t n = read( fd, &text[len], block );
+		if( n < 0 && errno == EINTR ) continue;
+		if( n < 0 ) {
+			close(fd);
+			return false;
+		}
+		eof = ( n == 0 );
+		len += n;
+
+		// parse up to the last newline, the rest waits for the next block
+		size_t whole = len;
+		if( !eof ) {
+			while( whole > 0 && text[whole-1] != '\n' ) whole--;
+			if( whole == 0 ) continue;
+		}
+		lines += parse_edgelist( &text[0], whole, edges, num_threads );
+		num_edges += edges.size();
+		for(size_t i=0; i<edges.size(); i++)
+			sorter.add( edges[i], 0 );
+		memmove( &text[0], &text[whole], len - whole );
+		len -= whole;
+	}
+
+	close(fd);
+	return true;
+}
 
-	ofstream outstream;
-	outstream.open(outfile.c_str());
-	
-	pair<int,int> edge;
-	int v1, v2;
+/*
+	Write the sorted edges of an external sorter as a binary
+	CSR image.  Only the row offsets are held in memory; the
+	weights are spilled while the neighbors are written.
+*/
+static bool write_csr_image_external( ExternalSorter& edges, vector<int>& degrees, uint64_t num_edges,
+		bool weighted, SpillFile& ids, string outfile, string tmp, size_t io_buffer ) {
 
-	vector< pair<int,int> >::iterator edge_itr;
-	for ( edge_itr=edges.begin(); edge_itr != edges.end(); ++edge_itr ) {
-		edge=*edge_itr;
-		v1=edge.first;
-		v2=edge.second;
-		outstream << v1 << "\t" << v2 << endl;
+	int fd = open( outfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd < 0 ) {
+		cout << "error: cannot open " << outfile << endl;
+		return false;
 	}
 
-	outstream.close();
+	CsrHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, CSR_MAGIC, CSR_MAGIC_LEN );
+	header.num_verts = degrees.size();
+	header.num_edges = num_edges;
+	header.flags = CSR_ID_MAP | ( weighted ? CSR_WEIGHTED : 0 );
+	header.offsets_at = csr_next_section( 0, sizeof(header) / 4 );
+	header.neighbors_at = csr_next_section( header.offsets_at, header.num_verts + 1 );
+	int64_t next = csr_next_section( header.neighbors_at, header.num_edges );
+	if( weighted ) {
+		header.weights_at = next;
+		next = csr_next_section( header.weights_at, header.num_edges );
+	}
+	header.ids_at = next;
+
+	// row offsets, from the degrees
+	vector<int> offsets( degrees.size() + 1, 0 );
+	for(size_t v=0; v<degrees.size(); v++)
+		offsets[v+1] = offsets[v] + degrees[v];
+	vector<int>().swap(degrees);
+
+	const char zeros[8] = {0};
+	bool ok = write_all( fd, &header, sizeof(header) );
+	ok = ok && write_all( fd, zeros, header.offsets_at - sizeof(header) );
+	ok = ok && write_all( fd, &offsets[0], offsets.size() * sizeof(int) );
+	int64_t at = header.offsets_at + offsets.size() * sizeof(int);
+	vector<int>().swap(offsets);
+	ok = ok && write_all( fd, zeros, header.neighbors_at - at );
+
+	// neighbors, a block at a time, spilling the weights for later
+	SpillFile weights;
+	if( weighted && !weights.create( tmp + ".wgt", io_buffer ) ) ok = false;
+	vector<int> block( io_buffer / sizeof(int) );
+	size_t n = 0;
+	uint64_t key, w;
+	while( ok && edges.next(key, w) ) {
+		block[n++] = (int)(uint32_t)key;
+		if( weighted ) weights.write( w, 0 );
+		if( n == block.size() ) {
+			ok = write_all( fd, &block[0], n * sizeof(int) );
+			n = 0;
+		}
+	}
+	ok = ok && write_all( fd, &block[0], n * sizeof(int) );
+	at = header.neighbors_at + num_edges * sizeof(int);
+
+	// then the weights, and the original ids, from their spill files
+	SpillFile* sections[2] = { weighted ? &weights : NULL, &ids };
+	int64_t sections_at[2] = { header.weights_at, header.ids_at };
+	for(int s=0; s<2 && ok; s++) {
+		if( sections[s] == NULL ) continue;
+		ok = write_all( fd, zeros, sections_at[s] - at );
+		at = sections_at[s];
+		sections[s]->rewind( io_buffer );
+		n = 0;
+		while( ok && sections[s]->read(key, w) ) {
+			block[n++] = (int)key;
+			at += sizeof(int);
+			if( n == block.size() ) {
+				ok = write_all( fd, &block[0], n * sizeof(int) );
+				n = 0;
+			}
+		}
+		ok = ok && write_all( fd, &block[0], n * sizeof(int) );
+	}
 
-	return;
+	if( close(fd) != 0 ) ok = false;
+	if( !ok ) cout << "error: writing " << outfile << endl;
+	else cout << "wrote CSR image of " << header.num_verts << " verts and " << num_edges << " edges" << endl;
+	return ok;
 }
 
 /*
-	Write a weighted edgelist to a file as a weighted edgelist
+	The preprocessing of an edgelist larger than memory, within
+	a memory budget, giving the same output as in memory.
+	Every step streams sorted files: the input is sorted into
+	runs and merged without duplicates; self loops are dropped
+	and reverse edges removed by merging with the sorted reverses;
+	vertices are relabeled by merging with a spilled id map
+	sorted by id; and the symmetrized edges are sorted once more
+	as they are written.  Only the CSR row offsets, if asked for,
+	take memory per vertex.
 */
-void write_wedgelist( vector<tuple<int,int,int> >& wedges, string outfile) {
+int preprocess_external(string filename, string outfile, bool weighted, bool csr,
+		size_t budget, string tmpdir, int num_threads) {
+
+	string tmp = tmpdir + "/edge_preproc." + to_string(getpid());
+	size_t io_buffer = min( budget / 16, (size_t)(4<<20) );
+	uint64_t key, val;
+
+	/* read in the edgelist, sorted into runs of unique edges */
+	size_t lines, num_edges;
+	ExternalSorter input( tmp + ".in", budget, num_threads, true );
+	if( !read_edgelist_blocks(filename, input, max( budget / 8, (size_t)(1<<20) ), num_threads, lines, num_edges) ) {
+		cout << "error: cannot read " << filename << endl;
+		return -1;
+	}
+	cout << "read " << lines << " lines" << endl;
+	cout << num_edges << " edges" << endl;
+	input.finish();
+	cout << input.get_num_runs() << " sorted runs of at most " << (budget >> 20) << " MB" << endl;
 
-	ofstream outstream;
-	outstream.open(outfile.c_str());
-	
-	tuple<int,int,int> wedge;
-	int v1, v2, weight;
-	
-	vector< tuple<int,int,int> >::iterator wedge_itr;
-	for( wedge_itr=wedges.begin(); wedge_itr!=wedges.end(); ++wedge_itr) {
-		wedge=*wedge_itr;
-		v1 = get<0>(wedge);
-		v2 = get<1>(wedge);
-		weight = get<2>(wedge);
-		outstream << v1 << "\t" << v2 << "\t" << weight << endl;
+	/*
+		merge the runs, dropping duplicates and self loops,
+		keeping the edges, their sources in order with their
+		ranks, and sorting the reverses of upward edges
+	*/
+	SpillFile edges, sources;
+	ExternalSorter reverses( tmp + ".rev", budget / 2, num_threads );
+	if( !edges.create( tmp + ".edges", io_buffer ) || !sources.create( tmp + ".src", io_buffer ) ) return -1;
+	uint64_t num_unique = 0, num_self_loops = 0, num_sources = 0;
+	int last_src = 0;
+	while( input.next(key, val) ) {
+		num_unique++;
+		int src = key_src(key), dst = key_dst(key);
+		if( src == dst ) {
+			num_self_loops++;
+			continue;
+		}
+		edges.write( key, 0 );
+		if( num_sources == 0 || src != last_src ) {
+			sources.write( id_key(src), num_sources++ );
+			last_src = src;
+		}
+		if( src < dst ) reverses.add( edge_key(dst, src), 0 );
 	}
+	cout << num_edges - num_unique << " duplicate edges removed" << endl;
+	cout << num_self_loops << " self loops removed" << endl;
+	cout << edges.get_size() << " edges converted to adjlist" << endl;
 
-	outstream.close();
+	/*
+		merge the edges with the reverses, keeping an edge (u,v)
+		with u > v only if (v,u) does not exist, and sorting the
+		first position of each kept edge's target
+	*/
+	SpillFile kept;
+	ExternalSorter targets( tmp + ".tgt", budget / 2, num_threads, true );
+	if( !kept.create( tmp + ".kept", io_buffer ) ) return -1;
+	reverses.finish();
+	edges.rewind( io_buffer );
+	uint64_t rev_key = 0, num_reverse_edges_removed = 0;
+	bool has_rev = reverses.next(rev_key, val);
+	while( edges.read(key, val) ) {
+		if( key_src(key) > key_dst(key) ) {
+			while( has_rev && rev_key < key ) has_rev = reverses.next(rev_key, val);
+			if( has_rev && rev_key == key ) {
+				num_reverse_edges_removed++;
+				continue;
+			}
+		}
+		targets.add( id_key( key_dst(key) ), kept.get_size() );
+		kept.write( key, 0 );
+	}
+	cout << num_reverse_edges_removed << " reverse edges removed" << endl;
+	cout << num_sources << " rows of adjlist sorted" << endl;
+	cout << num_sources << " verts in new adjlist" << endl;
 
-}
+	/*
+		label the sources by rank, and the other targets after
+		them in order of first appearance: merge the targets with
+		the sources to find the others, sort them by position,
+		and spill their (id, label) pairs sorted by id
+	*/
+	ExternalSorter order( tmp + ".ord", budget / 2, num_threads );
+	targets.finish();
+	sources.rewind( io_buffer );
+	uint64_t src_key = 0, src_label = 0;
+	bool has_src = sources.read(src_key, src_label);
+	while( targets.next(key, val) ) {
+		while( has_src && src_key < key ) has_src = sources.read(src_key, src_label);
+		if( has_src && src_key == key ) continue;
+		order.add( val, key );
+	}
+	order.finish();
+
+	SpillFile ids;
+	if( csr ) {
+		if( !ids.create( tmp + ".ids", io_buffer ) ) return -1;
+		sources.rewind( io_buffer );
+		while( sources.read(key, val) )
+			ids.write( key_id(key), 0 );
+	}
+	ExternalSorter labels( tmp + ".lab", budget / 2, num_threads );
+	uint64_t num_verts = num_sources;
+	while( order.next(val, key) ) {
+		labels.add( key, num_verts++ );
+		if( csr ) ids.write( key_id(key), 0 );
+	}
+	labels.finish();
+	cout << "relabeled " << num_sources + kept.get_size() << " verts" << endl;
+	cout << kept.get_size() << " edges coverted to edgelist" << endl;
+
+	/* relabel the sources of the kept edges, sorted by source */
+	ExternalSorter by_target( tmp + ".dst", budget / 2, num_threads );
+	kept.rewind( io_buffer );
+	sources.rewind( io_buffer );
+	has_src = sources.read(src_key, src_label);
+	while( kept.read(key, val) ) {
+		uint64_t k = id_key( key_src(key) );
+		while( src_key < k ) sources.read(src_key, src_label);
+		by_target.add( id_key( key_dst(key) ), src_label );
+	}
+	by_target.finish();
+
+	/*
+		relabel the targets by merging with the id map, the
+		sources and the labeled targets both sorted by id, and
+		sort the relabeled edges in both directions, weighted
+		in order of the sorted relabeled edges
+	*/
+	ExternalSorter out( tmp + ".out", budget / 2, num_threads );
+	ExternalSorter forward( tmp + ".fwd", budget / 2, num_threads );
+	vector<int> degrees( csr ? num_verts : 0, 0 );
+	sources.rewind( io_buffer );
+	has_src = sources.read(src_key, src_label);
+	uint64_t lab_key = 0, lab_label = 0;
+	bool has_lab = labels.next(lab_key, lab_label);
+	while( by_target.next(key, val) ) {
+		while( has_src && src_key < key ) has_src = sources.read(src_key, src_label);
+		while( has_lab && lab_key < key ) has_lab = labels.next(lab_key, lab_label);
+		uint64_t ls = val;
+		uint64_t ld = ( has_src && src_key == key ) ? src_label : lab_label;
+		if( csr ) {
+			degrees[ls]++;
+			degrees[ld]++;
+		}
+		if( weighted ) {
+			forward.add( (ls << 32) | ld, 0 );
+		} else {
+			out.add( (ls << 32) | ld, 0 );
+			out.add( (ld << 32) | ls, 0 );
+		}
+	}
+	if( weighted ) {
+		forward.finish();
+		srand( (unsigned)time(NULL) );
+		while( forward.next(key, val) ) {
+			int weight = rand() % 100;
+			out.add( key, weight );
+			out.add( (key << 32) | (key >> 32), weight );
+		}
+		cout << kept.get_size() << " edges added, " << 2*kept.get_size() << " total weighted edges" << endl;
+	}
+	out.finish();
 
+	if( csr ) {
+		if( !write_csr_image_external( out, degrees, 2*kept.get_size(), weighted, ids, outfile, tmp, io_buffer ) ) return -1;
+		return 0;
+	}
+
+	/* write the edges through a background writer */
+	BufferedWriter writer;
+	if( !writer.open(outfile, true, io_buffer) ) {
+		cout << "error: cannot open " << outfile << endl;
+		return -1;
+	}
+	while( out.next(key, val) ) {
+		writer.put_int( (int)(key >> 32) );
+		writer.put('\t');
+		writer.put_int( (int)(uint32_t)key );
+		if( weighted ) {
+			writer.put('\t');
+			writer.put_int( (int)val );
+		}
+		writer.put('\n');
+	}
+	writer.close();
+
+	return 0;
+}